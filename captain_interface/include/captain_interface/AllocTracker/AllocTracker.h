@@ -0,0 +1,43 @@
+/*------------------------------------------------------------------------------------
+	Heap allocation counting per captain message ID
+------------------------------------------------------------------------------------*/
+
+#ifndef AllocTracker_h
+#define AllocTracker_h
+
+#include <stdint.h>
+#include <atomic>
+
+// Global operator new is replaced in AllocHooks.cpp, which only the interface
+// executable links. When tracking is enabled, allocations made inside an
+// AllocScope are counted against its ID. Outside a scope, or with tracking
+// disabled, the cost is a call and one thread local compare.
+
+#define ALLOC_SCOPE_NONE     -1
+#define ALLOC_SCOPE_PUBLISH  256   // roscpp serialization, not part of decoding
+
+struct AllocCounters {
+  std::atomic<uint32_t> decode[256];   // per message ID
+  std::atomic<uint32_t> publish;
+};
+
+extern AllocCounters alloc_counters;
+
+void alloc_tracking_enable(bool enable);
+bool alloc_tracking_enabled();
+void alloc_counters_reset();
+
+//Nothing is counted unless AllocHooks.cpp is linked into the executable
+bool alloc_hooks_installed();
+void alloc_hooks_register();
+void alloc_count();                    // from the hooks, one allocation
+
+//Attributes allocations on this thread to id until destroyed. Scopes nest
+class AllocScope {
+  int previous;
+public:
+  AllocScope(int id);
+  ~AllocScope();
+};
+
+#endif
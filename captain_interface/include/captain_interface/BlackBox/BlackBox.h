@@ -0,0 +1,108 @@
+/*------------------------------------------------------------------------------------
+	Black box: the last seconds of captain link traffic, dumped on events
+------------------------------------------------------------------------------------*/
+
+#ifndef BlackBox_h
+#define BlackBox_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+// Received and sent payloads are written to a preallocated ring from any thread
+// without locks: a slot is claimed with one atomic increment, then the payload
+// is copied. Every slot has a sequence number like Seqlock, so a dump taken
+// while writers continue skips slots that were being overwritten.
+//
+// trigger() dumps the records of the last `seconds` to
+// <dir>/captain_blackbox_<time>_<reason>.csv, after waiting `post_trigger` so
+// the reaction to the event is included. Triggers within `seconds` of the
+// previous dump are ignored, dump() always writes.
+
+#define BLACKBOX_RX  0
+#define BLACKBOX_TX  1
+
+struct BlackBoxRecord {
+  uint64_t time_ns;           // CLOCK_REALTIME
+  uint8_t  dir;               // BLACKBOX_RX or BLACKBOX_TX
+  uint8_t  msgID;
+  uint8_t  len;               // payload bytes
+  char     payload[250];      // largest payload of a 255 byte XOR frame
+};
+
+struct BlackBoxStats {
+  uint64_t recorded;
+  uint32_t dumps;
+  uint32_t suppressed;        // triggers ignored, too soon after a dump
+  std::string last_dump;      // path of the latest file
+};
+
+//----------------------------------------------------------------
+class BlackBox {
+  struct Slot {
+    std::atomic<uint64_t> seq;      // 2*index+1 while writing, 2*index+2 when done
+    BlackBoxRecord record;
+  };
+
+  std::unique_ptr<Slot[]> slots;    // allocated once in configure()
+  size_t n_slots = 0;
+  std::vector<BlackBoxRecord> snapshot;
+  std::atomic<uint64_t> head;       // next index to write
+
+  std::string dir;
+  double seconds = 10;
+  double post_trigger = 1.0;
+
+  //Checksum error burst detection
+  std::mutex error_mutex;
+  uint32_t burst_errors = 10;
+  double burst_window = 1.0;        // s
+  uint64_t error_window_start = 0;
+  uint32_t error_count = 0;
+
+  //Dump thread
+  std::mutex mutex;
+  std::mutex dump_mutex;            // one dump at a time, owns snapshot
+  std::condition_variable cv;
+  std::thread dump_thread;
+  bool stopped = true;
+  std::string pending;              // reason of a triggered dump, empty if none
+  uint64_t last_dump_ns = 0;
+  BlackBoxStats counters;
+
+  void run();
+
+public:
+  BlackBox();
+  ~BlackBox() {stop();};
+
+  //Must be called before start(). frames = 0 disables recording
+  void configure(size_t frames, double seconds, double post_trigger, const std::string& dir);
+  void setErrorBurst(uint32_t errors, double window_s) {burst_errors = errors; burst_window = window_s;}
+
+  void start();
+  void stop();
+  bool isActive() {return n_slots > 0;}
+
+  //Called from the I/O path, one copy of the payload
+  void record(uint8_t direction, uint8_t msgID, const char* payload, uint8_t len, uint64_t time_ns);
+  void record_frame(uint8_t direction, const char* frame, uint8_t len, bool crc, uint64_t time_ns);   // complete frame, crc: CRC32C trailer
+
+  //Counts a checksum error and triggers on a burst
+  void checksum_error();
+
+  //Dump from the dump thread after post_trigger
+  void trigger(const char* reason);
+
+  //Dump now, returns the path or "" on failure
+  std::string dump(const char* reason);
+
+  BlackBoxStats stats();
+};
+//----------------------------------------------------------------
+#endif
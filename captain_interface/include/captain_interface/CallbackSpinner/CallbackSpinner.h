@@ -0,0 +1,80 @@
+/*------------------------------------------------------------------------------------
+	ROS callback queue drained by a dedicated thread
+------------------------------------------------------------------------------------*/
+
+#ifndef CallbackSpinner_h
+#define CallbackSpinner_h
+
+#include "ros/ros.h"
+#include <ros/callback_queue.h>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+struct CallbackQueueStats {
+  uint32_t callbacks;         // Callbacks since the previous stats() call
+  double   delay_avg_ms;      // Time a new callback waits in the queue, from the probes
+  double   delay_max_ms;
+  double   callback_max_ms;   // Longest single callback
+};
+
+//----------------------------------------------------------------
+class CallbackSpinner {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+private:
+  //Empty callback queued at a fixed interval to measure the queueing delay
+  class Probe : public ros::CallbackInterface {
+    CallbackSpinner* spinner;
+  public:
+    Probe(CallbackSpinner* s) : spinner(s) {};
+    CallResult call() {spinner->probe_called(); return Success;};
+  };
+
+  std::string name;
+  ros::CallbackQueue queue;
+  ros::CallbackInterfacePtr probe;
+  Clock::time_point probe_sent;
+  bool probe_pending = false;
+  double probe_interval = 0.1;  // s
+
+  int cpu = -1;                 // -1 = no affinity
+  int priority = 0;             // SCHED_FIFO priority, 0 = normal scheduling
+
+  std::thread spin_thread;
+  std::atomic<bool> running;
+
+  //Statistics since the previous stats() call
+  std::mutex stats_mutex;
+  uint32_t callbacks = 0;
+  uint32_t probes = 0;
+  double delay_sum_ms = 0;
+  double delay_max_ms = 0;
+  double callback_max_ms = 0;
+
+  void run();
+  void apply_thread_profile();
+  void probe_called();
+
+public:
+  CallbackSpinner(const std::string& name);
+  ~CallbackSpinner() {stop();};
+
+  ros::CallbackQueue* getQueue() {return &queue;};
+  const std::string& getName() {return name;};
+
+  //Must be set before start()
+  void setAffinity(int _cpu) {cpu = _cpu;};
+  void setPriority(int _priority) {priority = _priority;};
+
+  void start();
+  void stop();
+
+  //Current counters. Resets the window
+  CallbackQueueStats stats();
+};
+//----------------------------------------------------------------
+#endif
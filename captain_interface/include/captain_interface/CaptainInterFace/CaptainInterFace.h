@@ -7,51 +7,111 @@
 #include <stdint.h>
 #include "../CircleBuffer.h"
 #include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
 
 typedef union { char bytes[4]; long  mylong;  } conversionLong;    // Used for conversion
 typedef union { char bytes[2]; int   myInt;   } conversionInt;     // Used for conversion
 typedef union { char bytes[4]; float myFloat; } conversionFloat;   // Used for conversion
 
+class TxScheduler;
+class BlackBox;
+struct LinkProfile;
+
+//Link counters. Updated for every package, also the ones nobody subscribes to
+struct LinkCounters {
+  std::atomic<uint32_t> received[256];     //Valid packages per message ID
+  std::atomic<uint32_t> checksum_errors;
+  std::atomic<uint32_t> sent;
+};
+
 //----------------------------------------------------------------
 class CaptainInterFace {
 
-  conversionLong     myUnionLong;                       // Help variable for bytes-long conversion
-  conversionInt      myUnionInt;                        // Help variable for bytes-inte conversion
-  conversionFloat    myUnionFloat;                      // Help variable for bytes-float conversion
-
   //buffers
-  char send_buffer[255] = {0};                    //Buffer for outgoing data
-  char* send_ptr = send_buffer;
+  //Outgoing package, one per thread so ROS callbacks on different spinner threads can build packages at the same time
+  static thread_local char send_buffer[255];
+  static thread_local uint8_t send_len;
   CircleBuffer receive_buffer;                    //Buffer for incoming data
   uint8_t unpack_index;
+  uint8_t package_length = 0;                     //Length of the current incoming package
+  uint8_t package_trailer = 1;                    //Checksum bytes of the current incoming package
+
+  std::mutex send_mutex;                          //Serializes send_data between threads
+  TxScheduler* scheduler = NULL;                  //Optional priority queue for outgoing packages
+  BlackBox* blackbox = NULL;                      //Optional recorder of sent frames and checksum errors
 
   bool package_available = false;
   bool waitForCS = false;
 
+  //Link integrity mode, negotiated with the hello package
+  uint8_t link_capabilities = 0;                  //LINK_CAP_* requested by us
+  std::atomic<bool> crc_mode;                     //CRC32C trailer instead of XOR checksum
+
   //Parse data from incoming buffer and call callback function if needed
-  bool parse_package();
-  uint8_t calc_checksum(char* buffer, uint8_t len);
+  bool parse_package(uint8_t trailer);
+  void parse_hello();
+  static uint8_t calc_checksum(const char* buffer, uint8_t len);
 
   //msg ID
   uint8_t msgID = 255;
 
+  uint64_t rx_time_ns = 0;                        //Host receive time of the current data
+
 protected:
   //called when data is received from hardware layer
   bool parse_data(char c);
 
+  //called for every valid package. Handles the hello and runs the callback.
+  //Returns true if the package has been consumed
+  virtual bool package_received();
+
   //send data. Implemented on the hardware_layer
   virtual bool send_data(char* buf, uint8_t len) = 0;
 
+  //set by the hardware layer before parse_data, CLOCK_REALTIME [ns]
+  void setReceiveTime(uint64_t ns) {rx_time_ns = ns;}
+
 public:
   CaptainInterFace();
+  virtual ~CaptainInterFace() {};
+
+  LinkCounters counters;
 
   void (*cb)() = NULL;
   void setCallback(void (*f)()) {cb = f;}
 
   bool send_package();
   void new_package(uint8_t msgID);
+  bool send_payload(uint8_t msgID, const char* data, uint8_t len);   // frame and send in one call, thread safe
+  bool send_frame(char* frame, uint8_t len);                         // send a complete frame now, bypassing the scheduler
+
+  void setScheduler(TxScheduler* s) {scheduler = s;}
+  void setBlackBox(BlackBox* b) {blackbox = b;}
+  BlackBox* blackBox() {return blackbox;}
+
+  //Apply socket options and the I/O thread profile of the hardware layer, one report line per socket and thread
+  virtual void applyLinkProfile(const LinkProfile&, std::vector<std::string>&) {};
+
+  //Hello package. Lets the captain know our address and offers LINK_CAP_* options.
+  //Always sent with the XOR checksum so a restarted captain can read it
+  bool send_hello();
+  void setCapabilities(uint8_t capabilities) {link_capabilities = capabilities;}
+  uint8_t capabilities() {return link_capabilities;}
+  bool crcMode() {return crc_mode;}
+
+  static bool validate_frame(const char* frame, uint8_t len);       // check start byte, length and checksum
+  static uint8_t finish_frame(char* buffer, uint8_t len, bool crc); // add length, '*' and checksum after '#', ID and payload
+
+  //Feed received bytes as if they came from the hardware layer. Used for replay and self tests
+  bool inject(const char* data, size_t len);
 
   uint8_t       messageID() {return msgID;};
+  uint64_t      receiveTime() {return rx_time_ns;};  // of the incoming package, 0 if unknown
+  static bool   has_sequence_header(uint8_t id);   // payload starts with timestamp (8 bytes) and sequence (4 bytes)
+  uint8_t       copy_package(char* out);           // copy payload of incoming package, returns length
+  uint8_t       copy_frame(char* out);             // copy complete incoming frame with XOR checksum, returns length
 
   void          add_byte(uint8_t b);               //
   void          add_string(std::string s);         //
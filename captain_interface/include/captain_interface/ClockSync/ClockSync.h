@@ -0,0 +1,92 @@
+/*------------------------------------------------------------------------------------
+	Captain clock offset and skew, estimated from one-way timestamps
+------------------------------------------------------------------------------------*/
+
+#ifndef ClockSync_h
+#define ClockSync_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <mutex>
+
+// Every sequenced captain frame carries the captain time it was sampled at. The
+// host receive time minus that is offset + delay. Only one-way timestamps are
+// available, so the minimum per window is taken as offset + minimum delay, and a
+// line through the recent minima gives offset and skew. The assumed minimum
+// delay (configure) is subtracted from the offset, the delay of a frame is its
+// distance above the line plus that minimum.
+
+//Host receive times are CLOCK_REALTIME in ns, the clock ros::Time::now() uses
+uint64_t realtime_ns();
+
+//Ask the kernel to timestamp received datagrams (SO_TIMESTAMPNS)
+bool enable_rx_timestamps(int fd);
+
+//recv() returning the kernel receive time, or the current time if the kernel did not add one
+ssize_t recv_timestamped(int fd, char* buf, size_t len, uint64_t& rx_ns);
+
+struct ClockOffsetStatus {
+  bool     valid;             // at least one window complete
+  double   offset_s;          // host - captain, at the latest sample
+  double   skew_ppm;          // > 0: host clock runs faster
+  double   delay_avg_ms;      // one-way delay since the previous status() call
+  double   delay_min_ms;
+  double   delay_max_ms;
+  uint32_t samples;           // since the previous status() call
+  uint32_t resets;            // clock steps, e.g. captain restarts
+};
+
+//----------------------------------------------------------------
+class ClockOffsetEstimator {
+  struct Minimum {
+    double t;                 // host time [s] since base
+    double d;                 // receive - captain time [s] relative to base
+  };
+
+  double window = 1.0;        // s
+  int    n_windows = 32;      // minima in the fit
+  double min_delay = 0;       // s, assumed floor of the one-way delay
+  double step = 0.01;         // s below the line, or 1 s above it, is a clock step
+
+  std::mutex mutex;
+  bool     started = false;
+  int64_t  base_host_ns;      // host time of the first sample
+  int64_t  base_offset_ns;    // receive - captain time of the first sample
+
+  Minimum  minima[64];
+  int      minima_count = 0;
+  int      minima_next = 0;
+  Minimum  current;           // minimum of the open window
+  double   window_start;
+  double   last_t;            // latest sample
+  bool     fitted = false;
+  double   fit_t, fit_d, fit_skew;   // d = fit_d + fit_skew * (t - fit_t)
+
+  int      outliers = 0;      // consecutive samples far off the line
+  ClockOffsetStatus stats;
+  double   delay_sum = 0;
+
+  void reset(int64_t host_ns, int64_t d_ns);
+  void fit();
+  double predict(double t) {return fit_d + fit_skew * (t - fit_t);}
+
+public:
+  ClockOffsetEstimator();
+
+  void configure(double window_s, int windows, double min_delay_s);
+
+  //Captain sample time and host receive time of one frame
+  void add(uint64_t captain_us, uint64_t host_ns);
+
+  //Captain time in host time [ns], false until the first window is complete
+  bool toHost(uint64_t captain_us, uint64_t& host_ns);
+
+  //Current estimate. Resets the delay window
+  ClockOffsetStatus status();
+
+  //Clock steps so far, without touching the delay window
+  uint32_t resets() {std::lock_guard<std::mutex> lock(mutex); return stats.resets;}
+};
+//----------------------------------------------------------------
+#endif
@@ -0,0 +1,17 @@
+/*------------------------------------------------------------------------------------
+	CRC32C (Castagnoli) with SSE4.2 and software implementations
+------------------------------------------------------------------------------------*/
+
+#ifndef Crc32c_h
+#define Crc32c_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+//Uses the SSE4.2 crc32 instruction when the CPU has it, a table otherwise
+uint32_t crc32c(const void* data, size_t len, uint32_t crc = 0);
+
+uint32_t crc32c_sw(const void* data, size_t len, uint32_t crc = 0);
+bool     crc32c_hw_available();
+
+#endif
@@ -0,0 +1,69 @@
+/*------------------------------------------------------------------------------------
+	Raw frame relay: fan out captain frames to local processes
+------------------------------------------------------------------------------------*/
+
+#ifndef FrameRelay_h
+#define FrameRelay_h
+
+#include "../CaptainInterFace/CaptainInterFace.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <sys/socket.h>
+
+//----------------------------------------------------------------
+// Validated frames from the captain are forwarded unchanged to a set of
+// local UDP or Unix datagram sockets. Frames the subscribers send to the
+// uplink socket(s) are validated and sent to the captain, so several
+// scientist side processes can share the single captain link.
+class FrameRelay {
+  struct Target {
+    sockaddr_storage addr;
+    socklen_t addrlen;
+    bool     unix_socket;
+    uint64_t ids[4];          // Bitmask of forwarded message IDs
+  };
+  std::vector<Target> targets;
+
+  int udp_fd = -1;            // Used for sending to UDP targets
+  int unix_fd = -1;           // Used for sending to Unix targets
+  std::vector<struct mmsghdr> udp_msgs;
+  std::vector<struct mmsghdr> unix_msgs;
+  struct iovec iov;
+  void send_all(int fd, struct mmsghdr* msgs, unsigned int n);
+
+  //Uplink from subscribers to the captain
+  CaptainInterFace* captain = NULL;
+  int uplink_udp_fd = -1;
+  int uplink_unix_fd = -1;
+  std::string uplink_path;
+  std::thread uplink_thread;
+  volatile bool stopped = false;
+  void uplink();
+
+public:
+  ~FrameRelay() {stop();};
+
+  // "host:port" for UDP, an absolute path for a Unix datagram socket.
+  // Optionally followed by ";id,id,..." to only forward those message IDs
+  bool addTarget(const std::string& spec);
+
+  // Start listening for frames to the captain on a UDP port (0 = none)
+  // and/or a Unix datagram socket path (empty = none)
+  bool start(CaptainInterFace* captain, int uplink_port, const std::string& uplink_path);
+  void stop();
+
+  bool isActive() const {return !targets.empty() || uplink_thread.joinable();};
+
+  //Called from the receive thread with a complete validated frame
+  void forward(uint8_t msgID, char* frame, uint8_t len);
+
+  //Written by the receive and uplink threads, read by diagnostics
+  std::atomic<uint32_t> dropped{0};    // Frames that could not be sent to a subscriber
+  std::atomic<uint32_t> uplinked{0};   // Frames sent to the captain
+  std::atomic<uint32_t> rejected{0};   // Frames from subscribers that failed validation
+};
+//----------------------------------------------------------------
+#endif
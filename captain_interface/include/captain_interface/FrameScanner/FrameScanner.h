@@ -0,0 +1,52 @@
+/*------------------------------------------------------------------------------------
+	Frame detection in a contiguous captain byte stream, e.g. a recorded dump
+------------------------------------------------------------------------------------*/
+
+#ifndef FrameScanner_h
+#define FrameScanner_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Same rules as CaptainInterFace::parse_data: a frame is found at its '*', the
+// byte before it is the total length and the first byte must be '#'. Both the
+// XOR and the CRC32C trailer are accepted, the mode is not negotiated offline.
+// A frame may not start before the end of the previous one, like the live
+// parser that clears its buffer after every package.
+
+struct ScannedFrame {
+  size_t  offset;        // of '#'
+  uint8_t length;        // total, including trailer
+  uint8_t trailer;       // 1 (XOR) or 4 (CRC32C)
+};
+
+struct FrameScanStats {
+  uint64_t frames;
+  uint64_t crc_frames;
+  uint64_t checksum_errors;   // start and length matched, checksum did not
+  uint64_t frame_bytes;
+  uint64_t per_id[256];
+};
+
+class FrameScanner {
+  const char* data;
+  size_t size;
+  size_t pos;          // next byte to look at for '*'
+  size_t floor;        // frames may not start before this
+  size_t end;          // frames must end at or before this
+
+  bool check(size_t star, uint8_t trailer, ScannedFrame& frame, bool& checksum_error);
+
+public:
+  //Finds frames inside [from, to)
+  FrameScanner(const char* _data, size_t _size, size_t from, size_t to);
+
+  //Next frame, false at the end of the range
+  bool next(ScannedFrame& frame, FrameScanStats& stats);
+
+  //End of the first frame ending at or after offset, size if none. Used to split a
+  //stream into chunks that can be scanned independently
+  static size_t boundary(const char* data, size_t size, size_t offset);
+};
+
+#endif
@@ -0,0 +1,42 @@
+/*------------------------------------------------------------------------------------
+	In-process UTM <-> lat/lon conversion (WGS84, Krueger series)
+------------------------------------------------------------------------------------*/
+
+#ifndef Geodesy_h
+#define Geodesy_h
+
+#include <stddef.h>
+
+//----------------------------------------------------------------
+// Converts between UTM coordinates in a fixed zone and geographic
+// coordinates in degrees. All zone dependent constants are computed
+// once in setZone() so a conversion is only a handful of trig calls.
+class UTMConverter {
+  int    zone;
+  bool   northern;
+  double lon0;              // Central meridian [rad]
+  double false_northing;    // 0 on the northern hemisphere, 10000 km on the southern
+
+  double k0A;               // Scale factor times rectifying radius
+  double ecc_n;             // 2*sqrt(n)/(1+n), used for conformal latitude
+  double alpha[3];          // Forward series coefficients
+  double beta[3];           // Inverse series coefficients
+  double delta[3];          // Conformal -> geodetic latitude coefficients
+
+public:
+  UTMConverter(int zone = 34, char band = 'V');
+
+  void setZone(int zone, char band);
+  int  getZone() const {return zone;};
+  bool isNorthern() const {return northern;};
+
+  //Single point conversion. lat/lon in degrees, easting/northing in meters
+  void toLatLon(double easting, double northing, double& lat, double& lon) const;
+  void toUTM(double lat, double lon, double& easting, double& northing) const;
+
+  //Batch conversion of point arrays
+  void toLatLon(const double* easting, const double* northing, double* lat, double* lon, size_t n) const;
+  void toUTM(const double* lat, const double* lon, double* easting, double* northing, size_t n) const;
+};
+//----------------------------------------------------------------
+#endif
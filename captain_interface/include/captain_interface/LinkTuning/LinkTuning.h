@@ -0,0 +1,43 @@
+/*------------------------------------------------------------------------------------
+	Socket and thread profile of the captain link
+------------------------------------------------------------------------------------*/
+
+#ifndef LinkTuning_h
+#define LinkTuning_h
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+// Kernel defaults are tuned for throughput. For a predictable feedback latency
+// on a loaded computer the link sockets get larger buffers, busy polling and a
+// DSCP / SO_PRIORITY mark, and the I/O threads (readers, receive lanes and the
+// transmit scheduler) run SCHED_FIFO, optionally on their own core, with memory
+// locked. Their priority stays below the kernel IRQ threads, which otherwise
+// could not deliver the packets the readers wait for.
+//
+// Settings that need privileges (CAP_NET_ADMIN for buffers above rmem_max and
+// busy polling, CAP_SYS_NICE or an rtprio limit for SCHED_FIFO, a memlock limit
+// for mlockall) may fail. Each call returns a line for the startup report with
+// the values read back from the kernel, so the report shows what was applied.
+
+struct LinkProfile {
+  int  rcvbuf = 0;              // bytes, 0 = kernel default
+  int  sndbuf = 0;
+  int  busy_poll_us = 0;        // SO_BUSY_POLL, 0 = off
+  int  dscp = -1;               // IP_TOS = dscp << 2, e.g. 46 (EF), -1 = unchanged
+  int  socket_priority = -1;    // SO_PRIORITY 0..6 (higher with CAP_NET_ADMIN), -1 = unchanged
+  bool rx_timestamps = true;    // SO_TIMESTAMPNS
+  int  thread_priority = 0;     // SCHED_FIFO 1..99, 0 = normal scheduling
+  int  thread_cpu = -1;         // pin the I/O threads, -1 = any
+  bool lock_memory = false;     // mlockall(MCL_CURRENT | MCL_FUTURE)
+
+  //Preset: "default" leaves everything to the kernel, "low_latency" sets all of the above but the cpu
+  static LinkProfile preset(const std::string& name, bool* known = NULL);
+};
+
+std::string tune_socket(int fd, const std::string& name, const LinkProfile& profile);
+std::string tune_thread(pthread_t thread, const std::string& name, const LinkProfile& profile);
+std::string tune_memory(const LinkProfile& profile);
+
+#endif
@@ -0,0 +1,74 @@
+/*------------------------------------------------------------------------------------
+	Asynchronous, rate limited logging for the I/O threads
+------------------------------------------------------------------------------------*/
+
+#ifndef Log_h
+#define Log_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+
+// CLOG_INFO / CLOG_WARN / CLOG_ERROR format into a preallocated ring and return,
+// a background thread writes the lines to the sink (stdout/stderr, or rosconsole
+// in the node). Writers never block: a full ring drops the message and counts it.
+//
+// Every call site has its own counter and allows at most `limit` messages per
+// second (CLOG, or log_set_rate_limit for the others). Suppressed messages are
+// counted per site and reported with the next message of that site, or by the
+// flusher once the site goes quiet.
+//
+// Before log_start() messages are written synchronously, so tools linking
+// captain_protocol need no setup.
+
+#define LOG_RING_SIZE  1024     // messages, power of two
+#define LOG_LINE_SIZE  256      // bytes per message including the terminator
+
+enum LogLevel {LOG_LEVEL_INFO, LOG_LEVEL_WARN, LOG_LEVEL_ERROR};
+
+struct LogSite {
+  const char* file;
+  int         line;
+  uint32_t    limit;                          // messages per second, 0 = default
+  std::atomic<uint64_t> window_start_ns;
+  std::atomic<uint32_t> window_count;
+  std::atomic<uint32_t> suppressed;           // not reported yet
+  std::atomic<uint64_t> suppressed_total;
+  std::atomic<bool>     registered;
+  LogSite*    next;                           // list of sites that logged
+
+  LogSite(const char* _file, int _line, uint32_t _limit) : file(_file), line(_line), limit(_limit),
+    window_start_ns(0), window_count(0), suppressed(0), suppressed_total(0), registered(false), next(NULL) {}
+};
+
+struct LogStats {
+  uint64_t written;
+  uint64_t dropped;           // ring full
+  uint64_t suppressed;        // over the rate limit of their site
+};
+
+typedef std::function<void(LogLevel level, const char* text)> LogSink;
+
+void log_write(LogSite& site, LogLevel level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+//Flusher thread. log_stop() writes what is still queued
+void log_start(int flush_ms = 10);
+void log_stop();
+
+//Set before log_start()
+void log_set_sink(LogSink sink);
+void log_set_rate_limit(uint32_t per_second);
+
+LogStats log_stats();
+
+//Sites that suppressed messages, with their totals
+void log_for_each_site(const std::function<void(const LogSite& site)>& f);
+
+//----------------------------------------------------------------
+#define CLOG(level, limit, ...) do { static LogSite log_site_(__FILE__, __LINE__, limit); log_write(log_site_, level, __VA_ARGS__); } while(0)
+#define CLOG_INFO(...)  CLOG(LOG_LEVEL_INFO, 0, __VA_ARGS__)
+#define CLOG_WARN(...)  CLOG(LOG_LEVEL_WARN, 0, __VA_ARGS__)
+#define CLOG_ERROR(...) CLOG(LOG_LEVEL_ERROR, 0, __VA_ARGS__)
+
+#endif
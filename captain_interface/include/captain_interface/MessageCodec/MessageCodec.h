@@ -0,0 +1,180 @@
+/*------------------------------------------------------------------------------------
+	Message codec: payload layouts of the captain -> scientist messages
+------------------------------------------------------------------------------------*/
+
+#ifndef MessageCodec_h
+#define MessageCodec_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+
+// The single description of every fixed size payload. Each layout lists the
+// fields in link order with their type and their offset in the decoded struct,
+// so the ROS callbacks (decode_*), captain_decode and the telemetry store all
+// read the same table. A layout change is made here and nowhere else.
+//
+// Layouts marked unconfirmed are not in scientistmsg.h and were taken from the
+// stand-in captain; they still need to be checked against the captain firmware.
+
+#define MESSAGE_MAX_FIELDS 16
+
+//Field types, in the byte order used by CaptainInterFace::parse_*
+enum MessageFieldType {
+  FIELD_BYTE = 0,   // parse_byte, uint8_t
+  FIELD_INT,        // parse_int, 2 bytes, uint16_t
+  FIELD_LONG,       // parse_long, 4 bytes, uint32_t
+  FIELD_LLONG,      // parse_llong, 8 bytes, most significant long first, uint64_t
+  FIELD_FLOAT,      // parse_float
+  FIELD_DOUBLE      // parse_double
+};
+
+struct MessageField {
+  const char*      name;
+  MessageFieldType type;
+  uint16_t         offset;        // in the decoded struct
+};
+
+struct MessageLayout {
+  uint8_t      msgID;
+  const char*  name;
+  uint16_t     struct_size;       // sizeof the decoded struct
+  uint8_t      n_fields;
+  MessageField fields[MESSAGE_MAX_FIELDS];
+};
+
+//----------------------------------------------------------------
+//Decoded messages. Angles and lat/lon as sent by the captain, in radians
+
+//CS_RUDDER, CS_ELEVATOR, CS_ELEVON_PORT, CS_ELEVON_STRB
+struct SurfaceMessage {
+  uint64_t timestamp;             // captain time [us]
+  uint32_t sequence;
+  float    target_angle;
+  float    angle;
+};
+
+//CS_THRUSTER_PORT, CS_THRUSTER_STRB
+struct ThrusterMessage {
+  uint64_t timestamp;
+  uint32_t sequence;
+  float    rpm_setpoint;
+  float    rpm;
+  float    current;
+  float    torque;
+  float    energy;
+  float    voltage;
+};
+
+//CS_IMU, unconfirmed
+struct ImuMessage {
+  uint64_t timestamp;
+  uint32_t sequence;
+  float    roll, pitch, yaw;                    // [rad]
+  float    roll_rate, pitch_rate, yaw_rate;     // [rad/s]
+};
+
+//CS_POSITION, unconfirmed
+struct PositionMessage {
+  uint64_t timestamp;
+  uint32_t sequence;
+  double   latitude, longitude;                 // [rad]
+  float    depth, altitude;                     // [m]
+};
+
+//CS_STATUS, unconfirmed. Follows lolo_msgs/CaptainStatus
+struct StatusMessage {
+  uint64_t timestamp;
+  uint32_t sequence;
+  uint8_t  active_control_input;
+  double   target_latitude, target_longitude;   // [rad]
+  float    target_yaw, target_pitch, target_speed, target_rpm, target_depth, target_altitude;
+};
+
+//CS_CTRL_STATUS, one byte per controller in VehicleState's CONTROLLER_* order
+#define MESSAGE_N_CONTROLLERS 13
+struct CtrlStatusMessage {
+  uint8_t  enabled[MESSAGE_N_CONTROLLERS];
+};
+
+//CS_REQUEST_OUT, reply to an SC_REQUEST_IN service call
+struct ServiceMessage {
+  uint16_t ref;
+  uint8_t  reply;
+};
+
+//----------------------------------------------------------------
+//Size of a field on the link and in the decoded struct
+inline uint8_t message_field_size(MessageFieldType type) {
+  switch(type) {
+    case FIELD_BYTE:   return 1;
+    case FIELD_INT:    return 2;
+    case FIELD_LONG:   return 4;
+    case FIELD_LLONG:  return 8;
+    case FIELD_FLOAT:  return 4;
+    case FIELD_DOUBLE: return 8;
+  }
+  return 0;
+}
+
+//Field as sent by the captain to native byte order. LLONG is sent most significant long first
+inline void message_field_native(MessageFieldType type, const char* link, char* native) {
+  if(type == FIELD_LLONG) {
+    uint32_t msb, lsb;
+    memcpy(&msb, link, 4);
+    memcpy(&lsb, link+4, 4);
+    uint64_t v = (((uint64_t) msb) << 32) + lsb;
+    memcpy(native, &v, 8);
+  }
+  else memcpy(native, link, message_field_size(type));
+}
+
+//Value of a field stored in native byte order
+inline double message_field_value(MessageFieldType type, const char* p) {
+  switch(type) {
+    case FIELD_BYTE:   return (uint8_t) p[0];
+    case FIELD_INT:    {uint16_t v; memcpy(&v, p, 2); return v;}
+    case FIELD_LONG:   {uint32_t v; memcpy(&v, p, 4); return v;}
+    case FIELD_LLONG:  {uint64_t v; memcpy(&v, p, 8); return (double) v;}
+    case FIELD_FLOAT:  {float v;    memcpy(&v, p, 4); return v;}
+    case FIELD_DOUBLE: {double v;   memcpy(&v, p, 8); return v;}
+  }
+  return 0;
+}
+
+//Bytes of a message on the link
+inline int message_size(const MessageLayout* layout) {
+  int size = 0;
+  for(int i=0;i<layout->n_fields;i++) size += message_field_size(layout->fields[i].type);
+  return size;
+}
+
+//Layout of a message ID, NULL for variable length (text) or unknown messages
+const MessageLayout* message_layout(uint8_t msgID);
+
+//Layout by name, e.g. "thruster_port". NULL if unknown
+const MessageLayout* message_layout(const char* name);
+
+//All layouts
+const MessageLayout* message_layouts(int& count);
+
+//Fill out (layout->struct_size bytes) from a payload. False, with out
+//untouched, if the payload is shorter than the layout
+bool message_decode(const MessageLayout* layout, const char* payload, uint8_t len, void* out);
+
+//Typed decoding for the callbacks. False if msgID has a different layout or the payload is short
+bool decode_surface(uint8_t msgID, const char* payload, uint8_t len, SurfaceMessage& m);
+bool decode_thruster(uint8_t msgID, const char* payload, uint8_t len, ThrusterMessage& m);
+bool decode_imu(const char* payload, uint8_t len, ImuMessage& m);
+bool decode_position(const char* payload, uint8_t len, PositionMessage& m);
+bool decode_status(const char* payload, uint8_t len, StatusMessage& m);
+bool decode_ctrl_status(const char* payload, uint8_t len, CtrlStatusMessage& m);
+bool decode_service(const char* payload, uint8_t len, ServiceMessage& m);
+
+//CS_TEXT, CS_MENUSTREAM, CS_MISSIONLOG, CS_DATALOG: length byte, then the text.
+//Cut to the payload if the length byte is larger
+bool is_text_message(uint8_t msgID);
+bool decode_text(const char* payload, uint8_t len, std::string& text);
+
+#endif
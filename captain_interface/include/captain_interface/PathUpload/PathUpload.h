@@ -0,0 +1,104 @@
+/*------------------------------------------------------------------------------------
+	Waypoint path upload to the captain with SC_SET_PATH
+------------------------------------------------------------------------------------*/
+
+#ifndef PathUpload_h
+#define PathUpload_h
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include <functional>
+
+// SC_SET_PATH payload:
+//   int    ref          acknowledged with CS_REQUEST_OUT (ref, SERVICE_ACTION_SUCCESS/FAIL)
+//   int    start        index of the first point in this frame
+//   int    total        number of points in the path, the captain truncates to this
+//   byte   n            points in this frame, 0 only truncates
+//   n x (double lat, double lon) [rad]
+//
+// ref = PATH_REF_FLAG | generation << 8 | chunk. Stream requests use STREAM_REF_FLAG,
+// other service requests refs below 0x4000.
+//
+// At most `window` frames are outstanding, the next one is sent when one is
+// acknowledged. SC_SET_PATH is bulk traffic and may wait for the transmit
+// scheduler's token bucket, so transmitted() restarts the timeout of a frame
+// when it actually goes out.
+
+#define PATH_POINTS_PER_FRAME 15
+#define PATH_REF_FLAG         0x8000
+#define PATH_MAX_CHUNKS       256
+#define PATH_MAX_POINTS       (PATH_MAX_CHUNKS * PATH_POINTS_PER_FRAME)
+
+struct PathPoint {
+  double latitude;    // deg
+  double longitude;   // deg
+  bool operator==(const PathPoint& p) const {return latitude == p.latitude && longitude == p.longitude;};
+};
+
+struct PathUploadStatus {
+  uint32_t points;        // points in the current path
+  uint32_t confirmed;     // leading points acknowledged by the captain
+  uint32_t pending;       // frames waiting for an acknowledgement
+  uint32_t failed;        // frames rejected or not acknowledged after all retries
+  uint32_t frames_sent;
+  uint32_t retransmits;
+};
+
+//----------------------------------------------------------------
+class PathUploader {
+public:
+  typedef std::function<bool(uint8_t, const char*, uint8_t)> SendFunction; // msgID, payload, length
+  typedef std::chrono::steady_clock Clock;
+
+private:
+  struct Chunk {
+    uint16_t ref;
+    uint16_t start;
+    uint8_t  n;
+    int      retries;
+    bool     queued;          // handed to send() at least once
+    Clock::time_point sent;
+  };
+
+  SendFunction send;
+  std::mutex mutex;
+
+  std::vector<PathPoint> path;
+  std::vector<bool> acked;        // per point, captain has confirmed it
+  std::vector<Chunk> chunks;      // waiting for an acknowledgement
+  uint8_t generation = 0;
+
+  double timeout = 0.5;           // s after transmission before a frame is sent again
+  int max_retries = 3;
+  size_t window = 4;              // frames waiting for an acknowledgement
+  PathUploadStatus counters;
+
+  void send_chunk(Chunk& chunk);
+  void fill_window();
+
+public:
+  PathUploader(SendFunction send);
+
+  void setRetry(double timeout_s, int retries) {timeout = timeout_s; max_retries = retries;};
+  void setWindow(size_t frames) {window = std::max((size_t) 1, frames);};
+
+  //New or changed path. Only the points after the longest confirmed common
+  //prefix are sent. Returns false if the path is too long
+  bool upload(const std::vector<PathPoint>& points);
+
+  //An SC_SET_PATH payload left the transmit scheduler, starts its timeout
+  void transmitted(const char* payload, uint8_t len);
+
+  //Service reply from the captain. Returns false if ref is not a path upload
+  bool handle_ack(uint16_t ref, uint8_t reply);
+
+  //Send unacknowledged frames again, call periodically
+  void poll();
+
+  PathUploadStatus status();
+};
+//----------------------------------------------------------------
+#endif
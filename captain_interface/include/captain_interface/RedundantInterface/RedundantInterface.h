@@ -0,0 +1,128 @@
+/*------------------------------------------------------------------------------------
+	Captain scientist interface: redundant UDP paths
+------------------------------------------------------------------------------------*/
+
+#ifndef RedundantInterface_h
+#define RedundantInterface_h
+
+#include "../CaptainInterFace/CaptainInterFace.h"
+#include <boost/asio.hpp>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+// Every outgoing frame is sent on all paths. Incoming frames are parsed per path
+// and the first copy is passed on, later copies are dropped:
+//  - frames with a timestamp and sequence header (IMU, POSITION, STATUS, actuator
+//    feedback) are keyed on message ID and sequence, in a sliding window per ID
+//  - other frames are keyed on message ID and payload, and are only a duplicate
+//    if the same frame arrived on another path within REDUNDANT_MATCH_WINDOW
+
+#define REDUNDANT_MAX_PATHS       2
+#define REDUNDANT_SEQ_WINDOW      64       // sequences remembered per message ID
+#define REDUNDANT_SEQ_RESTART     1000     // this far behind means the captain restarted
+#define REDUNDANT_MATCH_SLOTS     64       // recent unsequenced frames
+#define REDUNDANT_MATCH_WINDOW    0.5      // s
+
+class RedundantInterface;
+
+struct RedundantPathStats {
+  uint32_t received;         // valid frames on this path
+  uint32_t wins;             // arrived first
+  uint32_t duplicates;       // arrived after the copy on another path
+  uint32_t checksum_errors;
+  double   lag_avg_ms;       // how far behind the winner, for duplicates since the previous stats() call
+  double   lag_max_ms;
+};
+
+//----------------------------------------------------------------
+//One UDP socket to the captain. Only parses, the owner decides what is delivered
+class RedundantPath : public CaptainInterFace {
+  RedundantInterface* owner;
+  int index;
+  boost::asio::ip::udp::socket socket;
+  boost::asio::ip::udp::endpoint captain_endpoint;
+  std::thread read_thread;
+  void readData();
+
+protected:
+  bool send_data(char* buf, uint8_t len) {return write(buf, len);}
+  bool package_received();
+
+public:
+  RedundantPath(RedundantInterface* _owner, int _index, boost::asio::io_service& io);
+
+  bool open(int local_port, const std::string& captain_ip, int captain_port);
+  void start();
+  void join();
+  void applyLinkProfile(const LinkProfile& profile, std::vector<std::string>& report);
+  bool write(const char* buf, uint8_t len);
+  std::string name();
+};
+
+//----------------------------------------------------------------
+class RedundantInterface : public CaptainInterFace {
+  friend class RedundantPath;
+
+  boost::asio::io_service io_service;
+  RedundantPath* paths[REDUNDANT_MAX_PATHS];
+  int n_paths = 0;
+  std::atomic<bool> stopped;
+
+  //Deduplication, serialized between the path threads
+  std::mutex deliver_mutex;
+
+  struct SequenceWindow {
+    bool     valid;
+    uint32_t highest;
+    uint64_t seen;                                   // bit i: highest-i received
+    uint64_t first_ns[REDUNDANT_SEQ_WINDOW];         // arrival of the first copy
+    uint8_t  first_path[REDUNDANT_SEQ_WINDOW];
+  };
+  SequenceWindow windows[256];
+
+  struct RecentFrame {
+    uint8_t  id;
+    uint8_t  path;
+    bool     matched;
+    uint32_t hash;
+    uint64_t first_ns;
+  };
+  RecentFrame recent[REDUNDANT_MATCH_SLOTS];
+  int recent_next = 0;
+
+  struct PathCounters {
+    uint32_t received, wins, duplicates;
+    double lag_sum_ms, lag_max_ms;
+    uint32_t lag_count;
+  };
+  PathCounters path_counters[REDUNDANT_MAX_PATHS];
+  uint32_t stale = 0;
+
+  enum Arrival {ARRIVAL_FIRST, ARRIVAL_DUPLICATE, ARRIVAL_STALE};
+  void deliver(int path, uint8_t id, const char* frame, uint8_t len);
+  Arrival classify(int path, uint8_t id, const char* payload, uint8_t len, uint64_t now_ns, double& lag_ms);
+  void add_lag(int path, double lag_ms);
+
+protected:
+  bool send_data(char* buf, uint8_t len);
+
+public:
+  RedundantInterface();
+  ~RedundantInterface() {stop();};
+
+  //Socket bound to local_port, sending to the captain at captain_ip:captain_port.
+  //Use a different captain address per path to go over different links
+  bool addPath(int local_port, const std::string& captain_ip, int captain_port);
+  void start();
+  void stop();
+  void applyLinkProfile(const LinkProfile& profile, std::vector<std::string>& report);
+
+  int pathCount() {return n_paths;}
+  std::string pathName(int path) {return paths[path]->name();}
+  RedundantPathStats stats(int path);
+  uint32_t staleFrames() {return stale;}   // older than the sequence window, dropped
+};
+//----------------------------------------------------------------
+#endif
@@ -3,6 +3,24 @@
 
 #include "ros/ros.h"
 #include "../CaptainInterFace/CaptainInterFace.h"
+#include "../MessageCodec/MessageCodec.h"
+#include "../Geodesy/Geodesy.h"
+#include "../SharedTelemetry/SharedTelemetry.h"
+#include "../TelemetryStore/TelemetryStore.h"
+#include "../VehicleState/VehicleState.h"
+#include "../FrameRelay/FrameRelay.h"
+#include "../TxScheduler/TxScheduler.h"
+#include "../RxDispatcher/RxDispatcher.h"
+#include "../ClockSync/ClockSync.h"
+#include "../BlackBox/BlackBox.h"
+#include "../CallbackSpinner/CallbackSpinner.h"
+#include "../PathUpload/PathUpload.h"
+#include "../StreamControl/StreamControl.h"
+#include "../TopicPolicy/TopicPolicy.h"
+#include "../AllocTracker/AllocTracker.h"
+#include "../Tracing/Tracing.h"
+#include "../Log/Log.h"
+#include "../RedundantInterface/RedundantInterface.h"
 
 #include "captain_interface/scientistmsg.h"
 
@@ -21,16 +39,18 @@
 #include <geometry_msgs/TwistWithCovarianceStamped.h>
 #include <geometry_msgs/Point.h>
 #include <geometry_msgs/QuaternionStamped.h>
+#include <geometry_msgs/TransformStamped.h>
 #include <sensor_msgs/FluidPressure.h>
 #include <sensor_msgs/MagneticField.h>
 #include <sensor_msgs/Imu.h>
 #include <sensor_msgs/NavSatFix.h>
 #include <sensor_msgs/Temperature.h>
 #include <sensor_msgs/BatteryState.h>
+#include <sensor_msgs/JointState.h>
 #include <geographic_msgs/GeoPoint.h>
 #include <geographic_msgs/GeoPointStamped.h>
+#include <geographic_msgs/GeoPath.h>
 #include <nav_msgs/Odometry.h>
-#include <smarc_msgs/UTMToLatLon.h>
 #include <smarc_msgs/LatLonToUTMOdometry.h>
 #include <smarc_msgs/LatLonOdometry.h>
 #include <smarc_msgs/DVL.h>
@@ -40,23 +60,63 @@
 #include <smarc_msgs/Leak.h>
 #include <lolo_msgs/CaptainStatus.h>
 #include <lolo_msgs/CaptainService.h>
+#include <lolo_msgs/GetVehicleState.h>
 #include <smarc_msgs/ControllerStatus.h>
 #include <smarc_msgs/SensorStatus.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <std_srvs/Trigger.h>
+#include <tf2_ros/transform_broadcaster.h>
+#include <tf2_ros/transform_listener.h>
 
 struct RosInterFace {
 
   //================== ROS Nodehandle ====================//
   ros::NodeHandle* n;
   CaptainInterFace* captain;
+  RedundantInterface* redundant_link = NULL;    //set with the redundant transport, for the path diagnostics
 
   void init(ros::NodeHandle* nh, CaptainInterFace* cap);
 
+  //Callback queues, each drained by its own thread so a slow console or service
+  //callback does not delay setpoints. Timers stay on the global queue
+  CallbackSpinner safety_spinner{"safety"};     //abort, heartbeat
+  CallbackSpinner control_spinner{"control"};   //setpoints and actuator commands
+  CallbackSpinner bulk_spinner{"bulk"};         //service, console and ROS services
+
+  void init_spinner(CallbackSpinner& spinner, ros::NodeHandle& nh);
+  void stop_spinners();
+
   //======================================================//
   //================== Service clients ===================//
   //======================================================//
-  ros::ServiceClient utm_to_latlon_client;
   ros::ServiceClient odom_client;
 
+  //Optional shared memory copy of all incoming frames for local readers
+  SharedTelemetryWriter shm_telemetry;
+  char shm_buffer[SHARED_TELEMETRY_MAX_DATA];
+
+  //Optional columnar recording of decoded feedback messages, see telemetry_query
+  TelemetryStoreWriter telemetry_store;
+
+  //Priority queue for outgoing packages, NULL if disabled
+  TxScheduler* tx_scheduler = NULL;
+
+  //Receive lanes, so a slow log publisher does not delay feedback. NULL if disabled,
+  //then frames are decoded on the reader thread
+  RxDispatcher* rx_dispatcher = NULL;
+  RxFrame rx_frame;                     //inline decoding, reader thread only
+  void start_rx_lanes();
+
+  //Last seconds of link traffic, dumped on abort, leak, checksum error bursts or request
+  BlackBox blackbox;
+
+  //Optional relay of raw frames to other local processes
+  FrameRelay relay;
+  char relay_buffer[CIRCLEBUFFER_SIZE];
+
+  //UTM <-> lat/lon conversion, zone from the utm_zone / utm_band params
+  UTMConverter utm;
+
   //======================================================//
   //================== ROS subscribers ===================//
   //======================================================//
@@ -71,6 +131,8 @@ struct RosInterFace {
 
   //Control commands: High level
   ros::Subscriber waypoint_sub;         //target waypoint
+  ros::Subscriber waypoint_utm_sub;     //target waypoint in UTM coordinates
+  ros::Subscriber path_sub;             //waypoint list
   ros::Subscriber speed_sub;            //target speed
   ros::Subscriber depth_sub;            //target depth
   ros::Subscriber altitude_sub;         //target altitude
@@ -122,7 +184,107 @@ struct RosInterFace {
   ros::Publisher status_depth_pub;
   ros::Publisher status_twist_pub;
 
-  //Status publishers
+  //Dead reckoning state, decoded from CS_POSITION / CS_IMU
+  bool publish_dr;
+  ros::Publisher dr_latlon_pub;
+  ros::Publisher dr_depth_pub;
+  ros::Publisher dr_roll_pub;
+  ros::Publisher dr_pitch_pub;
+  ros::Publisher dr_yaw_pub;
+  ros::Publisher dr_odom_pub;
+
+  //world_ned -> base_link, as ins_to_dr.py broadcast it
+  bool publish_tf;
+  tf2_ros::TransformBroadcaster* tf_broadcaster = NULL;
+  tf2_ros::Buffer* tf_buffer = NULL;
+  tf2_ros::TransformListener* tf_listener = NULL;
+  geometry_msgs::TransformStamped base_link_tf;
+  void broadcast_base_link(const geometry_msgs::Pose& utm_pose);
+
+  //Joint states of control surfaces and thrusters for robot_state_publisher
+  enum {
+    JOINT_ELEVON_PORT = 0,
+    JOINT_ELEVON_STRB,
+    JOINT_RUDDER_PORT,
+    JOINT_RUDDER_STRB,
+    JOINT_ELEVATOR,
+    JOINT_THRUSTER_PORT,
+    JOINT_THRUSTER_STRB,
+    JOINT_N
+  };
+  enum {
+    JOINT_SOURCE_RUDDER        = 1 << 0,
+    JOINT_SOURCE_ELEVATOR      = 1 << 1,
+    JOINT_SOURCE_ELEVON_PORT   = 1 << 2,
+    JOINT_SOURCE_ELEVON_STRB   = 1 << 3,
+    JOINT_SOURCE_THRUSTER_PORT = 1 << 4,
+    JOINT_SOURCE_THRUSTER_STRB = 1 << 5,
+    JOINT_SOURCE_ALL           = (1 << 6) - 1
+  };
+  ros::Publisher joint_state_pub;
+  ros::Timer joint_state_timer;
+  sensor_msgs::JointState joint_state;
+  double joint_state_rate;          // Hz, 0 = publish when a full set is available
+  uint8_t joint_state_updated;      // JOINT_SOURCE_* received since last publish
+  ros::Time joint_state_last;
+
+  void init_joint_states();
+  void joint_state_timer_callback(const ros::TimerEvent& event);
+  void joint_state_feedback(uint8_t source);
+  void publish_joint_state(const VehicleState& state);
+
+  //Waypoint path upload
+  PathUploader* path_uploader = NULL;
+  ros::Publisher path_confirmed_pub;    //number of points acknowledged by the captain
+  ros::Timer path_upload_timer;
+  PathUploadStatus path_upload_last;
+  void path_upload_timer_callback(const ros::TimerEvent& event);
+
+  //Demand driven captain streams, NULL unless ~stream_control is set
+  StreamController* stream_controller = NULL;
+  ros::Timer stream_control_timer;
+  double stream_silence;                // s without frames before the link counts as lost
+  double stream_hold;                   // s all streams stay on after a vehicle state request
+  ros::Time stream_hold_until;
+  uint32_t stream_link_frames = 0;      // frames received at the previous check
+  double stream_link_silent = 0;        // s since the last frame
+  uint32_t stream_clock_resets = 0;
+  void init_stream_control();
+  void stream_control_timer_callback(const ros::TimerEvent& event);
+  bool stream_demand(uint8_t stream);
+
+  //Per topic publishing policies from ~topic_policies, see config/topic_policies.yaml.
+  //Applied before a message is built, skipped frames only update the vehicle state
+  enum {
+    TOPIC_RUDDER = 0,
+    TOPIC_ELEVATOR,
+    TOPIC_ELEVON_PORT,
+    TOPIC_ELEVON_STRB,
+    TOPIC_THRUSTER_PORT,
+    TOPIC_THRUSTER_STRB,
+    TOPIC_DR_LATLON,
+    TOPIC_DR_DEPTH,
+    TOPIC_DR_ROLL,
+    TOPIC_DR_PITCH,
+    TOPIC_DR_YAW,
+    TOPIC_DR_ODOM,
+    TOPIC_TEXT,
+    TOPIC_MISSIONLOG,
+    TOPIC_DATALOG,
+    TOPIC_N
+  };
+  TopicPolicy topic_policies[TOPIC_N];
+  ros::Publisher topic_min_pub[TOPIC_N];  // <topic>/min and <topic>/max, aggregate policies only
+  ros::Publisher topic_max_pub[TOPIC_N];
+  void init_topic_policies();
+  template<class M> void advertise_min_max(int topic);
+  ros::Publisher& topic_publisher(int topic);
+  const char* topic_name(int topic);
+  bool topic_subscribed(int topic);       // also counts /min and /max, always true during the allocation check
+  bool topic_admit(int topic, const float* values = NULL);
+
+  //Status publishers. CS_STATUS is only decoded with publish_status
+  bool publish_status;
   ros::Publisher control_status_pub;
   ros::Publisher vehiclestate_pub;
 
@@ -154,15 +316,23 @@ struct RosInterFace {
   ros::Publisher missonlog_pub;
   ros::Publisher datalog_pub;
 
+  //Interface diagnostics
+  ros::Publisher diagnostics_pub;
+  ros::Timer diagnostics_timer;
+  void publish_diagnostics(const ros::TimerEvent& event);
+
   //======================================================//
   //=================== ROS callbacks ====================//
   //======================================================//
 
+  void send_waypoint(double lat, double lon);
+
   void ros_callback_heartbeat(const std_msgs::Empty::ConstPtr &_msg);
   void ros_callback_abort(const std_msgs::Empty::ConstPtr &_msg);
   //void ros_callback_done(const std_msgs::Empty::ConstPtr &_msg);
   void ros_callback_waypoint_utm(const geometry_msgs::Point::ConstPtr &_msg);
   void ros_callback_waypoint(const geographic_msgs::GeoPoint::ConstPtr &_msg);
+  void ros_callback_path(const geographic_msgs::GeoPath::ConstPtr &_msg);
   void ros_callback_speed(const std_msgs::Float64::ConstPtr &_msg);
   void ros_callback_depth(const std_msgs::Float64::ConstPtr &_msg);
   void ros_callback_altitude(const std_msgs::Float64::ConstPtr &_msg);
@@ -178,42 +348,133 @@ struct RosInterFace {
   void ros_callback_menu(const std_msgs::String::ConstPtr &_msg);
 
   //======================================================//
-  //================= Captain callbacks ==================//
+  //==================== ROS services ====================//
   //======================================================//
+  ros::ServiceServer vehicle_state_srv;
+  ros::ServiceServer blackbox_srv;
+
+  bool ros_service_vehicle_state(lolo_msgs::GetVehicleState::Request &req, lolo_msgs::GetVehicleState::Response &res);
+  bool ros_service_blackbox(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res);
 
-  void captain_callback_LEAK();
-  void captain_callback_CONTROL();
-  void captain_callback_RUDDER();
-  void captain_callback_ELEVATOR();
-  void captain_callback_ELEVON_PORT();
-  void captain_callback_ELEVON_STRB();
-  void captain_callback_THRUSTER_PORT();
-  void captain_callback_THRUSTER_STRB();
-  void captain_callback_BATTERY();
-  void captain_callback_SERVICE();
-  void captain_callback_CTRL_STATUS();
-  void captain_callback_TEXT();
-  void captain_callback_MENUSTREAM();
-  void captain_callback_MISSIONLOG();
-  void captain_callback_DATALOG();
+  //======================================================//
+  //================= Captain callbacks ==================//
+  //======================================================//
 
+  //Captain clock in host time, from the receive timestamps
+  ClockOffsetEstimator captain_clock;
+  enum {
+    STAMP_CAPTAIN = 0,    // captain time as is
+    STAMP_HOST,           // captain time moved to host time with the estimated offset
+    STAMP_RECEIVE         // host receive time
+  } stamp_mode = STAMP_CAPTAIN;
+  ros::Time stamp(uint64_t captain_us, const RxFrame& frame);
+
+  //Latest value of every decoded field
+  VehicleStateCache vehicle_state;
+  nav_msgs::Odometry dr_odom;
+
+  //Messages reused by the high rate callbacks so decoding does not allocate.
+  //frame_id and service_name are filled in once by init
+  smarc_msgs::FloatStamped rudder_msg;
+  smarc_msgs::FloatStamped elevator_msg;
+  smarc_msgs::FloatStamped elevon_port_msg;
+  smarc_msgs::FloatStamped elevon_strb_msg;
+  smarc_msgs::ThrusterFeedback thruster_port_msg;
+  smarc_msgs::ThrusterFeedback thruster_strb_msg;
+  smarc_msgs::ControllerStatus ctrl_status_msgs[VEHICLESTATE_N_CONTROLLERS];
+
+  //Publish outside the decode allocation scope, roscpp serialization allocates
+  template<class M> void publish(const ros::Publisher& pub, const M& msg) {
+    AllocScope scope(ALLOC_SCOPE_PUBLISH);
+    TRACE_SPAN("publish", -1);
+    pub.publish(msg);
+  }
+
+  //Fields from the topic policy: the window mean, and when aggregating also
+  //the minimum and maximum on <topic>/min and <topic>/max
+  template<class M> void publish_topic(int topic, M& msg, void (*set)(M&, const float*)) {
+    TopicPolicy& policy = topic_policies[topic];
+    set(msg, policy.mean());
+    ros::Publisher& pub = topic_publisher(topic);
+    if(alloc_checking || pub.getNumSubscribers() > 0) publish(pub, msg);
+    if(!policy.aggregating()) return;
+    if(topic_min_pub[topic].getNumSubscribers() > 0) { set(msg, policy.min()); publish(topic_min_pub[topic], msg); }
+    if(topic_max_pub[topic].getNumSubscribers() > 0) { set(msg, policy.max()); publish(topic_max_pub[topic], msg); }
+  }
+
+  //Feeds synthetic frames through the decoder and reports allocations per message ID
+  bool run_alloc_check();
+  bool alloc_checking = false;            // builds and publishes every message as if subscribed
+
+  void publish_controller_status(ros::Publisher& pub, int controller, bool enabled);
+
+  void captain_callback_LEAK(RxFrame& frame);
+  void captain_callback_CONTROL(RxFrame& frame);
+  void captain_callback_RUDDER(RxFrame& frame);
+  void captain_callback_ELEVATOR(RxFrame& frame);
+  void captain_callback_ELEVON_PORT(RxFrame& frame);
+  void captain_callback_ELEVON_STRB(RxFrame& frame);
+  void captain_callback_THRUSTER_PORT(RxFrame& frame);
+  void captain_callback_THRUSTER_STRB(RxFrame& frame);
+  void captain_callback_BATTERY(RxFrame& frame);
+  void captain_callback_IMU(RxFrame& frame);
+  void captain_callback_POSITION(RxFrame& frame);
+  void captain_callback_STATUS(RxFrame& frame);
+  void captain_callback_SERVICE(RxFrame& frame);
+  void captain_callback_CTRL_STATUS(RxFrame& frame);
+  void captain_callback_TEXT(RxFrame& frame);
+  void captain_callback_MENUSTREAM(RxFrame& frame);
+  void captain_callback_MISSIONLOG(RxFrame& frame);
+  void captain_callback_DATALOG(RxFrame& frame);
+
+  //Reader thread: raw copies, then decoding inline or on a receive lane
   void captain_callback() {
     int msgID = captain->messageID();
-    switch (msgID) {
-      case CS_LEAK: {         captain_callback_LEAK(); }; break; //Leak
-      case CS_CONTROL: {      captain_callback_CONTROL(); } break; //control
-      case CS_RUDDER: {       captain_callback_RUDDER(); } break; // rudder
-      case CS_ELEVATOR: {     captain_callback_ELEVATOR(); } break; //elevator
-      case CS_ELEVON_PORT: {  captain_callback_ELEVON_PORT(); } break; //Port elevon
-      case CS_ELEVON_STRB: {  captain_callback_ELEVON_STRB(); } break; //Strb elevon
-      case CS_THRUSTER_PORT: {captain_callback_THRUSTER_PORT(); } break; //port thruster
-      case CS_THRUSTER_STRB: {captain_callback_THRUSTER_STRB(); } break; //strb thruster
-      case CS_BATTERY: {      captain_callback_BATTERY(); } break; //battery
-      case CS_TEXT: {         captain_callback_TEXT(); } break;  //General purpose text message
-      case CS_REQUEST_OUT:{   captain_callback_SERVICE(); } break; //"service call"
-      case CS_MENUSTREAM: {   captain_callback_MENUSTREAM(); } break; //Menu stream data
-      case CS_MISSIONLOG: {   captain_callback_MISSIONLOG(); } break; //Mission log stream data}
-      case CS_DATALOG: {      captain_callback_DATALOG(); } break; //Data log stream data}
+    if(shm_telemetry.isOpen() || telemetry_store.isOpen()) {
+      uint8_t len = captain->copy_package(shm_buffer);
+      if(shm_telemetry.isOpen()) shm_telemetry.write(msgID, shm_buffer, len);
+      if(telemetry_store.isOpen()) telemetry_store.write(msgID, shm_buffer, len);
+    }
+    if(relay.isActive()) {
+      uint8_t len = captain->copy_frame(relay_buffer);
+      relay.forward(msgID, relay_buffer, len);
+    }
+    uint8_t len = captain->copy_package(rx_frame.data);
+    if(blackbox.isActive()) blackbox.record(BLACKBOX_RX, msgID, rx_frame.data, len, captain->receiveTime());
+    if(rx_dispatcher != NULL && rx_dispatcher->running()) {
+      rx_dispatcher->dispatch(msgID, rx_frame.data, len, captain->receiveTime());
+      return;
+    }
+    rx_frame.set(msgID, rx_frame.data, len, captain->receiveTime());
+    decode(rx_frame);
+  };
+
+  void decode(RxFrame& frame) {
+    AllocScope alloc_scope(frame.msgID);
+    TRACE_SPAN("decode", frame.msgID);
+    if(frame.rx_ns != 0 && frame.len >= 12 && CaptainInterFace::has_sequence_header(frame.msgID)) {
+      captain_clock.add(frame.parse_llong(), frame.rx_ns);
+      frame.pos = 0;
+    }
+    switch (frame.msgID) {
+      case CS_LEAK: {         captain_callback_LEAK(frame); }; break; //Leak
+      case CS_STATUS: {       captain_callback_STATUS(frame); } break; //captain status
+      case CS_CONTROL: {      captain_callback_CONTROL(frame); } break; //control
+      case CS_RUDDER: {       captain_callback_RUDDER(frame); } break; // rudder
+      case CS_ELEVATOR: {     captain_callback_ELEVATOR(frame); } break; //elevator
+      case CS_ELEVON_PORT: {  captain_callback_ELEVON_PORT(frame); } break; //Port elevon
+      case CS_ELEVON_STRB: {  captain_callback_ELEVON_STRB(frame); } break; //Strb elevon
+      case CS_THRUSTER_PORT: {captain_callback_THRUSTER_PORT(frame); } break; //port thruster
+      case CS_THRUSTER_STRB: {captain_callback_THRUSTER_STRB(frame); } break; //strb thruster
+      case CS_BATTERY: {      captain_callback_BATTERY(frame); } break; //battery
+      case CS_IMU: {          captain_callback_IMU(frame); } break; //attitude
+      case CS_POSITION: {     captain_callback_POSITION(frame); } break; //position
+      case CS_CTRL_STATUS: {  captain_callback_CTRL_STATUS(frame); } break; //controller status
+      case CS_TEXT: {         captain_callback_TEXT(frame); } break;  //General purpose text message
+      case CS_REQUEST_OUT:{   captain_callback_SERVICE(frame); } break; //"service call"
+      case CS_MENUSTREAM: {   captain_callback_MENUSTREAM(frame); } break; //Menu stream data
+      case CS_MISSIONLOG: {   captain_callback_MISSIONLOG(frame); } break; //Mission log stream data}
+      case CS_DATALOG: {      captain_callback_DATALOG(frame); } break; //Data log stream data}
     };
   };
 };
@@ -0,0 +1,131 @@
+/*------------------------------------------------------------------------------------
+	Receive lanes: decoded captain -> scientist frames handled off the reader thread
+------------------------------------------------------------------------------------*/
+
+#ifndef RxDispatcher_h
+#define RxDispatcher_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+// Every lane is drained by its own thread, in arrival order. All IDs of a lane
+// share that thread, so frames of one ID are never reordered and handlers of one
+// lane never run concurrently. IDs on different lanes run in parallel.
+//  - feedback: actuators, IMU, position, status. Everything writing the vehicle
+//    state cache, which has a single writer
+//  - service:  service replies and text
+//  - log:      console and log streams, may be slow to publish
+// Leak, status and controller status frames (see critical()) are never
+// dropped. They stay on the feedback lane, in a separate ring of their own
+// that the lane thread drains first and that grows instead of dropping when
+// full. LINK_HELLO is handled on the reader thread and never reaches a lane.
+
+enum RxLane {
+  RX_FEEDBACK = 0,
+  RX_SERVICE,
+  RX_LOG,
+  RX_N_LANES
+};
+
+struct RxLaneStats {
+  uint32_t depth;
+  uint32_t max_depth;
+  uint32_t dispatched;
+  uint32_t handled;
+  uint32_t dropped;
+  double   latency_avg_us;    // Arrival to handler start, since the previous stats() call
+  double   latency_max_us;
+  double   handler_max_us;    // Longest single handler
+};
+
+//----------------------------------------------------------------
+//Payload of one received frame, with the same parse functions as CaptainInterFace
+struct RxFrame {
+  typedef std::chrono::steady_clock Clock;
+
+  uint8_t  msgID;
+  uint8_t  len;               // payload bytes
+  uint8_t  pos;               // next byte to parse
+  char     data[255];
+  uint64_t rx_ns;             // host receive time (CLOCK_REALTIME), 0 if unknown
+  Clock::time_point received;
+
+  void set(uint8_t _msgID, const char* payload, uint8_t _len, uint64_t _rx_ns = 0);   // payload may be data
+
+  uint8_t       parse_byte();   // 0 past the end of the payload
+  std::string   parse_string(int Nchars);
+  float         parse_float();
+  double        parse_double();
+  uint32_t      parse_long();
+  uint64_t      parse_llong();
+  int           parse_int();
+};
+
+//----------------------------------------------------------------
+class RxDispatcher {
+public:
+  typedef std::function<void(RxFrame&)> Handler;
+  typedef RxFrame::Clock Clock;
+
+private:
+  //Fixed capacity ring, allocated once in configure()
+  struct RxQueue {
+    std::vector<RxFrame> frames;
+    size_t head = 0;
+    size_t count = 0;
+    bool drop_oldest = true;
+
+    RxFrame& at(size_t i) {return frames[(head + i) % frames.size()];};
+    void pop() {head = (head + 1) % frames.size(); count--;};
+    void grow();              // twice the capacity, keeps the frames in order
+  };
+
+  struct Lane {
+    RxQueue queue;
+    RxQueue critical;         // never dropped, handled before queue
+    RxLaneStats stats;
+    double latency_sum_us = 0;
+    uint32_t handled_at_last_stats = 0;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+  };
+
+  Lane lanes[RX_N_LANES];
+  Handler handler;
+  std::atomic<bool> stopped;
+
+  void run(RxLane l);
+
+public:
+  RxDispatcher(Handler handler);
+  ~RxDispatcher() {stop();};
+
+  //Must be called before start()
+  void configure(RxLane l, size_t capacity, bool drop_oldest);
+
+  void start();
+  void stop();
+  bool running() {return !stopped;}
+  std::thread::native_handle_type thread(RxLane l) {return lanes[l].thread.native_handle();};
+
+  //Copy the payload to its lane. Returns false if it was dropped
+  bool dispatch(uint8_t msgID, const char* payload, uint8_t len, uint64_t rx_ns = 0);
+
+  static RxLane classify(uint8_t msgID);
+  static bool critical(uint8_t msgID);
+  static const char* laneName(RxLane l);
+
+  //Current counters. Resets the latency window
+  RxLaneStats stats(RxLane l);
+};
+//----------------------------------------------------------------
+#endif
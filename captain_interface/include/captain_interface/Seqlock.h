@@ -0,0 +1,50 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <stdint.h>
+
+//----------------------------------------------------------------
+//------------Single writer, multiple reader seqlock---------------
+//----------------------------------------------------------------
+// T must be trivially copyable. Readers never block the writer; a
+// read that overlaps a write is detected and retried. The layout is
+// plain data so it can also be placed in shared memory.
+template <typename T>
+class Seqlock {
+  std::atomic<uint32_t> seq;
+  T value;
+
+public:
+  Seqlock() : seq(0), value() {};
+
+  void store(const T& v) {
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s+1, std::memory_order_relaxed);   //odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    value = v;
+    std::atomic_thread_fence(std::memory_order_release);
+    seq.store(s+2, std::memory_order_relaxed);   //even: consistent
+  };
+
+  //Single attempt, false if a write was in progress
+  bool try_load(T& out) const {
+    uint32_t s1 = seq.load(std::memory_order_acquire);
+    if(s1 & 1) return false;
+    out = value;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t s2 = seq.load(std::memory_order_relaxed);
+    return s1 == s2;
+  };
+
+  T load() const {
+    T out;
+    while(!try_load(out)) {};
+    return out;
+  };
+
+  //Number of completed writes
+  uint32_t version() const {return seq.load(std::memory_order_acquire) / 2;};
+};
+//----------------------------------------------------------------
+#endif
@@ -0,0 +1,60 @@
+/*------------------------------------------------------------------------------------
+	Captain scientist interface: serial line / PTY
+------------------------------------------------------------------------------------*/
+
+#ifndef SerialInterface_h
+#define SerialInterface_h
+
+#include "../CaptainInterFace/CaptainInterFace.h"
+#include <boost/asio.hpp>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+//Reads wait in poll() and then take everything the driver has buffered.
+//VTIME has 0.1 s resolution, so VMIN > 0 would hold back the end of a burst
+#define SERIAL_READ_MIN   0     // VMIN
+#define SERIAL_READ_GAP   0     // VTIME, 0.1 s units
+#define SERIAL_READ_BLOCK 4096  // Largest block handed to the decoder
+
+//----------------------------------------------------------------
+class SerialInterface : public CaptainInterFace {
+  boost::asio::io_service io_service;
+  boost::asio::serial_port port;
+  std::atomic<bool> stopped;
+
+  std::thread read_thread;
+  void readData();
+
+  //Frames are collected while the previous write is in progress and sent in one write
+  std::thread write_thread;
+  std::mutex write_mutex;
+  std::condition_variable write_cv;
+  std::vector<char> write_pending;
+  std::vector<char> write_active;
+  std::atomic<uint32_t> write_overflows;
+  void writeData();
+
+  bool configure(unsigned baud);
+
+protected:
+  bool send_data(char* buf, uint8_t len);
+
+public:
+  SerialInterface();
+  ~SerialInterface() {stop();};
+
+  //e.g. "/dev/ttyUSB0" or one end of a socat PTY pair
+  bool setup(const std::string& device, unsigned baud);
+  //Already open descriptor, e.g. a PTY master. Takes ownership
+  bool attach(int fd, unsigned baud);
+  void stop();
+  void applyLinkProfile(const LinkProfile& profile, std::vector<std::string>& report);
+
+  uint32_t overflows() {return write_overflows;};
+};
+//----------------------------------------------------------------
+#endif
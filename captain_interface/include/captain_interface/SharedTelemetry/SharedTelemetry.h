@@ -0,0 +1,87 @@
+/*------------------------------------------------------------------------------------
+	Shared memory telemetry: captain frames published to /dev/shm
+------------------------------------------------------------------------------------*/
+
+#ifndef SharedTelemetry_h
+#define SharedTelemetry_h
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include "../Seqlock.h"
+
+#define SHARED_TELEMETRY_MAGIC      0x4C4F4C4F  // "LOLO"
+#define SHARED_TELEMETRY_VERSION    1
+#define SHARED_TELEMETRY_RING_SIZE  1024        // Must be a power of two
+#define SHARED_TELEMETRY_MAX_DATA   255
+
+//One validated captain frame. data holds the payload after the message ID,
+//in the same byte order as on the link.
+struct TelemetryFrame {
+  uint64_t index;           // Position in the ring
+  uint64_t rx_time_ns;      // Host receive time (CLOCK_REALTIME)
+  uint8_t  msgID;
+  uint8_t  length;          // Number of valid bytes in data
+  char     data[SHARED_TELEMETRY_MAX_DATA];
+
+  //Helpers matching CaptainInterFace::parse_*
+  float    get_float(uint8_t offset) const {float v; memcpy(&v, data+offset, 4); return v;};
+  double   get_double(uint8_t offset) const {double v; memcpy(&v, data+offset, 8); return v;};
+  uint32_t get_long(uint8_t offset) const {uint32_t v; memcpy(&v, data+offset, 4); return v;};
+  uint64_t get_llong(uint8_t offset) const {return (((uint64_t) get_long(offset)) << 32) + get_long(offset+4);};
+
+  //Most feedback frames start with timestamp [us] and sequence
+  uint64_t timestamp() const {return get_llong(0);};
+  uint32_t sequence() const {return get_long(8);};
+};
+
+struct SharedTelemetryRegion {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t ring_size;
+  std::atomic<uint64_t> head;                             // Next ring index to be written
+  Seqlock<TelemetryFrame> latest[256];                    // Newest frame for each message ID
+  Seqlock<TelemetryFrame> ring[SHARED_TELEMETRY_RING_SIZE];
+};
+
+//----------------------------------------------------------------
+class SharedTelemetryWriter {
+  std::string name;
+  SharedTelemetryRegion* region = NULL;
+  TelemetryFrame frame;
+
+public:
+  ~SharedTelemetryWriter() {close();};
+
+  bool open(const std::string& name);   // name as for shm_open, e.g. "/lolo_telemetry"
+  void close();
+  bool isOpen() const {return region != NULL;};
+
+  //Lock-free, called from the receive thread only
+  void write(uint8_t msgID, const char* data, uint8_t length);
+};
+
+//----------------------------------------------------------------
+class SharedTelemetryReader {
+  const SharedTelemetryRegion* region = NULL;
+
+public:
+  ~SharedTelemetryReader() {close();};
+
+  bool open(const std::string& name);
+  void close();
+  bool isOpen() const {return region != NULL;};
+
+  //Newest frame with the given ID. false if none has been received
+  bool latest(uint8_t msgID, TelemetryFrame& frame) const;
+
+  //Ring index of the next frame to be written
+  uint64_t head() const;
+
+  //Read the frame at cursor and advance it. Returns false when there is no
+  //new frame. If the writer has lapped the reader, cursor jumps to the oldest
+  //frame still in the ring and the number of skipped frames is added to lost.
+  bool next(uint64_t& cursor, TelemetryFrame& frame, uint64_t* lost = NULL) const;
+};
+//----------------------------------------------------------------
+#endif
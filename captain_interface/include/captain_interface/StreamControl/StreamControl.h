@@ -0,0 +1,99 @@
+/*------------------------------------------------------------------------------------
+	Demand driven captain telemetry: streams enabled only while they are used
+------------------------------------------------------------------------------------*/
+
+#ifndef StreamControl_h
+#define StreamControl_h
+
+#include <stdint.h>
+#include <mutex>
+#include <chrono>
+#include <functional>
+
+// SC_REQUEST_IN payload for SERVICE_STREAM:
+//   int    ref          acknowledged with CS_REQUEST_OUT (ref, SERVICE_ACTION_SUCCESS/FAIL)
+//   byte   SERVICE_STREAM
+//   byte   action       SERVICE_ACTION_ENABLE or SERVICE_ACTION_DISABLE
+//   byte   stream       CS_* message ID
+//   float  rate         Hz when enabling, 0 = the captain's default rate
+//
+// ref = STREAM_REF_FLAG | generation << 8 | stream, so an acknowledgement of an
+// older request for the same stream is not taken for the latest one.
+//
+// Only streams passed to manage() are touched, the captain keeps sending all
+// others. A captain that rejects the service keeps its defaults; the stream is
+// marked rejected and not asked again until resync(). The captain forgets the
+// requests when it restarts, so the owner calls resync() after reconnects.
+
+#define STREAM_REF_FLAG 0x4000
+
+struct StreamControlStatus {
+  uint32_t managed;
+  uint32_t enabled;       // streams currently wanted
+  uint32_t confirmed;     // streams whose latest request the captain acknowledged
+  uint32_t pending;       // requests waiting for an acknowledgement
+  uint32_t rejected;      // streams the captain refused to change
+  uint32_t requests;
+  uint32_t retransmits;
+  uint32_t resyncs;
+};
+
+//----------------------------------------------------------------
+class StreamController {
+public:
+  typedef std::function<bool(uint8_t, const char*, uint8_t)> SendFunction; // msgID, payload, length
+  typedef std::chrono::steady_clock Clock;
+
+private:
+  struct Stream {
+    bool     managed = false;
+    bool     wanted = true;     // the captain streams everything by default
+    float    rate = 0;          // Hz while wanted, 0 = captain default
+    bool     requested = false; // a request with the current state was sent
+    bool     confirmed = false;
+    bool     pending = false;
+    bool     rejected = false;
+    uint8_t  generation = 0;
+    int      retries = 0;
+    Clock::time_point sent;
+  };
+
+  SendFunction send;
+  std::mutex mutex;
+  Stream streams[256];
+
+  double timeout = 0.5;         // s before a request is sent again
+  int max_retries = 3;
+  StreamControlStatus counters;
+
+  void new_request(uint8_t id, Stream& s);    // next generation
+  void send_request(uint8_t id, Stream& s);   // also retransmits
+
+public:
+  StreamController(SendFunction send);
+
+  void setRetry(double timeout_s, int retries) {timeout = timeout_s; max_retries = retries;};
+
+  //Put a stream under demand control, rate [Hz] used while it is enabled
+  void manage(uint8_t stream, float rate);
+
+  //Requests a change if the stream is managed and its wanted state or rate changed
+  void setDemand(uint8_t stream, bool wanted);
+  void setRate(uint8_t stream, float rate);
+
+  //Send the state of every managed stream again, e.g. after the link came back
+  void resync();
+
+  //Service reply from the captain. Returns false if ref is not a stream request
+  bool handle_ack(uint16_t ref, uint8_t reply);
+
+  //Send unacknowledged requests again, call periodically
+  void poll();
+
+  bool isManaged(uint8_t stream) {return streams[stream].managed;}
+  bool isEnabled(uint8_t stream) {return !streams[stream].managed || streams[stream].wanted;}
+
+  StreamControlStatus status();
+};
+//----------------------------------------------------------------
+#endif
@@ -0,0 +1,174 @@
+/*------------------------------------------------------------------------------------
+	Columnar store of decoded captain feedback messages
+------------------------------------------------------------------------------------*/
+
+#ifndef TelemetryStore_h
+#define TelemetryStore_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "../MessageCodec/MessageCodec.h"
+
+// One directory per recording. For each MessageCodec layout that starts with
+// the captain timestamp:
+//   <message>.<field>   raw column, one native value per row, no header
+//   <message>.index     TelemetryIndexHeader, then one entry per full chunk
+// Columns are plain arrays so readers can mmap them. Rows are appended in
+// the order they arrive; the captain timestamp is assumed to be increasing.
+// The receive thread only queues frames, a writer thread appends them to the
+// columns and does all file I/O.
+
+#define TELEMETRY_INDEX_MAGIC    0x58444954  // "TIDX"
+#define TELEMETRY_INDEX_VERSION  1
+
+struct TelemetryIndexHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t  msgID;
+  uint8_t  n_fields;
+  uint32_t chunk_rows;
+  uint32_t reserved;
+};
+
+//Per chunk entry, followed by n_fields TelemetryFieldStats
+struct TelemetryChunkIndex {
+  uint64_t first_row;
+  uint64_t t_first;       // captain timestamp [us] of the first and last row
+  uint64_t t_last;
+};
+
+struct TelemetryFieldStats {
+  double min;
+  double max;
+  double sum;
+};
+
+//----------------------------------------------------------------
+class TelemetryStoreWriter {
+  struct Column {
+    int fd = -1;
+    std::vector<char> pending;      // rows not yet written to the file
+    TelemetryFieldStats stats;      // current chunk
+  };
+
+  struct Table {
+    const MessageLayout* layout;
+    int index_fd = -1;
+    std::vector<Column> columns;
+    uint64_t rows = 0;
+    uint32_t chunk_fill = 0;        // rows in the current chunk
+    uint64_t t_first = 0;
+    uint64_t t_last = 0;
+  };
+
+  //Frames queued by the receive thread. Fixed capacity ring, allocated in open()
+  struct Record {
+    uint8_t msgID;
+    uint8_t length;
+    char    data[255];
+  };
+  std::vector<Record> queue;
+  size_t queue_head = 0;
+  size_t queue_count = 0;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::thread thread;
+  bool stopping = false;
+
+  //Writer thread only
+  std::string dir;
+  uint32_t chunk_rows = 4096;
+  Table* tables[256] = {NULL};
+  bool failed = false;              // files could not be created, frames are discarded
+  std::chrono::steady_clock::time_point last_flush;
+  double flush_interval = 5.0;      // s, bounds the data lost on a crash
+
+  void run();
+  bool append(uint8_t msgID, const char* data, uint8_t length);
+  Table* open_table(uint8_t msgID);
+  void write_chunk_index(Table* t);
+  void flush_table(Table* t);
+  void flush();
+
+public:
+  ~TelemetryStoreWriter() {close();};
+
+  //Creates a new recording directory under base_dir, named after the start
+  //time (with a suffix if that name exists), and starts the writer thread
+  bool open(const std::string& base_dir, uint32_t chunk_rows = 4096, size_t queue_size = 4096);
+  void close();                     // writes what is still queued
+  bool isOpen() const {return !dir.empty();};
+  const std::string& directory() const {return dir;};
+
+  //Payload after the message ID. Messages without a layout are ignored.
+  //Never blocks on I/O; returns false if the queue is full and the frame dropped
+  bool write(uint8_t msgID, const char* data, uint8_t length);
+
+  std::atomic<uint32_t> dropped{0};
+};
+
+//----------------------------------------------------------------
+class TelemetryTable {
+  friend class TelemetryStoreReader;
+
+  std::vector<const char*> columns;
+  std::vector<size_t> column_bytes;
+  const TelemetryIndexHeader* header = NULL;
+  size_t index_bytes = 0;
+  size_t entry_size = 0;
+
+public:
+  const MessageLayout* layout = NULL;
+  uint64_t rows = 0;
+  uint64_t chunks = 0;        // chunks with an index entry, rows after these are only in the columns
+
+  int field(const char* name) const;    // -1 if unknown
+  double value(int field, uint64_t row) const {
+    MessageFieldType type = layout->fields[field].type;
+    return message_field_value(type, columns[field] + row * message_field_size(type));
+  };
+  uint64_t timestamp(uint64_t row) const {uint64_t t; memcpy(&t, columns[0] + row*8, 8); return t;};
+
+  const TelemetryChunkIndex* chunk(uint64_t i) const {
+    return (const TelemetryChunkIndex*) ((const char*) (header+1) + i * entry_size);
+  };
+  const TelemetryFieldStats* chunk_stats(uint64_t i, int field) const {
+    return (const TelemetryFieldStats*) (chunk(i)+1) + field;
+  };
+
+  //First row with timestamp >= t
+  uint64_t lower_bound(uint64_t t) const;
+
+  //Count, min, max and sum of a field over rows [begin, end). Whole chunks use the index
+  void aggregate(int field, uint64_t begin, uint64_t end, uint64_t& count, TelemetryFieldStats& stats) const;
+};
+
+//----------------------------------------------------------------
+class TelemetryStoreReader {
+  struct Mapping {
+    void* addr;
+    size_t length;
+  };
+  std::vector<Mapping> mappings;
+  TelemetryTable tables[256];
+
+  const char* map_file(const std::string& path, size_t& length);
+
+public:
+  ~TelemetryStoreReader() {close();};
+
+  bool open(const std::string& dir);
+  void close();
+
+  //NULL if the message was not recorded
+  const TelemetryTable* table(uint8_t msgID) const {return tables[msgID].layout != NULL ? &tables[msgID] : NULL;};
+  const TelemetryTable* table(const char* name) const;
+};
+//----------------------------------------------------------------
+#endif
@@ -0,0 +1,76 @@
+/*------------------------------------------------------------------------------------
+	Publishing policy of a telemetry topic: pass, decimate, throttle or aggregate
+------------------------------------------------------------------------------------*/
+
+#ifndef TopicPolicy_h
+#define TopicPolicy_h
+
+#include <stdint.h>
+#include <string>
+#include <atomic>
+
+// Decides per decoded frame whether its message is built and published:
+//   pass        every frame
+//   decimate N  the first and then every Nth frame
+//   throttle    at most rate Hz, without drifting below it
+//   aggregate   one message per window with the mean of the numeric fields,
+//               minimum and maximum are kept for <topic>/min and <topic>/max
+//
+// admit() takes the fields of the frame (up to TOPIC_POLICY_FIELDS floats) so
+// the caller fills the message from mean() in every mode. Samples older than a
+// window, e.g. while nobody subscribed, start a new window.
+// One decoding thread per topic, the counters may be read from any thread.
+
+#define TOPIC_POLICY_FIELDS 4
+
+enum TopicPolicyMode {
+  POLICY_PASS = 0,
+  POLICY_DECIMATE,
+  POLICY_THROTTLE,
+  POLICY_AGGREGATE
+};
+
+//----------------------------------------------------------------
+class TopicPolicy {
+  TopicPolicyMode mode = POLICY_PASS;
+  uint32_t every = 1;           // decimate
+  uint64_t period_ns = 0;       // throttle interval or aggregate window
+  uint32_t count = 0;
+  uint64_t last_ns = 0;         // last publish (throttle) or window start (aggregate)
+  uint64_t sample_ns = 0;       // last aggregated sample
+
+  uint32_t samples = 0;
+  double sum[TOPIC_POLICY_FIELDS];
+  float lo[TOPIC_POLICY_FIELDS];
+  float hi[TOPIC_POLICY_FIELDS];
+  float avg[TOPIC_POLICY_FIELDS];
+
+  std::atomic<uint32_t> received;
+  std::atomic<uint32_t> published;
+
+  void store(const float* values, int n);
+
+public:
+  TopicPolicy();
+
+  //"pass", "decimate", "throttle" or "aggregate"
+  static bool parseMode(const std::string& name, TopicPolicyMode& mode);
+
+  //value: N for decimate, Hz for throttle, window [s] for aggregate. False if it is out of range
+  bool configure(TopicPolicyMode mode, double value);
+
+  //Frame decoded at now_ns (monotonic). True if its message should be published now
+  bool admit(uint64_t now_ns, const float* values = NULL, int n = 0);
+
+  TopicPolicyMode policy() {return mode;}
+  bool aggregating() {return mode == POLICY_AGGREGATE;}
+  const float* mean() {return avg;}   // latest values when not aggregating
+  const float* min() {return lo;}
+  const float* max() {return hi;}
+
+  uint32_t receivedCount() {return received;}
+  uint32_t publishedCount() {return published;}
+  std::string describe();           // e.g. "throttle 2 Hz"
+};
+//----------------------------------------------------------------
+#endif
@@ -0,0 +1,70 @@
+/*------------------------------------------------------------------------------------
+	Trace spans in per-thread ring buffers, dumped as Chrome trace JSON
+------------------------------------------------------------------------------------*/
+
+#ifndef Tracing_h
+#define Tracing_h
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+#include <string>
+
+// Spans are only compiled in with -DCAPTAIN_TRACING (cmake -DCAPTAIN_TRACING=ON).
+// Without it TRACE_SPAN and TRACE_THREAD expand to nothing.
+//
+// Each thread writes its own ring, so recording a span is two clock reads and a
+// store. The newest TRACE_RING_SIZE spans per thread are kept. Open the dump in
+// chrome://tracing or ui.perfetto.dev
+
+#define TRACE_RING_SIZE 16384    // spans per thread, power of two
+
+struct TraceEvent {
+  const char* name;              // string literal
+  uint64_t    start_ns;          // CLOCK_MONOTONIC
+  uint32_t    duration_ns;
+  int32_t     arg;               // message ID or byte count, -1 if unused
+};
+
+extern std::atomic<bool> trace_active;      // on by default when compiled in
+
+inline void trace_enable(bool enable) {trace_active = enable;}
+inline bool trace_enabled() {return trace_active.load(std::memory_order_relaxed);}
+void trace_thread_name(const char* name);     // label for this thread in the dump
+void trace_record(const char* name, uint64_t start_ns, uint64_t end_ns, int32_t arg);
+
+//Writes all rings as Chrome trace JSON. Safe while other threads keep recording
+bool trace_dump(const std::string& path);
+
+//Dump trigger. The handler only sets a flag, the dump is written by whoever polls it
+void trace_install_signal(int signum);
+bool trace_dump_requested();
+
+inline uint64_t trace_now_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//----------------------------------------------------------------
+class TraceSpan {
+  const char* name;
+  int32_t arg;
+  uint64_t start_ns;
+public:
+  TraceSpan(const char* _name, int32_t _arg) : name(_name), arg(_arg), start_ns(trace_enabled() ? trace_now_ns() : 0) {}
+  ~TraceSpan() {if(start_ns != 0) trace_record(name, start_ns, trace_now_ns(), arg);}
+};
+//----------------------------------------------------------------
+
+#ifdef CAPTAIN_TRACING
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(name, arg) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name, arg)
+#define TRACE_THREAD(name) trace_thread_name(name)
+#else
+#define TRACE_SPAN(name, arg) ((void) 0)
+#define TRACE_THREAD(name) ((void) 0)
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+/*------------------------------------------------------------------------------------
+	Priority classed transmit queue for scientist -> captain frames
+------------------------------------------------------------------------------------*/
+
+#ifndef TxScheduler_h
+#define TxScheduler_h
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+
+// A pending SC_ABORT is held in a slot of its own, sent before anything else
+// and never dropped. A newer abort replaces a pending one.
+
+enum TxClass {
+  TX_SAFETY = 0,    // Abort, heartbeat, done
+  TX_CONTROL,       // Setpoints and actuator commands
+  TX_BULK,          // Console, service requests and everything else
+  TX_N_CLASSES
+};
+
+enum TxDropPolicy {
+  TX_DROP_OLDEST,       // Full queue: drop the oldest frame
+  TX_DROP_NEWEST,       // Full queue: reject the new frame
+  TX_REPLACE_SAME_ID    // Replace a queued frame with the same ID, else drop oldest
+};
+
+struct TxClassStats {
+  uint32_t depth;
+  uint32_t max_depth;
+  uint32_t enqueued;
+  uint32_t sent;
+  uint32_t dropped;
+  double   latency_avg_us;    // Queueing latency since the previous stats() call
+  double   latency_max_us;
+};
+
+//----------------------------------------------------------------
+class TxScheduler {
+public:
+  typedef std::function<bool(char*, uint8_t)> SendFunction;
+  typedef std::chrono::steady_clock Clock;
+
+private:
+  struct TxFrame {
+    char     data[255];
+    uint8_t  len;
+    uint8_t  msgID;
+    Clock::time_point enqueued;
+  };
+
+  //Fixed capacity ring, allocated once in configure()
+  struct TxQueue {
+    std::vector<TxFrame> frames;
+    size_t head = 0;
+    size_t count = 0;
+    TxDropPolicy policy = TX_DROP_OLDEST;
+
+    TxFrame& at(size_t i) {return frames[(head + i) % frames.size()];};
+    bool push(const char* data, uint8_t len, uint32_t& dropped);
+    void pop() {head = (head + 1) % frames.size(); count--;};
+  };
+
+  TxQueue queues[TX_N_CLASSES];
+  TxFrame abort_frame;
+  bool abort_pending = false;
+  TxClassStats class_stats[TX_N_CLASSES];
+  double latency_sum_us[TX_N_CLASSES];
+  uint32_t sent_at_last_stats[TX_N_CLASSES];
+
+  //Token bucket for bulk traffic [bytes]
+  double bulk_rate = 0;       // 0 = unlimited
+  double bulk_burst = 0;
+  double bulk_tokens = 0;
+  Clock::time_point bulk_refill;
+
+  SendFunction send;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::thread tx_thread;
+  bool stopped = true;
+
+  void run();
+
+public:
+  TxScheduler(SendFunction send);
+  ~TxScheduler() {stop();};
+
+  void configure(TxClass c, size_t capacity, TxDropPolicy policy);
+  void setBulkRate(double bytes_per_sec, double burst_bytes);
+
+  void start();
+  void stop();
+
+  //Scheduling of the sending thread, e.g. for LinkTuning. Valid after start()
+  std::thread::native_handle_type thread() {return tx_thread.native_handle();};
+
+  //Queue a complete frame. Returns false if it was dropped
+  bool enqueue(const char* frame, uint8_t len);
+
+  static TxClass classify(uint8_t msgID);
+
+  //Current counters. Resets the latency window
+  TxClassStats stats(TxClass c);
+};
+//----------------------------------------------------------------
+#endif
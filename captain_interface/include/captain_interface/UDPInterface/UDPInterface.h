@@ -30,6 +30,7 @@ public:
   void setup(udp::socket* socket, udp::endpoint* endpoint);
   void loop();
   void stop() {stopped = true;};
+  void applyLinkProfile(const LinkProfile& profile, std::vector<std::string>& report);
 };
 //----------------------------------------------------------------
 #endif
@@ -0,0 +1,97 @@
+/*------------------------------------------------------------------------------------
+	Cache of the latest decoded vehicle state
+------------------------------------------------------------------------------------*/
+
+#ifndef VehicleState_h
+#define VehicleState_h
+
+#include <stdint.h>
+#include "../Seqlock.h"
+
+#define VEHICLESTATE_N_CONTROLLERS 13
+
+//Order of the enable flags in CS_CTRL_STATUS
+enum VehicleStateController {
+  CONTROLLER_WAYPOINT = 0,
+  CONTROLLER_YAW,
+  CONTROLLER_YAWRATE,
+  CONTROLLER_DEPTH,
+  CONTROLLER_ALTITUDE,
+  CONTROLLER_PITCH,
+  CONTROLLER_SPEED,
+  CONTROLLER_RPM,
+  CONTROLLER_RPM_STRB,
+  CONTROLLER_RPM_PORT,
+  CONTROLLER_ELEVATOR,
+  CONTROLLER_RUDDER,
+  CONTROLLER_VBS
+};
+
+//All timestamps are captain time in microseconds, 0 if never received
+struct ControlSurfaceState {
+  uint64_t timestamp;
+  float    target_angle;
+  float    angle;
+};
+
+struct ThrusterState {
+  uint64_t timestamp;
+  float    rpm_setpoint;
+  float    rpm;
+  float    current;
+  float    torque;
+  float    energy;
+  float    voltage;
+};
+
+struct AttitudeState {
+  uint64_t timestamp;
+  float    roll, pitch, yaw;                    // [rad]
+  float    roll_rate, pitch_rate, yaw_rate;     // [rad/s]
+};
+
+struct PositionState {
+  uint64_t timestamp;
+  double   latitude, longitude;                 // [deg]
+  float    depth, altitude;                     // [m]
+};
+
+struct CaptainState {
+  uint64_t timestamp;
+  uint8_t  active_control_input;                // lolo_msgs::CaptainStatus constants
+  double   target_latitude, target_longitude;   // [deg]
+  float    target_yaw, target_pitch, target_speed, target_rpm, target_depth, target_altitude;
+};
+
+struct VehicleState {
+  ControlSurfaceState rudder;
+  ControlSurfaceState elevator;
+  ControlSurfaceState elevon_port;
+  ControlSurfaceState elevon_strb;
+  ThrusterState       thruster_port;
+  ThrusterState       thruster_strb;
+  AttitudeState       attitude;
+  PositionState       position;
+  CaptainState        captain;
+  uint32_t            controller_updates;       // Number of CS_CTRL_STATUS received
+  bool                controller_enabled[VEHICLESTATE_N_CONTROLLERS];
+  uint32_t            leaks;                    // Number of CS_LEAK received
+};
+
+//----------------------------------------------------------------
+// Written from the receive thread only. edit() gives the writer's own
+// copy, commit() makes it visible. snapshot() is safe from any thread.
+class VehicleStateCache {
+  VehicleState current;
+  Seqlock<VehicleState> shared;
+
+public:
+  VehicleStateCache() : current() {};
+
+  VehicleState& edit() {return current;};
+  void commit() {shared.store(current);};
+
+  VehicleState snapshot() const {return shared.load();};
+};
+//----------------------------------------------------------------
+#endif
@@ -0,0 +1,30 @@
+/*------------------------------------------------------------------------------------
+	Captain protocol: public headers of the captain_protocol library
+------------------------------------------------------------------------------------*/
+
+#ifndef captain_protocol_h
+#define captain_protocol_h
+
+// Framing, checksums, message codec and transports, without ROS. The ROS node
+// (RosInterFace) only maps these messages to topics and services.
+
+#include "scientistmsg.h"                             // message IDs
+#include "CaptainInterFace/CaptainInterFace.h"        // framing, callbacks
+#include "MessageCodec/MessageCodec.h"                // payload layouts and decoding
+#include "Crc32c/Crc32c.h"                            // frame trailer
+#include "FrameScanner/FrameScanner.h"                // frames in recorded streams
+#include "TxScheduler/TxScheduler.h"                  // prioritized sending
+#include "RxDispatcher/RxDispatcher.h"                // receive lanes
+#include "ClockSync/ClockSync.h"                      // captain clock offset
+#include "BlackBox/BlackBox.h"                        // recent traffic, dumped on events
+#include "Log/Log.h"                                  // asynchronous logging
+#include "UDPInterface/UDPInterface.h"                // transports
+#include "SerialInterface/SerialInterface.h"
+#include "RedundantInterface/RedundantInterface.h"
+#include "PathUpload/PathUpload.h"                    // SC_SET_PATH batches
+#include "StreamControl/StreamControl.h"              // demand driven CS_* streams
+#include "LinkTuning/LinkTuning.h"                    // socket and I/O thread profile
+#include "TopicPolicy/TopicPolicy.h"                  // decimation and aggregation of topics
+#include "FrameRelay/FrameRelay.h"                    // frame fan-out to local processes
+
+#endif
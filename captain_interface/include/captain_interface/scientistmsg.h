@@ -11,6 +11,12 @@
 //V1.1
 //2021 11 06
 
+//BOTH WAYS
+#define LINK_HELLO          0   // scientist: hello + requested LINK_CAP_*, captain: reply + accepted LINK_CAP_*
+
+//Link options negotiated with the hello
+#define LINK_CAP_CRC32C     0x01 // CRC32C trailer (4 bytes, LSB first) instead of the XOR checksum
+
 //CAPTAIN -> SCIENTIST
 #define CS_LEAK             7
 #define CS_STATUS           8
@@ -58,6 +64,7 @@
 #define SC_SET_TARGET_DEPTH      170
 #define SC_SET_TARGET_ALTITUDE   171
 #define SC_SET_TARGET_WAYPOINT   172
+#define SC_SET_PATH              173  // waypoint list, see PathUpload.h
 #define SC_MENUSTREAM            200
 
 //Service ID:s
@@ -69,6 +76,7 @@
 #define SERVICE_CONTROLLER_DEPTH     215
 #define SERVICE_CONTROLLER_ALTITUDE  216
 #define SERVICE_CONTROLLER_SPEED     217
+#define SERVICE_STREAM               220  // enable, disable or re-rate a CS_* stream, see StreamControl.h
 
 #define SERVICE_ACTION_FAIL     0
 #define SERVICE_ACTION_SUCCESS  1
@@ -40,8 +40,9 @@ class srvHandler:
     Callback for the SetBool service
     """
 
-    #Send request to the captain
-    ref = random.randrange(0,32000)
+    #Send request to the captain. Refs from 0x4000 up are taken by the stream
+    #(0x4000) and path upload (0x8000) acknowledgements handled in the node
+    ref = random.randrange(0,0x4000)
     request = CaptainService()
     request.id = self.request_id
     request.ref = ref
@@ -0,0 +1,286 @@
+#!/usr/bin/env python
+"""
+Captain stand-in for bench tests without the vehicle. Does not need ROS.
+
+Listens on UDP like the captain, answers the hello (with CRC32C if requested),
+acknowledges service requests and waypoint path uploads, and sends simulated
+IMU, position, actuator and status frames.
+
+Streams can be enabled, disabled and re-rated with SERVICE_STREAM requests like
+the captain does. --report prints the telemetry bandwidth, to compare runs with
+and without the interface's stream_control.
+
+Telemetry goes to every address heard from in the last few seconds, so the
+redundant transport gets a copy on each path. Commands that arrive twice (one
+per path) are executed once.
+
+  rosrun captain_interface captain_standin.py --port 8889 --report
+  roslaunch captain_interface interface.launch captain_ip:=127.0.0.1 captain_port:=8889
+"""
+
+import argparse
+import math
+import random
+import socket
+import struct
+import time
+
+#from scientistmsg.h
+LINK_HELLO              = 0
+LINK_CAP_CRC32C         = 0x01
+CS_STATUS               = 8
+CS_RUDDER               = 10
+CS_ELEVATOR             = 12
+CS_THRUSTER_PORT        = 13
+CS_THRUSTER_STRB        = 14
+CS_IMU                  = 18
+CS_ELEVON_STRB          = 21
+CS_ELEVON_PORT          = 22
+CS_POSITION             = 24
+CS_REQUEST_OUT          = 100
+SC_REQUEST_IN           = 101
+SC_SET_TARGET_WAYPOINT  = 172
+SC_SET_PATH             = 173
+
+SERVICE_STREAM          = 220
+
+SERVICE_ACTION_FAIL     = 0
+SERVICE_ACTION_SUCCESS  = 1
+SERVICE_ACTION_ENABLE   = 1
+
+NAMES = {150: "heartbeat", 151: "abort", 152: "done", 161: "rudder", 162: "elevator",
+         163: "thruster port", 164: "thruster strb", 165: "target pitch", 166: "target yaw",
+         167: "target yaw rate", 168: "target speed", 169: "target rpm", 170: "target depth",
+         171: "target altitude", 200: "menu"}
+
+
+def make_crc32c_table():
+    table = []
+    for i in range(256):
+        c = i
+        for _ in range(8):
+            c = (c >> 1) ^ 0x82F63B78 if c & 1 else c >> 1
+        table.append(c)
+    return table
+
+CRC32C_TABLE = make_crc32c_table()
+
+
+def crc32c(data):
+    crc = 0xFFFFFFFF
+    for b in bytearray(data):
+        crc = CRC32C_TABLE[(crc ^ b) & 0xFF] ^ (crc >> 8)
+    return crc ^ 0xFFFFFFFF
+
+
+def xor(data):
+    cs = 0
+    for b in bytearray(data):
+        cs ^= b
+    return cs
+
+
+def frame(msg_id, payload, crc):
+    body = bytearray([ord('#'), msg_id]) + bytearray(payload)
+    if crc:
+        body += bytearray([len(body) + 6, ord('*')])
+        return bytes(body + struct.pack('<I', crc32c(body)))
+    body += bytearray([len(body) + 3, ord('*')])
+    return bytes(body + bytearray([xor(body)]))
+
+
+def parse_frames(data):
+    """Yields (msg_id, payload, crc) for every valid frame in a datagram"""
+    data = bytearray(data)
+    i = 0
+    while i < len(data):
+        if data[i] != ord('#'):
+            i += 1
+            continue
+        found = False
+        for trailer, crc in ((1, False), (4, True)):
+            for end in range(i + 4 + trailer, len(data) + 1):
+                length = end - i
+                if data[end - trailer - 2] != length or data[end - trailer - 1] != ord('*'):
+                    continue
+                body = data[i:end - trailer]
+                if crc and struct.unpack('<I', bytes(data[end - 4:end]))[0] != crc32c(body):
+                    continue
+                if not crc and data[end - 1] != xor(body):
+                    continue
+                yield data[i + 1], bytes(data[i + 2:end - trailer - 2]), crc
+                i = end
+                found = True
+                break
+            if found:
+                break
+        if not found:
+            i += 1
+
+
+def llong(t):
+    # CaptainInterFace::parse_llong: most significant long first
+    return struct.pack('<II', (t >> 32) & 0xFFFFFFFF, t & 0xFFFFFFFF)
+
+
+class CaptainStandIn:
+
+    def __init__(self, args):
+        self.args = args
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(('', args.port))
+        self.sock.settimeout(0.01)
+        self.scientists = {}     # address -> last time heard
+        self.recent_commands = {}  # (msg_id, payload) -> time, to drop the copy from the other path
+        self.crc = False
+        self.path = []
+        self.target = (0.0, 0.0)
+        self.lat = math.radians(args.lat)
+        self.lon = math.radians(args.lon)
+        # stream -> [default rate, rate (0 = off), next send time, sequence]
+        self.streams = {CS_STATUS: [1.0], CS_IMU: [args.rate], CS_POSITION: [args.rate]}
+        for stream in (CS_RUDDER, CS_ELEVATOR, CS_ELEVON_PORT, CS_ELEVON_STRB, CS_THRUSTER_PORT, CS_THRUSTER_STRB):
+            self.streams[stream] = [args.actuator_rate]
+        for s in self.streams.values():
+            s += [s[0], time.time(), 0]
+        self.tx_bytes = 0
+        self.tx_frames = 0
+
+    def send(self, msg_id, payload, crc=None):
+        data = frame(msg_id, payload, self.crc if crc is None else crc)
+        now = time.time()
+        for address, heard in list(self.scientists.items()):
+            if now - heard > 5.0:
+                del self.scientists[address]
+            elif self.args.tx_drop <= 0 or random.random() >= self.args.tx_drop:
+                self.sock.sendto(data, address)
+                self.tx_bytes += len(data)
+                self.tx_frames += 1
+
+    def duplicate(self, msg_id, payload):
+        now = time.time()
+        for key, t in list(self.recent_commands.items()):
+            if now - t > 0.5:
+                del self.recent_commands[key]
+        key = (msg_id, payload)
+        if key in self.recent_commands:
+            return True
+        self.recent_commands[key] = now
+        return False
+
+    def handle(self, msg_id, payload, crc):
+        if self.args.drop > 0 and msg_id != LINK_HELLO and random.random() < self.args.drop:
+            print("dropped frame %d" % msg_id)
+            return
+
+        if msg_id == LINK_HELLO:
+            requested = bytearray(payload)[0] if payload else 0
+            accepted = requested & (0 if self.args.no_crc else LINK_CAP_CRC32C)
+            self.send(LINK_HELLO, bytearray([accepted]), crc=False)
+            if bool(accepted & LINK_CAP_CRC32C) != self.crc:
+                self.crc = bool(accepted & LINK_CAP_CRC32C)
+                print("link integrity: %s" % ("CRC32C" if self.crc else "XOR"))
+            return
+
+        if self.crc and not crc:
+            return  # only the hello may use XOR in CRC mode
+
+        if self.duplicate(msg_id, payload):
+            return
+
+        if msg_id == SC_SET_PATH:
+            ref, start, total, n = struct.unpack('<HHHB', payload[:7])
+            points = [struct.unpack('<dd', payload[7 + 16 * i:23 + 16 * i]) for i in range(n)]
+            if start + n > total:
+                self.send(CS_REQUEST_OUT, struct.pack('<HB', ref, SERVICE_ACTION_FAIL))
+                return
+            self.path = (self.path + [(0.0, 0.0)] * total)[:total]
+            self.path[start:start + n] = points
+            self.send(CS_REQUEST_OUT, struct.pack('<HB', ref, SERVICE_ACTION_SUCCESS))
+            print("path: %d points, received %d-%d" % (total, start, start + n))
+            if self.path:
+                self.target = self.path[0]
+
+        elif msg_id == SC_REQUEST_IN:
+            ref, service, action = struct.unpack('<HBB', payload[:4])
+            if service == SERVICE_STREAM:
+                self.send(CS_REQUEST_OUT, struct.pack('<HB', ref, self.stream_request(action, payload[4:])))
+                return
+            print("service %d action %d" % (service, action))
+            self.send(CS_REQUEST_OUT, struct.pack('<HB', ref, SERVICE_ACTION_SUCCESS))
+
+        elif msg_id == SC_SET_TARGET_WAYPOINT:
+            self.target = struct.unpack('<dd', payload[:16])
+            print("waypoint %.6f %.6f" % (math.degrees(self.target[0]), math.degrees(self.target[1])))
+
+        elif msg_id in NAMES and self.args.verbose:
+            print("%s %s" % (NAMES[msg_id], repr(payload)))
+
+    def stream_request(self, action, payload):
+        if self.args.no_stream_control or len(payload) < 5:
+            return SERVICE_ACTION_FAIL
+        stream, rate = struct.unpack('<Bf', payload[:5])
+        if stream not in self.streams:
+            return SERVICE_ACTION_FAIL
+        s = self.streams[stream]
+        new_rate = (rate if rate > 0 else s[0]) if action == SERVICE_ACTION_ENABLE else 0
+        if new_rate != s[1]:
+            print("stream %d: %s" % (stream, "%g Hz" % new_rate if new_rate > 0 else "off"))
+        s[1] = new_rate
+        return SERVICE_ACTION_SUCCESS
+
+    def payload(self, stream):
+        t = int(time.time() * 1e6)
+        self.streams[stream][3] += 1
+        head = llong(t) + struct.pack('<I', self.streams[stream][3])
+        if stream == CS_STATUS:
+            return head + struct.pack('<Bdd6f', 3, self.target[0], self.target[1], 0, 0, 1.0, 500, 1.0, 0)
+        if stream == CS_IMU:
+            return head + struct.pack('<6f', 0.0, 0.0, 0.5, 0.0, 0.0, 0.0)
+        if stream == CS_POSITION:
+            return head + struct.pack('<ddff', self.lat, self.lon, 1.0, 20.0)
+        if stream in (CS_THRUSTER_PORT, CS_THRUSTER_STRB):
+            return head + struct.pack('<6f', 500, 498, 2.0, 0.5, 10.0, 48.0)
+        return head + struct.pack('<2f', 0.0, 0.0)   # control surfaces: target and current angle
+
+    def telemetry(self, now):
+        for stream, s in self.streams.items():
+            if s[1] > 0 and now >= s[2]:
+                self.send(stream, self.payload(stream))
+                s[2] = max(s[2] + 1.0 / s[1], now)
+
+    def run(self):
+        print("captain stand-in on udp port %d" % self.args.port)
+        next_report = time.time() + self.args.report
+        while True:
+            try:
+                data, address = self.sock.recvfrom(1024)
+                self.scientists[address] = time.time()
+                for msg_id, payload, crc in parse_frames(data):
+                    self.handle(msg_id, payload, crc)
+            except socket.timeout:
+                pass
+            now = time.time()
+            self.telemetry(now)
+            if self.args.report > 0 and now >= next_report:
+                on = sorted(stream for stream, s in self.streams.items() if s[1] > 0)
+                print("telemetry: %.0f B/s, %.1f frames/s, streams on: %s" % (self.tx_bytes / self.args.report,
+                      self.tx_frames / self.args.report, " ".join(str(stream) for stream in on)))
+                self.tx_bytes = self.tx_frames = 0
+                next_report = now + self.args.report
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--port', type=int, default=8889, help='udp port, 8888 is used by the interface')
+    parser.add_argument('--rate', type=float, default=10.0, help='imu and position rate [Hz]')
+    parser.add_argument('--actuator-rate', type=float, default=10.0, help='rudder, elevator, elevon and thruster rate [Hz]')
+    parser.add_argument('--lat', type=float, default=58.25, help='simulated latitude [deg]')
+    parser.add_argument('--lon', type=float, default=11.45, help='simulated longitude [deg]')
+    parser.add_argument('--drop', type=float, default=0.0, help='fraction of received frames to ignore')
+    parser.add_argument('--tx-drop', type=float, default=0.0, help='fraction of sent frames to drop, per address')
+    parser.add_argument('--no-crc', action='store_true', help='do not accept CRC32C')
+    parser.add_argument('--no-stream-control', action='store_true', help='reject SERVICE_STREAM requests like older captains')
+    parser.add_argument('--report', type=float, default=0.0, help='print the telemetry bandwidth every REPORT seconds')
+    parser.add_argument('--verbose', action='store_true', help='print all setpoints')
+    CaptainStandIn(parser.parse_args()).run()
@@ -0,0 +1,40 @@
+#include <captain_interface/AllocTracker/AllocTracker.h>
+#include <stdlib.h>
+#include <new>
+
+// Linked into the interface executable only, so the exported libraries do not
+// replace the allocator of every node that links them.
+
+static const bool registered = (alloc_hooks_register(), true);
+
+//----------------------------------------------------------------
+//---------------------Global allocation hooks--------------------
+//----------------------------------------------------------------
+void* operator new(std::size_t size) {
+  alloc_count();
+  void* p = malloc(size ? size : 1);
+  if(p == NULL) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](std::size_t size) {
+  alloc_count();
+  void* p = malloc(size ? size : 1);
+  if(p == NULL) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  alloc_count();
+  return malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  alloc_count();
+  return malloc(size ? size : 1);
+}
+
+void operator delete(void* p) noexcept {free(p);}
+void operator delete[](void* p) noexcept {free(p);}
+void operator delete(void* p, const std::nothrow_t&) noexcept {free(p);}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {free(p);}
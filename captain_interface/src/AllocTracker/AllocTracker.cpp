@@ -0,0 +1,28 @@
+#include <captain_interface/AllocTracker/AllocTracker.h>
+
+AllocCounters alloc_counters;
+
+static std::atomic<bool> tracking(false);
+static std::atomic<bool> hooks(false);
+static thread_local int alloc_scope = ALLOC_SCOPE_NONE;
+
+void alloc_tracking_enable(bool enable) {tracking = enable;}
+bool alloc_tracking_enabled() {return tracking;}
+
+void alloc_hooks_register() {hooks = true;}
+bool alloc_hooks_installed() {return hooks;}
+
+void alloc_counters_reset() {
+  for(int i=0;i<256;i++) alloc_counters.decode[i].store(0, std::memory_order_relaxed);
+  alloc_counters.publish.store(0, std::memory_order_relaxed);
+}
+
+AllocScope::AllocScope(int id) : previous(alloc_scope) {alloc_scope = id;}
+AllocScope::~AllocScope() {alloc_scope = previous;}
+
+void alloc_count() {
+  int scope = alloc_scope;
+  if(scope == ALLOC_SCOPE_NONE || !tracking.load(std::memory_order_relaxed)) return;
+  if(scope == ALLOC_SCOPE_PUBLISH) alloc_counters.publish.fetch_add(1, std::memory_order_relaxed);
+  else alloc_counters.decode[scope & 0xFF].fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,171 @@
+#include <captain_interface/BlackBox/BlackBox.h>
+#include <captain_interface/ClockSync/ClockSync.h>
+#include <captain_interface/Tracing/Tracing.h>
+#include <captain_interface/Log/Log.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+
+BlackBox::BlackBox() {
+  head = 0;
+  counters.recorded = 0;
+  counters.dumps = 0;
+  counters.suppressed = 0;
+}
+
+void BlackBox::configure(size_t frames, double _seconds, double _post_trigger, const std::string& _dir) {
+  std::lock_guard<std::mutex> lock(dump_mutex);
+  n_slots = frames;
+  slots.reset(frames > 0 ? new Slot[frames] : NULL);
+  for(size_t i=0;i<n_slots;i++) slots[i].seq.store(0, std::memory_order_relaxed);
+  snapshot.resize(frames);
+  head = 0;
+  seconds = _seconds;
+  post_trigger = _post_trigger;
+  dir = _dir;
+}
+
+//----------------------------------------------------------------
+void BlackBox::record(uint8_t direction, uint8_t msgID, const char* payload, uint8_t len, uint64_t time_ns) {
+  if(n_slots == 0) return;
+  uint64_t i = head.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots[i % n_slots];
+
+  slot.seq.store(2*i+1, std::memory_order_relaxed);    //odd: write in progress
+  std::atomic_thread_fence(std::memory_order_release);
+  BlackBoxRecord& r = slot.record;
+  r.time_ns = time_ns;
+  r.dir = direction;
+  r.msgID = msgID;
+  r.len = std::min(len, (uint8_t) sizeof(r.payload));
+  memcpy(r.payload, payload, r.len);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.seq.store(2*i+2, std::memory_order_relaxed);    //even: consistent
+}
+
+void BlackBox::record_frame(uint8_t direction, const char* frame, uint8_t len, bool crc, uint64_t time_ns) {
+  //'#', ID, payload, length, '*', then 1 (XOR) or 4 (CRC32C) checksum bytes
+  uint8_t trailer = crc ? 4 : 1;
+  if(len < 4 + trailer) return;
+  record(direction, frame[1], frame + 2, len - 4 - trailer, time_ns);
+}
+
+void BlackBox::checksum_error() {
+  if(n_slots == 0) return;
+  uint64_t now = realtime_ns();
+  bool burst;
+  {
+    std::lock_guard<std::mutex> lock(error_mutex);
+    if(now - error_window_start > burst_window * 1e9) {
+      error_window_start = now;
+      error_count = 0;
+    }
+    burst = ++error_count == burst_errors;
+  }
+  if(burst) trigger("checksum_errors");
+}
+
+//----------------------------------------------------------------
+void BlackBox::start() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if(!stopped || n_slots == 0) return;
+  stopped = false;
+  dump_thread = std::thread(&BlackBox::run, this);
+}
+
+void BlackBox::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+  }
+  cv.notify_one();
+  if(dump_thread.joinable()) dump_thread.join();
+}
+
+void BlackBox::trigger(const char* reason) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(stopped) return;
+    if(!pending.empty()) return;    //already waiting to dump
+    if(last_dump_ns != 0 && realtime_ns() - last_dump_ns < seconds * 1e9) {
+      counters.suppressed++;
+      return;
+    }
+    pending = reason;
+  }
+  cv.notify_one();
+}
+
+void BlackBox::run() {
+  TRACE_THREAD("blackbox");
+  std::unique_lock<std::mutex> lock(mutex);
+  while(!stopped) {
+    if(pending.empty()) { cv.wait(lock); continue; }
+
+    //Include what happened after the event
+    cv.wait_for(lock, std::chrono::duration<double>(post_trigger), [this] {return stopped;});
+    std::string reason = pending;
+    lock.unlock();
+    std::string path = dump(reason.c_str());
+    if(path.empty()) CLOG_ERROR("Black box: could not write dump to %s", dir.c_str());
+    else CLOG_WARN("Black box: %s, written to %s", reason.c_str(), path.c_str());
+    lock.lock();
+    pending.clear();
+  }
+}
+
+//----------------------------------------------------------------
+std::string BlackBox::dump(const char* reason) {
+  if(n_slots == 0) return "";
+  std::lock_guard<std::mutex> dump_lock(dump_mutex);
+  uint64_t now = realtime_ns();
+
+  //Consistent copies of the last n_slots records, oldest first
+  uint64_t end = head.load(std::memory_order_acquire);
+  uint64_t begin = end > n_slots ? end - n_slots : 0;
+  size_t n = 0;
+  for(uint64_t i=begin;i<end;i++) {
+    Slot& slot = slots[i % n_slots];
+    uint64_t s1 = slot.seq.load(std::memory_order_acquire);
+    if(s1 != 2*i+2) continue;            //being written, or already overwritten
+    snapshot[n] = slot.record;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(slot.seq.load(std::memory_order_relaxed) != s1) continue;
+    if(snapshot[n].time_ns + (uint64_t) (seconds * 1e9) < now) continue;   //older than the window
+    n++;
+  }
+
+  char stamp[32];
+  time_t t = now / 1000000000ULL;
+  strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&t));
+  std::string path = dir + "/captain_blackbox_" + stamp + "_" + reason + ".csv";
+
+  FILE* f = fopen(path.c_str(), "w");
+  if(f == NULL) return "";
+  fprintf(f, "# captain_interface black box: %s at %llu ns, %zu frames\n", reason, (unsigned long long) now, n);
+  fprintf(f, "time_ns,dir,id,len,payload\n");
+  for(size_t i=0;i<n;i++) {
+    const BlackBoxRecord& r = snapshot[i];
+    fprintf(f, "%llu,%s,%u,%u,", (unsigned long long) r.time_ns, r.dir == BLACKBOX_TX ? "tx" : "rx", r.msgID, r.len);
+    for(int b=0;b<r.len;b++) fprintf(f, "%02x", (uint8_t) r.payload[b]);
+    fprintf(f, "\n");
+  }
+  bool ok = ferror(f) == 0;
+  ok &= fclose(f) == 0;
+  if(!ok) return "";
+
+  std::lock_guard<std::mutex> lock(mutex);
+  last_dump_ns = now;
+  counters.dumps++;
+  counters.last_dump = path;
+  return path;
+}
+
+BlackBoxStats BlackBox::stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  BlackBoxStats s = counters;
+  s.recorded = head.load(std::memory_order_relaxed);
+  return s;
+}
@@ -0,0 +1,88 @@
+#include <captain_interface/CallbackSpinner/CallbackSpinner.h>
+#include <captain_interface/Tracing/Tracing.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <algorithm>
+
+CallbackSpinner::CallbackSpinner(const std::string& _name) : name(_name) {
+  running = false;
+  probe.reset(new Probe(this));
+};
+
+void CallbackSpinner::start() {
+  if(running) return;
+  running = true;
+  spin_thread = std::thread(&CallbackSpinner::run, this);
+}
+
+void CallbackSpinner::stop() {
+  running = false;
+  if(spin_thread.joinable()) spin_thread.join();
+}
+
+void CallbackSpinner::apply_thread_profile() {
+  if(cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if(err != 0) ROS_WARN("%s callbacks: could not pin to cpu %d: %s", name.c_str(), cpu, strerror(err));
+  }
+  if(priority > 0) {
+    sched_param param;
+    param.sched_priority = priority;
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if(err != 0) ROS_WARN("%s callbacks: could not set realtime priority %d: %s", name.c_str(), priority, strerror(err));
+  }
+}
+
+//----------------------------------------------------------------
+void CallbackSpinner::run() {
+  apply_thread_profile();
+  TRACE_THREAD(("spin_" + name).c_str());
+
+  while(running && ros::ok()) {
+    Clock::time_point now = Clock::now();
+    if(!probe_pending && std::chrono::duration<double>(now - probe_sent).count() >= probe_interval) {
+      probe_pending = true;
+      probe_sent = now;
+      queue.addCallback(probe);
+    }
+
+    bool was_probe = probe_pending;
+    Clock::time_point t0 = Clock::now();
+    ros::CallbackQueue::CallOneResult result = queue.callOne(ros::WallDuration(0.01));
+    if(result != ros::CallbackQueue::Called) continue;
+    if(was_probe && !probe_pending) continue; //Only the probe ran
+
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    callbacks++;
+    callback_max_ms = std::max(callback_max_ms, ms);
+  }
+}
+
+void CallbackSpinner::probe_called() {
+  double ms = std::chrono::duration<double, std::milli>(Clock::now() - probe_sent).count();
+  probe_pending = false;
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  probes++;
+  delay_sum_ms += ms;
+  delay_max_ms = std::max(delay_max_ms, ms);
+}
+
+CallbackQueueStats CallbackSpinner::stats() {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  CallbackQueueStats s;
+  s.callbacks = callbacks;
+  s.delay_avg_ms = probes > 0 ? delay_sum_ms / probes : 0;
+  s.delay_max_ms = delay_max_ms;
+  s.callback_max_ms = callback_max_ms;
+  callbacks = 0;
+  probes = 0;
+  delay_sum_ms = 0;
+  delay_max_ms = 0;
+  callback_max_ms = 0;
+  return s;
+}
@@ -1,11 +1,25 @@
 #include <captain_interface/CaptainInterFace/CaptainInterFace.h>
+#include <captain_interface/TxScheduler/TxScheduler.h>
+#include <captain_interface/Crc32c/Crc32c.h>
+#include <captain_interface/Tracing/Tracing.h>
+#include <captain_interface/scientistmsg.h>
+#include <captain_interface/BlackBox/BlackBox.h>
+#include <captain_interface/ClockSync/ClockSync.h>
+#include <captain_interface/Log/Log.h>
+#include <stdio.h>
+
+thread_local char CaptainInterFace::send_buffer[255];
+thread_local uint8_t CaptainInterFace::send_len = 0;
 
 CaptainInterFace::CaptainInterFace() {
-  //Do something?
+  for(int i=0;i<256;i++) counters.received[i] = 0;
+  counters.checksum_errors = 0;
+  counters.sent = 0;
+  crc_mode = false;
 };
 
 //----------------------------------------------------------------
-uint8_t CaptainInterFace::calc_checksum(char* buffer, uint8_t len) {
+uint8_t CaptainInterFace::calc_checksum(const char* buffer, uint8_t len) {
   uint8_t chk = 0;
   for (int ii = 0; ii < len; ii++) { chk = chk ^ buffer[ii]; } // XOR
   return chk;
@@ -15,40 +29,78 @@ bool CaptainInterFace::parse_data(char c) {
   //Serial.print("received: 0x"); Serial.println(c,HEX);
   receive_buffer.put(c);
   package_available = false; //New data added. so the old package has been overwrittern
-  if(waitForCS) {if(parse_package()) {waitForCS=false; return true;}} // c was CS. check if the message is correct and set package_available to TRUE
+  if(waitForCS) {if(parse_package(1)) {waitForCS=false; return true;}} // c was CS. check if the message is correct and set package_available to TRUE
+  if(crc_mode && receive_buffer.get(4) == '*') {if(parse_package(4)) {waitForCS=false; return true;}} // c was the last CRC byte
   if(c == 0x2A) {waitForCS = true; } //next byte is the Checksum
   else waitForCS = false;
   return true;
 }
 
-bool CaptainInterFace::parse_package() {
-  uint8_t CS = receive_buffer.get(0);           // newest byte is CS
-                                                // 2:nd newest byte is '*'
-  uint8_t length = receive_buffer.get(2);       // 3:nd newest byte is length
-  uint8_t start = receive_buffer.get(length-1); // start byte. Should be '#'
+bool CaptainInterFace::inject(const char* data, size_t len) {
+  for(size_t i=0;i<len;i++) parse_data(data[i]);
+  return true;
+}
+
+bool CaptainInterFace::parse_package(uint8_t trailer) {
+  TRACE_SPAN("frame", trailer);
+                                                      // newest bytes are the checksum (1 or 4 bytes)
+                                                      // then '*'
+  uint8_t length = receive_buffer.get(trailer+1);     // then length
+  if(length < trailer+4) return false;
+  uint8_t start = receive_buffer.get(length-1);       // start byte. Should be '#'
 
   //Error checks
   if(start != '#'){
     return false; //Something is wrong with the package.
   }
 
-  uint8_t checksum = 0;
-  for (int ii = length-1; ii >0 ; ii--) { checksum = checksum ^ receive_buffer.get(ii); } // XOR
-  if(checksum != CS) { printf("Checksum error: message length: %d\n", length); return false; }; //CS does not match
+  //In CRC mode only the hello uses the XOR checksum
+  uint8_t id = receive_buffer.get(length-2);
+  if(crc_mode && trailer == 1 && id != LINK_HELLO) return false;
+
+  if(trailer == 1) {
+    uint8_t CS = receive_buffer.get(0);
+    uint8_t checksum = 0;
+    for (int ii = length-1; ii >0 ; ii--) { checksum = checksum ^ receive_buffer.get(ii); } // XOR
+    if(checksum != CS) { counters.checksum_errors++; if(blackbox != NULL) blackbox->checksum_error(); CLOG_WARN("Checksum error: message length: %d", length); return false; }; //CS does not match
+  }
+  else {
+    char frame[CIRCLEBUFFER_SIZE];
+    for(int i=0;i<length-4;i++) frame[i] = receive_buffer.get(length-1-i); // '#' to '*'
+    uint32_t crc = receive_buffer.get(3) | (receive_buffer.get(2) << 8) | (receive_buffer.get(1) << 16) | ((uint32_t) receive_buffer.get(0) << 24);
+    if(crc32c(frame, length-4) != crc) { counters.checksum_errors++; if(blackbox != NULL) blackbox->checksum_error(); CLOG_WARN("CRC error: message length: %d", length); return false; };
+  }
 
   unpack_index = length-2;
+  package_length = length;
+  package_trailer = trailer;
   package_available = true;
 
   msgID = parse_byte();
+  counters.received[msgID]++;
 
-  if(cb != NULL) {
-    cb();
-    clear_package();
-  }
+  if(package_received()) clear_package();
+  return true;
+}
 
+bool CaptainInterFace::package_received() {
+  if(msgID == LINK_HELLO) {
+    parse_hello();
+    return true;
+  }
+  if(cb == NULL) return false; //Left for the owner to copy
+  cb();
   return true;
 }
 
+void CaptainInterFace::parse_hello() {
+  //Reply from the captain with the accepted options. No options from older captains
+  uint8_t accepted = package_length > 5 ? parse_byte() : 0;
+  bool crc = (accepted & link_capabilities & LINK_CAP_CRC32C) != 0;
+  if(crc != crc_mode) CLOG_INFO("Captain link integrity: %s", crc ? "CRC32C" : "XOR");
+  crc_mode = crc;
+}
+
 void CaptainInterFace::clear_package() {
   unpack_index = 0;
   package_available = false;
@@ -60,38 +112,134 @@ void CaptainInterFace::clear_package() {
 }
 
 
+uint8_t CaptainInterFace::copy_package(char* out) {
+  // Payload is everything between msgID and the length byte
+  if(!package_available) return 0;
+  uint8_t len = package_length - 4 - package_trailer;
+  for(int i=0;i<len;i++) out[i] = receive_buffer.get(package_length-3-i);
+  return len;
+}
+
+uint8_t CaptainInterFace::copy_frame(char* out) {
+  if(!package_available) return 0;
+  uint8_t n = package_length - 2 - package_trailer; // '#', ID and payload
+  for(int i=0;i<n;i++) out[i] = receive_buffer.get(package_length-1-i);
+  return finish_frame(out, n, false);
+}
+
+bool CaptainInterFace::has_sequence_header(uint8_t id) {
+  switch(id) {
+    case CS_STATUS:
+    case CS_RUDDER:
+    case CS_ELEVATOR:
+    case CS_THRUSTER_PORT:
+    case CS_THRUSTER_STRB:
+    case CS_IMU:
+    case CS_ELEVON_STRB:
+    case CS_ELEVON_PORT:
+    case CS_POSITION:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool CaptainInterFace::validate_frame(const char* frame, uint8_t len) {
+  if(len < 5 || frame[0] != '#' || frame[len-2] != '*') return false;
+  if((uint8_t) frame[len-3] != len) return false;
+  return calc_checksum(frame, len-1) == (uint8_t) frame[len-1];
+}
+
 void CaptainInterFace::new_package(uint8_t _msgID) {
-  send_ptr = send_buffer; //reset send buffer
+  send_len = 0; //reset send buffer
   add_byte('#'); //Add start byte
   add_byte(_msgID);
 }
 
+uint8_t CaptainInterFace::finish_frame(char* buffer, uint8_t len, bool crc) {
+  if(crc) {
+    buffer[len] = len+6; len++;   //Add length
+    buffer[len++] = '*';          //Add '*'
+    uint32_t c = crc32c(buffer, len);
+    for(int i=0;i<4;i++) buffer[len++] = (c >> (8*i)) & 0xFF; //Add CRC, LSB first
+  }
+  else {
+    buffer[len] = len+3; len++;   //Add length
+    buffer[len++] = '*';          //Add '*'
+    buffer[len] = calc_checksum(buffer, len); len++; //Add CS
+  }
+  return len;
+}
+
 bool CaptainInterFace::send_package() {
-  //Calcualte length
-  uint8_t len = (send_ptr - send_buffer) + 3;
-  add_byte(len);        //Add length
+  //Leave room for length, '*' and the checksum
+  uint8_t n = send_len;
+  if(n > 255 - 6) n = 255 - 6;
+  uint8_t len;
+  {
+    TRACE_SPAN("encode", (uint8_t) send_buffer[1]);
+    len = finish_frame(send_buffer, n, crc_mode);
+  }
 
-  //Calcualte Checksum
-  add_byte('*');        //Add '*'
-  uint8_t cs = calc_checksum(send_buffer,len-1);
-  add_byte(cs);         //Add CS
+  if(scheduler != NULL) return scheduler->enqueue(send_buffer, len);
+  return send_frame(send_buffer, len);
+}
 
-  bool success = send_data(send_buffer, len);
+bool CaptainInterFace::send_frame(char* frame, uint8_t len) {
+  TRACE_SPAN("send", (uint8_t) frame[1]);
+  std::lock_guard<std::mutex> lock(send_mutex);
+  bool success = send_data(frame, len);
+  if(success) counters.sent++;
+  if(blackbox != NULL && success) {
+    //Frames are finished in the current mode, the hello always with XOR
+    uint8_t id = frame[1];
+    blackbox->record_frame(BLACKBOX_TX, frame, len, crc_mode && id != LINK_HELLO, realtime_ns());
+    if(id == SC_ABORT) blackbox->trigger("abort");
+  }
   return success;
 }
 
+bool CaptainInterFace::send_payload(uint8_t _msgID, const char* data, uint8_t len) {
+  //Same framing as new_package/send_package, but in a local buffer
+  if(len > 255 - 8) return false;
+  char buf[255];
+  uint8_t n = 0;
+  {
+    TRACE_SPAN("encode", _msgID);
+    buf[n++] = '#';
+    buf[n++] = _msgID;
+    for(int i=0;i<len;i++) buf[n++] = data[i];
+    n = finish_frame(buf, n, crc_mode);
+  }
+
+  if(scheduler != NULL) return scheduler->enqueue(buf, n);
+  return send_frame(buf, n);
+}
+
+bool CaptainInterFace::send_hello() {
+  char buf[8];
+  uint8_t n = 0;
+  buf[n++] = '#';
+  buf[n++] = LINK_HELLO;
+  if(link_capabilities != 0) buf[n++] = link_capabilities;   //legacy hello is empty
+  n = finish_frame(buf, n, false);
+
+  if(scheduler != NULL) return scheduler->enqueue(buf, n);
+  return send_frame(buf, n);
+}
+
 //----------------------------------------------------------------
 //-----------------------Add data to package----------------------
 //----------------------------------------------------------------
 void CaptainInterFace::add_byte(uint8_t b) {
-  if(send_ptr - send_buffer < 255) {
-    *send_ptr = b;
-    send_ptr++;
+  if(send_len < 255) {
+    send_buffer[send_len++] = b;
   }
 }
 //----------------------------------------------------------------
 void CaptainInterFace::add_float(float val){
   // Concatinates a float to package (4 bytes)
+  conversionFloat myUnionFloat;
   myUnionFloat.myFloat = val;
   add_byte(myUnionFloat.bytes[0]);
   add_byte(myUnionFloat.bytes[1]);
@@ -108,6 +256,7 @@ void CaptainInterFace::add_double(double val){
 //----------------------------------------------------------------
 void CaptainInterFace::add_long(uint32_t val){
   // Concatinates a Long int to package (4 bytes)
+  conversionLong myUnionLong;
   myUnionLong.mylong    = val;
   add_byte(myUnionLong.bytes[0]);
   add_byte(myUnionLong.bytes[1]);
@@ -123,6 +272,7 @@ void CaptainInterFace::add_llong(uint64_t val) {
 //----------------------------------------------------------------
 void CaptainInterFace::add_int(int val){
   // Concatinates a int to package (2 bytes)
+  conversionInt myUnionInt;
   myUnionInt.myInt = val;
   add_byte(myUnionInt.bytes[0]);
   add_byte(myUnionInt.bytes[1]);
@@ -139,13 +289,15 @@ uint8_t CaptainInterFace::parse_byte() {
 }
 //----------------------------------------------------------------
 std::string CaptainInterFace::parse_string(int Nchars){
-  std::string s = "";
+  std::string s;
+  s.reserve(Nchars);
   for(int i=0;i<Nchars;i++) s += ((char) parse_byte());
   return s;
 };          //
 //----------------------------------------------------------------
 float CaptainInterFace::parse_float(){
   // Converts 4 bytes to a float
+  conversionFloat myUnionFloat;
   myUnionFloat.bytes[0] = parse_byte();
   myUnionFloat.bytes[1] = parse_byte();
   myUnionFloat.bytes[2] = parse_byte();
@@ -164,6 +316,8 @@ double CaptainInterFace::parse_double(){
 //----------------------------------------------------------------
 uint32_t  CaptainInterFace::parse_long(){
   // Converts 4 bytes to a long integer (signed)
+  conversionLong myUnionLong;
+  myUnionLong.mylong = 0;
   myUnionLong.bytes[0] = parse_byte();
   myUnionLong.bytes[1] = parse_byte();
   myUnionLong.bytes[2] = parse_byte();
@@ -181,6 +335,8 @@ uint64_t CaptainInterFace::parse_llong() {
 //----------------------------------------------------------------
 int CaptainInterFace::parse_int(){
   // Converts 2 bytes to an int integer (signed)
+  conversionInt myUnionInt;
+  myUnionInt.myInt = 0;
   myUnionInt.bytes[0] = parse_byte();
   myUnionInt.bytes[1] = parse_byte();
   return myUnionInt.myInt;
@@ -0,0 +1,164 @@
+#include <captain_interface/ClockSync/ClockSync.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <algorithm>
+
+uint64_t realtime_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+bool enable_rx_timestamps(int fd) {
+  int on = 1;
+  return setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0;
+}
+
+ssize_t recv_timestamped(int fd, char* buf, size_t len, uint64_t& rx_ns) {
+  iovec iov = {buf, len};
+  char control[CMSG_SPACE(sizeof(timespec))];
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  ssize_t n = recvmsg(fd, &msg, 0);
+  if(n < 0) return n;
+
+  rx_ns = 0;
+  for(cmsghdr* c = CMSG_FIRSTHDR(&msg); c != NULL; c = CMSG_NXTHDR(&msg, c)) {
+    if(c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_TIMESTAMPNS) continue;
+    timespec ts;
+    memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+    rx_ns = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+  if(rx_ns == 0) rx_ns = realtime_ns();
+  return n;
+}
+
+//----------------------------------------------------------------
+//-----------------------ClockOffsetEstimator---------------------
+//----------------------------------------------------------------
+ClockOffsetEstimator::ClockOffsetEstimator() {
+  memset(&stats, 0, sizeof(stats));
+}
+
+void ClockOffsetEstimator::configure(double window_s, int windows, double min_delay_s) {
+  std::lock_guard<std::mutex> lock(mutex);
+  window = std::max(window_s, 0.01);
+  n_windows = std::min(std::max(windows, 1), (int) (sizeof(minima) / sizeof(minima[0])));
+  min_delay = std::max(min_delay_s, 0.0);
+  started = false;
+}
+
+void ClockOffsetEstimator::reset(int64_t host_ns, int64_t d_ns) {
+  started = true;
+  base_host_ns = host_ns;
+  base_offset_ns = d_ns;
+  minima_count = 0;
+  minima_next = 0;
+  fitted = false;
+  outliers = 0;
+  current.t = 0;
+  current.d = 0;
+  window_start = 0;
+  last_t = 0;
+}
+
+//Least squares line through the window minima
+void ClockOffsetEstimator::fit() {
+  double st = 0, sd = 0;
+  for(int i=0;i<minima_count;i++) { st += minima[i].t; sd += minima[i].d; }
+  fit_t = st / minima_count;
+  fit_d = sd / minima_count;
+  fit_skew = 0;
+  if(minima_count >= 2) {
+    double sxx = 0, sxy = 0;
+    for(int i=0;i<minima_count;i++) {
+      double dt = minima[i].t - fit_t;
+      sxx += dt * dt;
+      sxy += dt * (minima[i].d - fit_d);
+    }
+    if(sxx > 0) fit_skew = sxy / sxx;
+  }
+  fitted = true;
+}
+
+void ClockOffsetEstimator::add(uint64_t captain_us, uint64_t host_ns) {
+  std::lock_guard<std::mutex> lock(mutex);
+  int64_t d_ns = (int64_t) host_ns - (int64_t) (captain_us * 1000);
+  if(!started) reset(host_ns, d_ns);
+
+  double t = (int64_t) (host_ns - base_host_ns) * 1e-9;
+  double d = (d_ns - base_offset_ns) * 1e-9;
+
+  if(fitted) {
+    //Far below the lower envelope is impossible without a clock step, far above
+    //for long is a step too. Start over after a few in a row
+    double r = d - predict(t);
+    if(r < -step || r > 1.0) {
+      if(++outliers >= 5) {
+        reset(host_ns, d_ns);
+        stats.resets++;
+        t = 0;
+        d = 0;
+      }
+      else return;
+    }
+    else {
+      outliers = 0;
+      double delay = r + min_delay;
+      stats.samples++;
+      delay_sum += delay;
+      if(stats.samples == 1 || delay < stats.delay_min_ms * 1e-3) stats.delay_min_ms = delay * 1e3;
+      stats.delay_max_ms = std::max(stats.delay_max_ms, delay * 1e3);
+    }
+  }
+
+  last_t = t;
+  if(t - window_start >= window) {
+    //Close the window and refit
+    minima[minima_next] = current;
+    minima_next = (minima_next + 1) % n_windows;
+    minima_count = std::min(minima_count + 1, n_windows);
+    fit();
+    window_start = t;
+    current.t = t;
+    current.d = d;
+  }
+  else if(t == window_start || d < current.d) {
+    current.t = t;
+    current.d = d;
+  }
+}
+
+bool ClockOffsetEstimator::toHost(uint64_t captain_us, uint64_t& host_ns) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if(!fitted) return false;
+  //Host time of the sample, from the captain time. The error is offset * skew
+  int64_t approx_ns = (int64_t) (captain_us * 1000) + base_offset_ns;
+  double t = (approx_ns - base_host_ns) * 1e-9;
+  double offset = predict(t) - min_delay;
+  host_ns = approx_ns + (int64_t) (offset * 1e9);
+  return true;
+}
+
+ClockOffsetStatus ClockOffsetEstimator::status() {
+  std::lock_guard<std::mutex> lock(mutex);
+  ClockOffsetStatus s = stats;
+  s.valid = fitted;
+  if(fitted) {
+    s.offset_s = (base_offset_ns * 1e-9) + predict(last_t) - min_delay;
+    s.skew_ppm = fit_skew * 1e6;
+  }
+  s.delay_avg_ms = s.samples > 0 ? delay_sum / s.samples * 1e3 : 0;
+  stats.samples = 0;
+  stats.delay_min_ms = 0;
+  stats.delay_max_ms = 0;
+  delay_sum = 0;
+  return s;
+}
@@ -0,0 +1,76 @@
+#include <captain_interface/Crc32c/Crc32c.h>
+#include <string.h>
+
+#define CRC32C_POLY 0x82F63B78 // Reflected Castagnoli polynomial
+
+//----------------------------------------------------------------
+//----------------------------Software----------------------------
+//----------------------------------------------------------------
+struct Crc32cTable {
+  uint32_t t[256];
+  Crc32cTable() {
+    for(uint32_t i=0;i<256;i++) {
+      uint32_t c = i;
+      for(int k=0;k<8;k++) c = (c & 1) ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+      t[i] = c;
+    }
+  }
+};
+static const Crc32cTable table;
+
+uint32_t crc32c_sw(const void* data, size_t len, uint32_t crc) {
+  const uint8_t* p = (const uint8_t*) data;
+  crc = ~crc;
+  for(size_t i=0;i<len;i++) crc = table.t[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+//----------------------------------------------------------------
+//----------------------------Hardware----------------------------
+//----------------------------------------------------------------
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(const void* data, size_t len, uint32_t crc) {
+  const uint8_t* p = (const uint8_t*) data;
+  crc = ~crc;
+#if defined(__x86_64__)
+  while(len >= 8) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    crc = (uint32_t) __builtin_ia32_crc32di(crc, v);
+    p += 8; len -= 8;
+  }
+#endif
+  while(len >= 4) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    crc = __builtin_ia32_crc32si(crc, v);
+    p += 4; len -= 4;
+  }
+  while(len > 0) {
+    crc = __builtin_ia32_crc32qi(crc, *p);
+    p++; len--;
+  }
+  return ~crc;
+}
+
+bool crc32c_hw_available() {
+  static const bool available = __builtin_cpu_supports("sse4.2");
+  return available;
+}
+
+uint32_t crc32c(const void* data, size_t len, uint32_t crc) {
+  if(crc32c_hw_available()) return crc32c_hw(data, len, crc);
+  return crc32c_sw(data, len, crc);
+}
+
+#else
+
+bool crc32c_hw_available() {return false;}
+
+uint32_t crc32c(const void* data, size_t len, uint32_t crc) {
+  return crc32c_sw(data, len, crc);
+}
+
+#endif
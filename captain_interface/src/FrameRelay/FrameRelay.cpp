@@ -0,0 +1,169 @@
+#include <captain_interface/FrameRelay/FrameRelay.h>
+#include <captain_interface/Log/Log.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+bool FrameRelay::addTarget(const std::string& spec) {
+  Target t;
+  memset(&t.addr, 0, sizeof(t.addr));
+
+  //Message ID filter, all IDs if none given
+  std::string address = spec;
+  size_t sep = spec.find(';');
+  if(sep == std::string::npos) {
+    for(int i=0;i<4;i++) t.ids[i] = ~0ULL;
+  }
+  else {
+    address = spec.substr(0, sep);
+    for(int i=0;i<4;i++) t.ids[i] = 0;
+    const char* p = spec.c_str() + sep + 1;
+    while(*p) {
+      char* end;
+      long id = strtol(p, &end, 10);
+      if(end == p) break;
+      if(id >= 0 && id < 256) t.ids[id >> 6] |= 1ULL << (id & 63);
+      p = (*end == ',') ? end+1 : end;
+    }
+  }
+
+  if(!address.empty() && address[0] == '/') {
+    sockaddr_un* un = (sockaddr_un*) &t.addr;
+    if(address.size() >= sizeof(un->sun_path)) return false;
+    un->sun_family = AF_UNIX;
+    strcpy(un->sun_path, address.c_str());
+    t.addrlen = sizeof(sockaddr_un);
+    t.unix_socket = true;
+    if(unix_fd < 0) unix_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if(unix_fd < 0) return false;
+  }
+  else {
+    size_t colon = address.rfind(':');
+    if(colon == std::string::npos) return false;
+    sockaddr_in* in = (sockaddr_in*) &t.addr;
+    in->sin_family = AF_INET;
+    in->sin_port = htons(atoi(address.c_str() + colon + 1));
+    if(inet_pton(AF_INET, address.substr(0, colon).c_str(), &in->sin_addr) != 1) return false;
+    t.addrlen = sizeof(sockaddr_in);
+    t.unix_socket = false;
+    if(udp_fd < 0) udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(udp_fd < 0) return false;
+  }
+
+  targets.push_back(t);
+  udp_msgs.resize(targets.size());
+  unix_msgs.resize(targets.size());
+  return true;
+}
+
+void FrameRelay::forward(uint8_t msgID, char* frame, uint8_t len) {
+  if(targets.empty()) return;
+
+  //All targets share one iovec pointing at the frame
+  iov.iov_base = frame;
+  iov.iov_len = len;
+
+  unsigned int n_udp = 0, n_unix = 0;
+  for(size_t i=0;i<targets.size();i++) {
+    Target& t = targets[i];
+    if(!(t.ids[msgID >> 6] & (1ULL << (msgID & 63)))) continue;
+    struct mmsghdr& m = t.unix_socket ? unix_msgs[n_unix++] : udp_msgs[n_udp++];
+    memset(&m, 0, sizeof(m));
+    m.msg_hdr.msg_name = &t.addr;
+    m.msg_hdr.msg_namelen = t.addrlen;
+    m.msg_hdr.msg_iov = &iov;
+    m.msg_hdr.msg_iovlen = 1;
+  }
+
+  //Never block the receive thread on a slow subscriber
+  if(n_udp > 0) send_all(udp_fd, udp_msgs.data(), n_udp);
+  if(n_unix > 0) send_all(unix_fd, unix_msgs.data(), n_unix);
+}
+
+//sendmmsg stops at the first message that fails. Count that target as
+//dropped and carry on with the ones after it
+void FrameRelay::send_all(int fd, struct mmsghdr* msgs, unsigned int n) {
+  unsigned int i = 0;
+  while(i < n) {
+    int sent = sendmmsg(fd, msgs + i, n - i, MSG_DONTWAIT);
+    if(sent > 0) { i += sent; continue; }
+    dropped++;
+    i++;
+  }
+}
+
+//----------------------------------------------------------------
+bool FrameRelay::start(CaptainInterFace* _captain, int uplink_port, const std::string& _uplink_path) {
+  captain = _captain;
+  uplink_path = _uplink_path;
+
+  if(uplink_port > 0) {
+    uplink_udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in in;
+    memset(&in, 0, sizeof(in));
+    in.sin_family = AF_INET;
+    in.sin_port = htons(uplink_port);
+    in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(uplink_udp_fd < 0 || bind(uplink_udp_fd, (sockaddr*) &in, sizeof(in)) != 0) {
+      CLOG_ERROR("FrameRelay: uplink udp: %s", strerror(errno));
+      return false;
+    }
+  }
+
+  if(!uplink_path.empty()) {
+    uplink_unix_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    sockaddr_un un;
+    memset(&un, 0, sizeof(un));
+    un.sun_family = AF_UNIX;
+    strncpy(un.sun_path, uplink_path.c_str(), sizeof(un.sun_path)-1);
+    unlink(uplink_path.c_str());
+    if(uplink_unix_fd < 0 || bind(uplink_unix_fd, (sockaddr*) &un, sizeof(un)) != 0) {
+      CLOG_ERROR("FrameRelay: uplink unix: %s", strerror(errno));
+      return false;
+    }
+  }
+
+  if(uplink_udp_fd >= 0 || uplink_unix_fd >= 0) {
+    stopped = false;
+    uplink_thread = std::thread(&FrameRelay::uplink, this);
+  }
+  return true;
+}
+
+void FrameRelay::stop() {
+  stopped = true;
+  if(uplink_thread.joinable()) uplink_thread.join();
+  if(uplink_udp_fd >= 0) close(uplink_udp_fd);
+  if(uplink_unix_fd >= 0) { close(uplink_unix_fd); unlink(uplink_path.c_str()); }
+  if(udp_fd >= 0) close(udp_fd);
+  if(unix_fd >= 0) close(unix_fd);
+  uplink_udp_fd = uplink_unix_fd = udp_fd = unix_fd = -1;
+}
+
+void FrameRelay::uplink() {
+  struct pollfd fds[2];
+  int nfds = 0;
+  if(uplink_udp_fd >= 0)  { fds[nfds].fd = uplink_udp_fd;  fds[nfds].events = POLLIN; nfds++; }
+  if(uplink_unix_fd >= 0) { fds[nfds].fd = uplink_unix_fd; fds[nfds].events = POLLIN; nfds++; }
+
+  char buf[256];
+  while(!stopped) {
+    if(poll(fds, nfds, 100) <= 0) continue;
+    for(int i=0;i<nfds;i++) {
+      if(!(fds[i].revents & POLLIN)) continue;
+      ssize_t len = recv(fds[i].fd, buf, sizeof(buf), MSG_DONTWAIT);
+      if(len <= 0) continue;
+
+      //One frame per datagram. The hello (ID 0) is owned by the interface
+      if(len > 255 || !CaptainInterFace::validate_frame(buf, len) || buf[1] == 0) { rejected++; continue; }
+      if(captain->send_payload(buf[1], buf+2, len-5)) uplinked++;
+    }
+  }
+}
@@ -0,0 +1,69 @@
+#include <captain_interface/FrameScanner/FrameScanner.h>
+#include <captain_interface/Crc32c/Crc32c.h>
+#include <string.h>
+
+FrameScanner::FrameScanner(const char* _data, size_t _size, size_t from, size_t to)
+  : data(_data), size(_size), pos(from), floor(from), end(to < _size ? to : _size) {
+}
+
+bool FrameScanner::check(size_t star, uint8_t trailer, ScannedFrame& frame, bool& checksum_error) {
+  //star is the index of '*', the length byte is right before it
+  if(star == 0 || star + 1 + trailer > end) return false;
+  uint8_t length = data[star-1];
+  if(length < trailer + 4 || star + 1 + trailer < length) return false;
+  size_t start = star + 1 + trailer - length;
+  if(start < floor || data[start] != '#') return false;
+
+  bool valid;
+  if(trailer == 1) {
+    uint8_t cs = 0;
+    for(size_t i=start;i<=star;i++) cs ^= data[i];
+    valid = cs == (uint8_t) data[star+1];
+  }
+  else {
+    uint32_t crc;
+    memcpy(&crc, data + star + 1, 4);   //LSB first
+    valid = crc32c(data + start, star + 1 - start) == crc;
+  }
+  if(!valid) { checksum_error = true; return false; }
+
+  frame.offset = start;
+  frame.length = length;
+  frame.trailer = trailer;
+  return true;
+}
+
+bool FrameScanner::next(ScannedFrame& frame, FrameScanStats& stats) {
+  while(pos < end) {
+    const char* star = (const char*) memchr(data + pos, '*', end - pos);
+    if(star == NULL) { pos = end; return false; }
+    size_t j = star - data;
+    pos = j + 1;
+
+    bool checksum_error = false;
+    if(check(j, 1, frame, checksum_error) || check(j, 4, frame, checksum_error)) {
+      floor = pos = frame.offset + frame.length;
+      stats.frames++;
+      if(frame.trailer == 4) stats.crc_frames++;
+      stats.frame_bytes += frame.length;
+      stats.per_id[(uint8_t) data[frame.offset+1]]++;
+      return true;
+    }
+    if(checksum_error) stats.checksum_errors++;
+  }
+  return false;
+}
+
+size_t FrameScanner::boundary(const char* data, size_t size, size_t offset) {
+  if(offset >= size) return size;
+  //Frames are at most 255 bytes, so one ending after offset starts after offset-255
+  size_t from = offset > 255 ? offset - 255 : 0;
+  FrameScanner scanner(data, size, from, size);
+  FrameScanStats stats;
+  memset(&stats, 0, sizeof(stats));
+  ScannedFrame frame;
+  while(scanner.next(frame, stats)) {
+    if(frame.offset + frame.length >= offset) return frame.offset + frame.length;
+  }
+  return size;
+}
@@ -0,0 +1,97 @@
+#include <captain_interface/Geodesy/Geodesy.h>
+#include <math.h>
+
+//WGS84 ellipsoid
+#define WGS84_A         6378137.0
+#define WGS84_F         (1.0 / 298.257223563)
+#define UTM_K0          0.9996
+#define UTM_E0          500000.0
+#define UTM_N0_SOUTH    10000000.0
+
+#define DEG_TO_RAD      (M_PI / 180.0)
+#define RAD_TO_DEG      (180.0 / M_PI)
+
+UTMConverter::UTMConverter(int _zone, char band) {
+  double n  = WGS84_F / (2.0 - WGS84_F);
+  double n2 = n*n;
+  double n3 = n2*n;
+
+  double A = WGS84_A / (1.0 + n) * (1.0 + n2/4.0 + n2*n2/64.0);
+  k0A = UTM_K0 * A;
+  ecc_n = 2.0 * sqrt(n) / (1.0 + n);
+
+  alpha[0] = n/2.0 - 2.0*n2/3.0 + 5.0*n3/16.0;
+  alpha[1] = 13.0*n2/48.0 - 3.0*n3/5.0;
+  alpha[2] = 61.0*n3/240.0;
+
+  beta[0]  = n/2.0 - 2.0*n2/3.0 + 37.0*n3/96.0;
+  beta[1]  = n2/48.0 + n3/15.0;
+  beta[2]  = 17.0*n3/480.0;
+
+  delta[0] = 2.0*n - 2.0*n2/3.0 - 2.0*n3;
+  delta[1] = 7.0*n2/3.0 - 8.0*n3/5.0;
+  delta[2] = 56.0*n3/15.0;
+
+  setZone(_zone, band);
+};
+
+void UTMConverter::setZone(int _zone, char band) {
+  zone = _zone;
+  northern = (band >= 'N' && band <= 'Z') || (band >= 'n' && band <= 'z');
+  lon0 = ((zone - 1) * 6 - 180 + 3) * DEG_TO_RAD;
+  false_northing = northern ? 0.0 : UTM_N0_SOUTH;
+}
+
+//----------------------------------------------------------------
+void UTMConverter::toUTM(double lat, double lon, double& easting, double& northing) const {
+  double phi = lat * DEG_TO_RAD;
+  double dlon = lon * DEG_TO_RAD - lon0;
+
+  double sin_phi = sin(phi);
+  double t = sinh(atanh(sin_phi) - ecc_n * atanh(ecc_n * sin_phi));
+  double xi_p  = atan2(t, cos(dlon));
+  double eta_p = atanh(sin(dlon) / sqrt(1.0 + t*t));
+
+  double xi = xi_p;
+  double eta = eta_p;
+  for(int j=0;j<3;j++) {
+    double k = 2.0 * (j+1);
+    xi  += alpha[j] * sin(k*xi_p) * cosh(k*eta_p);
+    eta += alpha[j] * cos(k*xi_p) * sinh(k*eta_p);
+  }
+
+  easting  = UTM_E0 + k0A * eta;
+  northing = false_northing + k0A * xi;
+}
+
+//----------------------------------------------------------------
+void UTMConverter::toLatLon(double easting, double northing, double& lat, double& lon) const {
+  double xi  = (northing - false_northing) / k0A;
+  double eta = (easting - UTM_E0) / k0A;
+
+  double xi_p = xi;
+  double eta_p = eta;
+  for(int j=0;j<3;j++) {
+    double k = 2.0 * (j+1);
+    xi_p  -= beta[j] * sin(k*xi) * cosh(k*eta);
+    eta_p -= beta[j] * cos(k*xi) * sinh(k*eta);
+  }
+
+  double chi = asin(sin(xi_p) / cosh(eta_p));
+  double phi = chi;
+  for(int j=0;j<3;j++) {
+    phi += delta[j] * sin(2.0 * (j+1) * chi);
+  }
+
+  lat = phi * RAD_TO_DEG;
+  lon = (lon0 + atan2(sinh(eta_p), cos(xi_p))) * RAD_TO_DEG;
+}
+
+//----------------------------------------------------------------
+void UTMConverter::toLatLon(const double* easting, const double* northing, double* lat, double* lon, size_t n) const {
+  for(size_t i=0;i<n;i++) toLatLon(easting[i], northing[i], lat[i], lon[i]);
+}
+
+void UTMConverter::toUTM(const double* lat, const double* lon, double* easting, double* northing, size_t n) const {
+  for(size_t i=0;i<n;i++) toUTM(lat[i], lon[i], easting[i], northing[i]);
+}
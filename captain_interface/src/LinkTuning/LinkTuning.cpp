@@ -0,0 +1,122 @@
+#include <captain_interface/LinkTuning/LinkTuning.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+
+LinkProfile LinkProfile::preset(const std::string& name, bool* known) {
+  LinkProfile p;
+  if(known != NULL) *known = name == "default" || name == "low_latency";
+  if(name != "low_latency") return p;
+  p.rcvbuf = 4 << 20;           // a few seconds of telemetry if the reader stalls
+  p.sndbuf = 1 << 20;
+  p.busy_poll_us = 50;
+  p.dscp = 46;                  // expedited forwarding
+  p.socket_priority = 6;        // highest without CAP_NET_ADMIN
+  p.thread_priority = 40;       // above the callback spinners, below the kernel IRQ threads (50 by default)
+  p.lock_memory = true;
+  return p;
+}
+
+static int get_int(int fd, int level, int option) {
+  int value = -1;
+  socklen_t len = sizeof(value);
+  if(getsockopt(fd, level, option, &value, &len) != 0) return -1;
+  return value;
+}
+
+//Appends "name value", with the error or the requested value if the kernel did not apply it
+static void report_option(std::string& line, const char* name, int requested, int applied, int err) {
+  char buf[128];
+  if(err != 0) snprintf(buf, sizeof(buf), ", %s %d (requested %d: %s)", name, applied, requested, strerror(err));
+  else if(applied != requested) snprintf(buf, sizeof(buf), ", %s %d (requested %d)", name, applied, requested);
+  else snprintf(buf, sizeof(buf), ", %s %d", name, applied);
+  line += buf;
+}
+
+//SO_*BUFFORCE ignores rmem_max / wmem_max but needs CAP_NET_ADMIN
+static int set_buffer(int fd, int force_option, int option, int bytes) {
+  if(setsockopt(fd, SOL_SOCKET, force_option, &bytes, sizeof(bytes)) == 0) return 0;
+  if(setsockopt(fd, SOL_SOCKET, option, &bytes, sizeof(bytes)) == 0) return 0;
+  return errno;
+}
+
+std::string tune_socket(int fd, const std::string& name, const LinkProfile& p) {
+  std::string line = name + ":";
+  int err = 0;
+
+  //The kernel reports twice the requested size, half is bookkeeping
+  if(p.rcvbuf > 0) err = set_buffer(fd, SO_RCVBUFFORCE, SO_RCVBUF, p.rcvbuf);
+  report_option(line, "rcvbuf", p.rcvbuf > 0 ? p.rcvbuf : get_int(fd, SOL_SOCKET, SO_RCVBUF) / 2, get_int(fd, SOL_SOCKET, SO_RCVBUF) / 2, p.rcvbuf > 0 ? err : 0);
+  if(p.sndbuf > 0) err = set_buffer(fd, SO_SNDBUFFORCE, SO_SNDBUF, p.sndbuf);
+  report_option(line, "sndbuf", p.sndbuf > 0 ? p.sndbuf : get_int(fd, SOL_SOCKET, SO_SNDBUF) / 2, get_int(fd, SOL_SOCKET, SO_SNDBUF) / 2, p.sndbuf > 0 ? err : 0);
+
+  if(p.busy_poll_us > 0) {
+    err = setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &p.busy_poll_us, sizeof(p.busy_poll_us)) == 0 ? 0 : errno;
+    report_option(line, "busy_poll_us", p.busy_poll_us, get_int(fd, SOL_SOCKET, SO_BUSY_POLL), err);
+  }
+  if(p.dscp >= 0) {
+    int tos = p.dscp << 2;
+    err = setsockopt(fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos)) == 0 ? 0 : errno;
+    report_option(line, "dscp", p.dscp, get_int(fd, IPPROTO_IP, IP_TOS) >> 2, err);
+  }
+  if(p.socket_priority >= 0) {
+    err = setsockopt(fd, SOL_SOCKET, SO_PRIORITY, &p.socket_priority, sizeof(p.socket_priority)) == 0 ? 0 : errno;
+    report_option(line, "priority", p.socket_priority, get_int(fd, SOL_SOCKET, SO_PRIORITY), err);
+  }
+
+  int on = p.rx_timestamps ? 1 : 0;
+  err = setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0 ? 0 : errno;
+  line += get_int(fd, SOL_SOCKET, SO_TIMESTAMPNS) > 0 ? ", rx timestamps kernel" : ", rx timestamps read time";
+  if(err != 0) line += std::string(" (") + strerror(err) + ")";
+  return line.erase(name.size() + 1, 1);   //the comma before the first option
+}
+
+std::string tune_thread(pthread_t thread, const std::string& name, const LinkProfile& p) {
+  std::string line = name + ":";
+  char buf[128];
+
+  if(p.thread_cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(p.thread_cpu, &set);
+    int err = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if(err != 0) snprintf(buf, sizeof(buf), " cpu %d failed: %s,", p.thread_cpu, strerror(err));
+    else snprintf(buf, sizeof(buf), " cpu %d,", p.thread_cpu);
+    line += buf;
+  }
+  else line += " any cpu,";
+
+  if(p.thread_priority > 0) {
+    sched_param param;
+    param.sched_priority = p.thread_priority;
+    int err = pthread_setschedparam(thread, SCHED_FIFO, &param);
+    if(err != 0) {
+      snprintf(buf, sizeof(buf), " SCHED_FIFO %d failed: %s,", p.thread_priority, strerror(err));
+      line += buf;
+    }
+  }
+
+  int policy;
+  sched_param param;
+  if(pthread_getschedparam(thread, &policy, &param) == 0) {
+    if(policy == SCHED_FIFO) snprintf(buf, sizeof(buf), " SCHED_FIFO %d", param.sched_priority);
+    else if(policy == SCHED_RR) snprintf(buf, sizeof(buf), " SCHED_RR %d", param.sched_priority);
+    else snprintf(buf, sizeof(buf), " normal scheduling");
+    line += buf;
+  }
+  return line;
+}
+
+std::string tune_memory(const LinkProfile& p) {
+  if(!p.lock_memory) return "memory: not locked";
+  if(mlockall(MCL_CURRENT | MCL_FUTURE) != 0) return std::string("memory: mlockall failed: ") + strerror(errno);
+  return "memory: locked";
+}
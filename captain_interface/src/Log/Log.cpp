@@ -0,0 +1,209 @@
+#include <captain_interface/Log/Log.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+//A slot of lap L (position / LOG_RING_SIZE) is free for writing at seq 2L,
+//holds a message at 2L+1 and is released for lap L+1 by the flusher with 2L+2
+struct LogSlot {
+  std::atomic<uint64_t> seq;
+  LogLevel level;
+  uint32_t suppressed;              // messages of the same site dropped before this one
+  char     text[LOG_LINE_SIZE];
+};
+
+static LogSlot ring[LOG_RING_SIZE];
+static std::atomic<uint64_t> tail(0);          // next position to write
+static uint64_t head = 0;                      // next position to flush, flusher only
+
+static std::atomic<LogSite*> sites(NULL);
+static std::atomic<uint32_t> rate_limit(10);
+static std::atomic<uint64_t> written(0), dropped(0), suppressed(0);
+
+static std::atomic<bool> running(false);
+static std::mutex mutex;                       // sink and flusher state
+static std::condition_variable cv;
+static std::thread flusher;
+static bool stopping = false;
+
+static void default_sink(LogLevel level, const char* text) {
+  FILE* f = level == LOG_LEVEL_INFO ? stdout : stderr;
+  fprintf(f, "%s\n", text);
+  fflush(f);
+}
+static LogSink sink = default_sink;
+
+static uint64_t monotonic_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static const char* file_name(const char* path) {
+  const char* slash = strrchr(path, '/');
+  return slash != NULL ? slash + 1 : path;
+}
+
+//Caller holds mutex
+static void emit(LogLevel level, const char* text, uint32_t skipped) {
+  if(skipped == 0) sink(level, text);
+  else {
+    char line[LOG_LINE_SIZE + 48];
+    snprintf(line, sizeof(line), "%s (%u similar messages suppressed)", text, skipped);
+    sink(level, line);
+  }
+  written.fetch_add(1, std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------
+static bool admit(LogSite& site, uint64_t now) {
+  if(!site.registered.exchange(true)) {
+    LogSite* first = sites.load();
+    do site.next = first; while(!sites.compare_exchange_weak(first, &site));
+  }
+
+  uint32_t limit = site.limit != 0 ? site.limit : rate_limit.load(std::memory_order_relaxed);
+  if(limit == 0) return true;
+  uint64_t start = site.window_start_ns.load(std::memory_order_relaxed);
+  if(now - start >= 1000000000ULL && site.window_start_ns.compare_exchange_strong(start, now)) site.window_count.store(0);
+  if(site.window_count.fetch_add(1, std::memory_order_relaxed) < limit) return true;
+
+  site.suppressed.fetch_add(1, std::memory_order_relaxed);
+  site.suppressed_total.fetch_add(1, std::memory_order_relaxed);
+  suppressed.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void log_write(LogSite& site, LogLevel level, const char* format, ...) {
+  if(!admit(site, monotonic_ns())) return;
+  uint32_t skipped = site.suppressed.exchange(0, std::memory_order_relaxed);
+
+  va_list args;
+  va_start(args, format);
+  if(!running.load(std::memory_order_acquire)) {
+    char text[LOG_LINE_SIZE];
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    std::lock_guard<std::mutex> lock(mutex);
+    emit(level, text, skipped);
+    return;
+  }
+
+  //Claim a position, give up if the flusher is a full lap behind
+  uint64_t pos = tail.load(std::memory_order_relaxed);
+  LogSlot* slot;
+  for(;;) {
+    slot = &ring[pos & (LOG_RING_SIZE - 1)];
+    uint64_t free = 2 * (pos / LOG_RING_SIZE);
+    uint64_t seq = slot->seq.load(std::memory_order_acquire);
+    if(seq == free) {
+      if(tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    }
+    else if(seq < free) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      site.suppressed.fetch_add(skipped, std::memory_order_relaxed);   //report with the next one
+      va_end(args);
+      return;
+    }
+    else pos = tail.load(std::memory_order_relaxed);
+  }
+
+  vsnprintf(slot->text, sizeof(slot->text), format, args);
+  va_end(args);
+  slot->level = level;
+  slot->suppressed = skipped;
+  slot->seq.store(2 * (pos / LOG_RING_SIZE) + 1, std::memory_order_release);
+}
+
+//----------------------------------------------------------------
+//Caller holds mutex
+static void flush() {
+  for(;;) {
+    LogSlot& slot = ring[head & (LOG_RING_SIZE - 1)];
+    uint64_t lap = head / LOG_RING_SIZE;
+    if(slot.seq.load(std::memory_order_acquire) != 2 * lap + 1) break;   //empty, or still being written
+    emit(slot.level, slot.text, slot.suppressed);
+    slot.seq.store(2 * lap + 2, std::memory_order_release);
+    head++;
+  }
+}
+
+//Sites that stopped logging while over their limit
+static void report_quiet_sites(uint64_t now) {
+  for(LogSite* site = sites.load(); site != NULL; site = site->next) {
+    if(site->suppressed.load(std::memory_order_relaxed) == 0) continue;
+    if(now - site->window_start_ns.load(std::memory_order_relaxed) < 1000000000ULL) continue;
+    uint32_t skipped = site->suppressed.exchange(0, std::memory_order_relaxed);
+    if(skipped == 0) continue;
+    char text[128];
+    snprintf(text, sizeof(text), "%s:%d: %u similar messages suppressed", file_name(site->file), site->line, skipped);
+    emit(LOG_LEVEL_WARN, text, 0);
+  }
+}
+
+static void run(int flush_ms) {
+  std::unique_lock<std::mutex> lock(mutex);
+  uint64_t last_report = monotonic_ns();
+  while(!stopping) {
+    cv.wait_for(lock, std::chrono::milliseconds(flush_ms), [] {return stopping;});
+    flush();
+    uint64_t now = monotonic_ns();
+    if(now - last_report >= 1000000000ULL) {
+      report_quiet_sites(now);
+      last_report = now;
+    }
+  }
+  flush();
+}
+
+void log_start(int flush_ms) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if(running) return;
+  stopping = false;
+  flusher = std::thread(run, flush_ms);
+  running.store(true, std::memory_order_release);
+}
+
+void log_stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!running) return;
+    running.store(false, std::memory_order_release);
+    stopping = true;
+  }
+  cv.notify_one();
+  flusher.join();
+
+  //Writers that claimed a slot before running was cleared
+  std::lock_guard<std::mutex> lock(mutex);
+  flush();
+  report_quiet_sites(monotonic_ns() + 1000000000ULL);
+}
+
+void log_set_sink(LogSink _sink) {
+  std::lock_guard<std::mutex> lock(mutex);
+  sink = _sink ? _sink : default_sink;
+}
+
+void log_set_rate_limit(uint32_t per_second) {
+  rate_limit = per_second;
+}
+
+LogStats log_stats() {
+  LogStats s;
+  s.written = written.load();
+  s.dropped = dropped.load();
+  s.suppressed = suppressed.load();
+  return s;
+}
+
+void log_for_each_site(const std::function<void(const LogSite& site)>& f) {
+  for(LogSite* site = sites.load(); site != NULL; site = site->next) {
+    if(site->suppressed_total.load(std::memory_order_relaxed) > 0) f(*site);
+  }
+}
@@ -0,0 +1,138 @@
+#include <captain_interface/MessageCodec/MessageCodec.h>
+#include <captain_interface/scientistmsg.h>
+#include <captain_interface/Log/Log.h>
+
+#define F(S, field, type) {#field, type, (uint16_t) offsetof(S, field)}
+
+#define SURFACE(id, name) {id, name, sizeof(SurfaceMessage), 4, {  \
+    F(SurfaceMessage, timestamp, FIELD_LLONG), F(SurfaceMessage, sequence, FIELD_LONG), \
+    F(SurfaceMessage, target_angle, FIELD_FLOAT), F(SurfaceMessage, angle, FIELD_FLOAT)}}
+
+#define THRUSTER(id, name) {id, name, sizeof(ThrusterMessage), 8, { \
+    F(ThrusterMessage, timestamp, FIELD_LLONG), F(ThrusterMessage, sequence, FIELD_LONG), \
+    F(ThrusterMessage, rpm_setpoint, FIELD_FLOAT), F(ThrusterMessage, rpm, FIELD_FLOAT), \
+    F(ThrusterMessage, current, FIELD_FLOAT), F(ThrusterMessage, torque, FIELD_FLOAT), \
+    F(ThrusterMessage, energy, FIELD_FLOAT), F(ThrusterMessage, voltage, FIELD_FLOAT)}}
+
+#define CONTROLLER(name, i) {name, FIELD_BYTE, (uint16_t) (offsetof(CtrlStatusMessage, enabled) + i)}
+
+static const MessageLayout layouts[] = {
+  SURFACE(CS_RUDDER, "rudder"),
+  SURFACE(CS_ELEVATOR, "elevator"),
+  SURFACE(CS_ELEVON_PORT, "elevon_port"),
+  SURFACE(CS_ELEVON_STRB, "elevon_strb"),
+  THRUSTER(CS_THRUSTER_PORT, "thruster_port"),
+  THRUSTER(CS_THRUSTER_STRB, "thruster_strb"),
+
+  //Unconfirmed: u64 timestamp [us], u32 seq, float roll, pitch, yaw [rad],
+  //float roll_rate, pitch_rate, yaw_rate [rad/s]
+  {CS_IMU, "imu", sizeof(ImuMessage), 8, {
+    F(ImuMessage, timestamp, FIELD_LLONG), F(ImuMessage, sequence, FIELD_LONG),
+    F(ImuMessage, roll, FIELD_FLOAT), F(ImuMessage, pitch, FIELD_FLOAT), F(ImuMessage, yaw, FIELD_FLOAT),
+    F(ImuMessage, roll_rate, FIELD_FLOAT), F(ImuMessage, pitch_rate, FIELD_FLOAT), F(ImuMessage, yaw_rate, FIELD_FLOAT)}},
+
+  //Unconfirmed: u64 timestamp [us], u32 seq, double lat, lon [rad], float depth, altitude [m]
+  {CS_POSITION, "position", sizeof(PositionMessage), 6, {
+    F(PositionMessage, timestamp, FIELD_LLONG), F(PositionMessage, sequence, FIELD_LONG),
+    F(PositionMessage, latitude, FIELD_DOUBLE), F(PositionMessage, longitude, FIELD_DOUBLE),
+    F(PositionMessage, depth, FIELD_FLOAT), F(PositionMessage, altitude, FIELD_FLOAT)}},
+
+  //Unconfirmed, lolo_msgs/CaptainStatus after the timestamp / sequence header:
+  //u8 active_control_input, double target lat, lon [rad],
+  //float target yaw, pitch, speed, rpm, depth, altitude
+  {CS_STATUS, "status", sizeof(StatusMessage), 11, {
+    F(StatusMessage, timestamp, FIELD_LLONG), F(StatusMessage, sequence, FIELD_LONG),
+    F(StatusMessage, active_control_input, FIELD_BYTE),
+    F(StatusMessage, target_latitude, FIELD_DOUBLE), F(StatusMessage, target_longitude, FIELD_DOUBLE),
+    F(StatusMessage, target_yaw, FIELD_FLOAT), F(StatusMessage, target_pitch, FIELD_FLOAT),
+    F(StatusMessage, target_speed, FIELD_FLOAT), F(StatusMessage, target_rpm, FIELD_FLOAT),
+    F(StatusMessage, target_depth, FIELD_FLOAT), F(StatusMessage, target_altitude, FIELD_FLOAT)}},
+
+  {CS_CTRL_STATUS, "ctrl_status", sizeof(CtrlStatusMessage), MESSAGE_N_CONTROLLERS, {
+    CONTROLLER("waypoint", 0), CONTROLLER("yaw", 1), CONTROLLER("yawrate", 2),
+    CONTROLLER("depth", 3), CONTROLLER("altitude", 4), CONTROLLER("pitch", 5),
+    CONTROLLER("speed", 6), CONTROLLER("rpm", 7), CONTROLLER("rpm_strb", 8),
+    CONTROLLER("rpm_port", 9), CONTROLLER("elevator", 10), CONTROLLER("rudder", 11),
+    CONTROLLER("vbs", 12)}},
+
+  {CS_REQUEST_OUT, "service", sizeof(ServiceMessage), 2, {
+    F(ServiceMessage, ref, FIELD_INT), F(ServiceMessage, reply, FIELD_BYTE)}},
+};
+
+static const int n_layouts = sizeof(layouts) / sizeof(layouts[0]);
+
+const MessageLayout* message_layout(uint8_t msgID) {
+  for(int i=0;i<n_layouts;i++) if(layouts[i].msgID == msgID) return &layouts[i];
+  return NULL;
+}
+
+const MessageLayout* message_layout(const char* name) {
+  for(int i=0;i<n_layouts;i++) if(strcmp(layouts[i].name, name) == 0) return &layouts[i];
+  return NULL;
+}
+
+const MessageLayout* message_layouts(int& count) {
+  count = n_layouts;
+  return layouts;
+}
+
+bool message_decode(const MessageLayout* layout, const char* payload, uint8_t len, void* out) {
+  if(len < message_size(layout)) {
+    CLOG(LOG_LEVEL_WARN, 1, "Short %s frame, %d of %d bytes", layout->name, len, message_size(layout));
+    return false;
+  }
+  const char* p = payload;
+  for(int i=0;i<layout->n_fields;i++) {
+    MessageFieldType type = layout->fields[i].type;
+    message_field_native(type, p, (char*) out + layout->fields[i].offset);
+    p += message_field_size(type);
+  }
+  return true;
+}
+
+static bool decode(uint8_t msgID, const char* payload, uint8_t len, void* out) {
+  const MessageLayout* layout = message_layout(msgID);
+  return layout != NULL && message_decode(layout, payload, len, out);
+}
+
+bool decode_surface(uint8_t msgID, const char* payload, uint8_t len, SurfaceMessage& m) {
+  if(msgID != CS_RUDDER && msgID != CS_ELEVATOR && msgID != CS_ELEVON_PORT && msgID != CS_ELEVON_STRB) return false;
+  return decode(msgID, payload, len, &m);
+}
+
+bool decode_thruster(uint8_t msgID, const char* payload, uint8_t len, ThrusterMessage& m) {
+  if(msgID != CS_THRUSTER_PORT && msgID != CS_THRUSTER_STRB) return false;
+  return decode(msgID, payload, len, &m);
+}
+
+bool decode_imu(const char* payload, uint8_t len, ImuMessage& m) {
+  return decode(CS_IMU, payload, len, &m);
+}
+
+bool decode_position(const char* payload, uint8_t len, PositionMessage& m) {
+  return decode(CS_POSITION, payload, len, &m);
+}
+
+bool decode_status(const char* payload, uint8_t len, StatusMessage& m) {
+  return decode(CS_STATUS, payload, len, &m);
+}
+
+bool decode_ctrl_status(const char* payload, uint8_t len, CtrlStatusMessage& m) {
+  return decode(CS_CTRL_STATUS, payload, len, &m);
+}
+
+bool decode_service(const char* payload, uint8_t len, ServiceMessage& m) {
+  return decode(CS_REQUEST_OUT, payload, len, &m);
+}
+
+bool is_text_message(uint8_t msgID) {
+  return msgID == CS_TEXT || msgID == CS_MENUSTREAM || msgID == CS_MISSIONLOG || msgID == CS_DATALOG;
+}
+
+bool decode_text(const char* payload, uint8_t len, std::string& text) {
+  if(len < 1) return false;
+  int n = (uint8_t) payload[0];
+  if(n > len - 1) n = len - 1;
+  text.assign(payload + 1, n);
+  return true;
+}
@@ -0,0 +1,134 @@
+#include <captain_interface/PathUpload/PathUpload.h>
+#include <captain_interface/scientistmsg.h>
+#include <string.h>
+#include <algorithm>
+
+#ifndef PI
+#define PI 3.141592653589793238462643383279502884197169399375105820974944592307816406286
+#endif
+
+PathUploader::PathUploader(SendFunction _send) : send(_send) {
+  memset(&counters, 0, sizeof(counters));
+};
+
+bool PathUploader::upload(const std::vector<PathPoint>& points) {
+  if(points.size() > PATH_MAX_POINTS) return false;
+  std::lock_guard<std::mutex> lock(mutex);
+
+  //Points the captain already has
+  size_t keep = 0;
+  while(keep < points.size() && keep < path.size() && acked[keep] && points[keep] == path[keep]) keep++;
+
+  bool resized = points.size() != path.size();
+  path = points;
+  acked.resize(path.size());
+  std::fill(acked.begin() + keep, acked.end(), false);
+
+  //Acknowledgements for the previous upload no longer apply
+  chunks.clear();
+  generation = (generation + 1) & 0x7F;
+
+  uint16_t chunk_no = 0;
+  for(size_t start=keep;start<path.size();start+=PATH_POINTS_PER_FRAME) {
+    Chunk c;
+    c.ref = PATH_REF_FLAG | (generation << 8) | chunk_no++;
+    c.start = start;
+    c.n = std::min((size_t) PATH_POINTS_PER_FRAME, path.size() - start);
+    c.retries = 0;
+    c.queued = false;
+    chunks.push_back(c);
+  }
+
+  //Unchanged prefix but shorter path: only the truncation has to be sent
+  if(chunks.empty() && resized) {
+    Chunk c = {(uint16_t) (PATH_REF_FLAG | (generation << 8)), (uint16_t) path.size(), 0, 0, false, Clock::now()};
+    chunks.push_back(c);
+  }
+
+  fill_window();
+  return true;
+}
+
+//Chunks are acknowledged out of order, so the window counts the queued ones
+void PathUploader::fill_window() {
+  size_t outstanding = 0;
+  for(size_t i=0;i<chunks.size();i++) outstanding += chunks[i].queued;
+  for(size_t i=0;i<chunks.size() && outstanding < window;i++) {
+    if(chunks[i].queued) continue;
+    chunks[i].queued = true;
+    outstanding++;
+    send_chunk(chunks[i]);
+  }
+}
+
+void PathUploader::send_chunk(Chunk& c) {
+  char buf[7 + PATH_POINTS_PER_FRAME*16];
+  uint8_t n = 0;
+  uint16_t total = path.size();
+  memcpy(buf+n, &c.ref, 2);   n += 2;   //Same byte order as add_int
+  memcpy(buf+n, &c.start, 2); n += 2;
+  memcpy(buf+n, &total, 2);   n += 2;
+  buf[n++] = c.n;
+  for(int i=0;i<c.n;i++) {
+    double lat = (PI / 180) * path[c.start+i].latitude;
+    double lon = (PI / 180) * path[c.start+i].longitude;
+    memcpy(buf+n, &lat, 8); n += 8;
+    memcpy(buf+n, &lon, 8); n += 8;
+  }
+  c.sent = Clock::now();
+  counters.frames_sent++;
+  send(SC_SET_PATH, buf, n);
+}
+
+void PathUploader::transmitted(const char* payload, uint8_t len) {
+  if(len < 2) return;
+  uint16_t ref;
+  memcpy(&ref, payload, 2);
+  std::lock_guard<std::mutex> lock(mutex);
+  for(size_t i=0;i<chunks.size();i++) {
+    if(chunks[i].ref == ref) { chunks[i].sent = Clock::now(); break; }
+  }
+}
+
+bool PathUploader::handle_ack(uint16_t ref, uint8_t reply) {
+  if((ref & PATH_REF_FLAG) == 0) return false;
+  std::lock_guard<std::mutex> lock(mutex);
+
+  for(size_t i=0;i<chunks.size();i++) {
+    if(chunks[i].ref != ref) continue;
+    if(reply == SERVICE_ACTION_SUCCESS) std::fill(acked.begin() + chunks[i].start, acked.begin() + chunks[i].start + chunks[i].n, true);
+    else counters.failed++;
+    chunks.erase(chunks.begin() + i);
+    fill_window();
+    break;
+  }
+  return true; //Stale acknowledgements are consumed as well
+}
+
+void PathUploader::poll() {
+  std::lock_guard<std::mutex> lock(mutex);
+  Clock::time_point now = Clock::now();
+  for(size_t i=0;i<chunks.size();) {
+    if(!chunks[i].queued || std::chrono::duration<double>(now - chunks[i].sent).count() < timeout) { i++; continue; }
+    if(chunks[i].retries >= max_retries) {
+      counters.failed++;
+      chunks.erase(chunks.begin() + i);
+      continue;
+    }
+    chunks[i].retries++;
+    counters.retransmits++;
+    send_chunk(chunks[i]);
+    i++;
+  }
+  fill_window();
+}
+
+PathUploadStatus PathUploader::status() {
+  std::lock_guard<std::mutex> lock(mutex);
+  PathUploadStatus s = counters;
+  s.points = path.size();
+  s.confirmed = 0;
+  while(s.confirmed < path.size() && acked[s.confirmed]) s.confirmed++;
+  s.pending = chunks.size();
+  return s;
+}
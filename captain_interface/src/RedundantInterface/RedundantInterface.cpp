@@ -0,0 +1,251 @@
+#include <captain_interface/RedundantInterface/RedundantInterface.h>
+#include <captain_interface/Crc32c/Crc32c.h>
+#include <captain_interface/Tracing/Tracing.h>
+#include <captain_interface/ClockSync/ClockSync.h>
+#include <captain_interface/Log/Log.h>
+#include <captain_interface/LinkTuning/LinkTuning.h>
+#include <captain_interface/scientistmsg.h>
+#include <stdio.h>
+#include <string.h>
+#include <poll.h>
+#include <chrono>
+#include <algorithm>
+
+static_assert(REDUNDANT_SEQ_WINDOW == 64, "sequence window is a 64 bit mask");
+
+using boost::asio::ip::udp;
+
+static uint64_t steady_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//----------------------------------------------------------------
+//-------------------------RedundantPath--------------------------
+//----------------------------------------------------------------
+RedundantPath::RedundantPath(RedundantInterface* _owner, int _index, boost::asio::io_service& io)
+  : owner(_owner), index(_index), socket(io) {
+}
+
+bool RedundantPath::open(int local_port, const std::string& captain_ip, int captain_port) {
+  boost::system::error_code error;
+  boost::asio::ip::address address = boost::asio::ip::address::from_string(captain_ip, error);
+  if(error) { CLOG_ERROR("Redundant path: invalid address %s", captain_ip.c_str()); return false; }
+  captain_endpoint = udp::endpoint(address, captain_port);
+
+  socket.open(udp::v4(), error);
+  if(!error) socket.bind(udp::endpoint(udp::v4(), local_port), error);
+  if(!error) socket.non_blocking(true, error);
+  if(!error && !enable_rx_timestamps(socket.native_handle())) CLOG_WARN("Redundant path: no kernel receive timestamps on port %d", local_port);
+  if(error) { CLOG_ERROR("Redundant path: could not bind port %d: %s", local_port, error.message().c_str()); return false; }
+  return true;
+}
+
+void RedundantPath::start() {
+  read_thread = std::thread(&RedundantPath::readData, this);
+}
+
+void RedundantPath::join() {
+  if(read_thread.joinable()) read_thread.join();
+  boost::system::error_code error;
+  socket.close(error);
+}
+
+void RedundantPath::applyLinkProfile(const LinkProfile& profile, std::vector<std::string>& report) {
+  report.push_back(tune_socket(socket.native_handle(), "path " + std::to_string(index) + " socket", profile));
+  if(read_thread.joinable()) report.push_back(tune_thread(read_thread.native_handle(), "path " + std::to_string(index) + " reader", profile));
+}
+
+std::string RedundantPath::name() {
+  return "udp " + captain_endpoint.address().to_string() + ":" + std::to_string(captain_endpoint.port());
+}
+
+void RedundantPath::readData() {
+  char name[16];
+  snprintf(name, sizeof(name), "udp_rx_%d", index);
+  TRACE_THREAD(name);
+
+  char rbuf[256];
+  pollfd pfd = {socket.native_handle(), POLLIN, 0};
+  while(!owner->stopped) {
+    //Wait with a timeout so stop() does not depend on traffic
+    if(poll(&pfd, 1, 100) <= 0) continue;
+
+    uint64_t rx_ns;
+    ssize_t len = recv_timestamped(socket.native_handle(), rbuf, sizeof(rbuf), rx_ns);
+    if(len <= 0) continue;
+    TRACE_SPAN("receive", len);
+    setReceiveTime(rx_ns);
+    for(ssize_t i=0;i<len;i++) parse_data(rbuf[i]);
+  }
+}
+
+bool RedundantPath::write(const char* buf, uint8_t len) {
+  boost::system::error_code error;
+  socket.send_to(boost::asio::buffer(buf, len), captain_endpoint, 0, error);
+  return !error;
+}
+
+bool RedundantPath::package_received() {
+  char frame[255];
+  uint8_t len = copy_frame(frame);
+  if(messageID() == LINK_HELLO) CaptainInterFace::package_received(); //CRC mode of this path
+  owner->deliver(index, messageID(), frame, len);
+  return true;
+}
+
+//----------------------------------------------------------------
+//-----------------------RedundantInterface-----------------------
+//----------------------------------------------------------------
+RedundantInterface::RedundantInterface() {
+  stopped = true;
+  memset(windows, 0, sizeof(windows));
+  memset(recent, 0, sizeof(recent));
+  memset(path_counters, 0, sizeof(path_counters));
+}
+
+bool RedundantInterface::addPath(int local_port, const std::string& captain_ip, int captain_port) {
+  if(n_paths >= REDUNDANT_MAX_PATHS) return false;
+  RedundantPath* path = new RedundantPath(this, n_paths, io_service);
+  if(!path->open(local_port, captain_ip, captain_port)) {
+    delete path;
+    return false;
+  }
+  path->setCapabilities(capabilities());
+  path->setBlackBox(blackBox());     //checksum errors are counted per path
+  paths[n_paths++] = path;
+  return true;
+}
+
+void RedundantInterface::start() {
+  stopped = false;
+  for(int i=0;i<n_paths;i++) paths[i]->start();
+}
+
+void RedundantInterface::applyLinkProfile(const LinkProfile& profile, std::vector<std::string>& report) {
+  for(int i=0;i<n_paths;i++) paths[i]->applyLinkProfile(profile, report);
+}
+
+void RedundantInterface::stop() {
+  if(stopped) return;
+  stopped = true;
+  for(int i=0;i<n_paths;i++) paths[i]->join();
+}
+
+bool RedundantInterface::send_data(char* buf, uint8_t len) {
+  //Sent if any path took it
+  bool sent = false;
+  for(int i=0;i<n_paths;i++) sent |= paths[i]->write(buf, len);
+  return sent;
+}
+
+void RedundantInterface::deliver(int path, uint8_t id, const char* frame, uint8_t len) {
+  uint64_t now = steady_ns();
+  std::lock_guard<std::mutex> lock(deliver_mutex);
+  PathCounters& pc = path_counters[path];
+  pc.received++;
+
+  //Back to '#', ID and payload, framed again for our own parser
+  char buf[255];
+  uint8_t n = len - 3;
+  memcpy(buf, frame, n);
+
+  //Receive time of the copy that is passed on
+  setReceiveTime(paths[path]->receiveTime());
+
+  //Every hello is passed on, it only sets the link mode
+  if(id == LINK_HELLO) {
+    inject(buf, finish_frame(buf, n, false));
+    return;
+  }
+
+  double lag_ms = -1;
+  switch(classify(path, id, frame + 2, n - 2, now, lag_ms)) {
+    case ARRIVAL_FIRST:
+      pc.wins++;
+      inject(buf, finish_frame(buf, n, crcMode()));
+      break;
+    case ARRIVAL_DUPLICATE:
+      pc.duplicates++;
+      if(lag_ms >= 0) add_lag(path, lag_ms);
+      break;
+    case ARRIVAL_STALE:
+      stale++;
+      break;
+  }
+}
+
+RedundantInterface::Arrival RedundantInterface::classify(int path, uint8_t id, const char* payload, uint8_t len, uint64_t now_ns, double& lag_ms) {
+  if(has_sequence_header(id) && len >= 12) {
+    uint32_t seq;
+    memcpy(&seq, payload + 8, 4);   // same byte order as parse_long
+    SequenceWindow& w = windows[id];
+    int slot = seq % REDUNDANT_SEQ_WINDOW;
+
+    if(!w.valid || (seq < w.highest && w.highest - seq > REDUNDANT_SEQ_RESTART)) {
+      w.valid = true;
+      w.highest = seq;
+      w.seen = 0;
+    }
+    if(seq > w.highest) {
+      uint32_t shift = seq - w.highest;
+      w.seen = shift >= REDUNDANT_SEQ_WINDOW ? 0 : w.seen << shift;
+      w.highest = seq;
+    }
+
+    uint32_t age = w.highest - seq;
+    if(age >= REDUNDANT_SEQ_WINDOW) return ARRIVAL_STALE;
+    uint64_t bit = 1ULL << age;
+    if(w.seen & bit) {
+      if(w.first_path[slot] != path) lag_ms = (now_ns - w.first_ns[slot]) * 1e-6;
+      return ARRIVAL_DUPLICATE;
+    }
+    w.seen |= bit;
+    w.first_ns[slot] = now_ns;
+    w.first_path[slot] = path;
+    return ARRIVAL_FIRST;
+  }
+
+  //Unsequenced: same ID and payload from another path shortly after
+  uint32_t hash = crc32c(payload, len);
+  uint64_t window_ns = REDUNDANT_MATCH_WINDOW * 1e9;
+  for(int i=0;i<REDUNDANT_MATCH_SLOTS;i++) {
+    RecentFrame& r = recent[i];
+    if(r.matched || r.id != id || r.hash != hash || r.path == path) continue;
+    if(r.first_ns == 0 || now_ns - r.first_ns > window_ns) continue;
+    r.matched = true;
+    lag_ms = (now_ns - r.first_ns) * 1e-6;
+    return ARRIVAL_DUPLICATE;
+  }
+
+  RecentFrame& r = recent[recent_next];
+  recent_next = (recent_next + 1) % REDUNDANT_MATCH_SLOTS;
+  r.id = id;
+  r.path = path;
+  r.matched = false;
+  r.hash = hash;
+  r.first_ns = now_ns;
+  return ARRIVAL_FIRST;
+}
+
+void RedundantInterface::add_lag(int path, double lag_ms) {
+  PathCounters& pc = path_counters[path];
+  pc.lag_sum_ms += lag_ms;
+  pc.lag_count++;
+  pc.lag_max_ms = std::max(pc.lag_max_ms, lag_ms);
+}
+
+RedundantPathStats RedundantInterface::stats(int path) {
+  std::lock_guard<std::mutex> lock(deliver_mutex);
+  PathCounters& pc = path_counters[path];
+  RedundantPathStats s;
+  s.received = pc.received;
+  s.wins = pc.wins;
+  s.duplicates = pc.duplicates;
+  s.checksum_errors = paths[path]->counters.checksum_errors;
+  s.lag_avg_ms = pc.lag_count > 0 ? pc.lag_sum_ms / pc.lag_count : 0;
+  s.lag_max_ms = pc.lag_max_ms;
+  pc.lag_sum_ms = 0;
+  pc.lag_max_ms = 0;
+  pc.lag_count = 0;
+  return s;
+}
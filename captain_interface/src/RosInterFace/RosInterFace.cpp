@@ -3,41 +3,154 @@
 void RosInterFace::init(ros::NodeHandle* nh, CaptainInterFace* cap) { 
   n = nh; captain = cap; 
 
+  //UTM zone used for waypoints given in UTM coordinates
+  int utm_zone = 34;
+  std::string utm_band = "V";
+  std::string key;
+  if(n->searchParam("utm_zone", key)) n->getParam(key, utm_zone);
+  if(n->searchParam("utm_band", key)) n->getParam(key, utm_band);
+  if(utm_band.empty()) utm_band = "V";
+  utm.setZone(utm_zone, utm_band[0]);
+  ROS_INFO("UTM zone: %d%c", utm_zone, utm_band[0]);
+
+  //Shared memory telemetry, disabled if no name is given
+  std::string shm_name;
+  ros::param::param<std::string>("~shm_telemetry", shm_name, "");
+  if(!shm_name.empty()) {
+    if(shm_telemetry.open(shm_name)) ROS_INFO("Shared memory telemetry: /dev/shm%s", shm_name.c_str());
+    else ROS_ERROR("Could not open shared memory telemetry %s", shm_name.c_str());
+  }
+
+  //Columnar telemetry recording, disabled if no directory is given
+  std::string store_dir;
+  int store_chunk_rows;
+  ros::param::param<std::string>("~telemetry_store", store_dir, "");
+  ros::param::param<int>("~telemetry_chunk_rows", store_chunk_rows, 4096);
+  if(!store_dir.empty()) {
+    if(telemetry_store.open(store_dir, store_chunk_rows)) ROS_INFO("Recording telemetry to %s", telemetry_store.directory().c_str());
+    else ROS_ERROR("Could not create telemetry store in %s", store_dir.c_str());
+  }
+
+  //Count heap allocations per message ID while decoding. Reported in the diagnostics
+  bool alloc_tracking;
+  ros::param::param<bool>("~alloc_tracking", alloc_tracking, false);
+  alloc_tracking_enable(alloc_tracking);
+  if(alloc_tracking && !alloc_hooks_installed()) ROS_WARN("Allocation tracking enabled, but the allocation hooks are not linked");
+
+  //Priority classed transmit queue
+  bool use_tx_scheduler;
+  ros::param::param<bool>("~tx_scheduler", use_tx_scheduler, true);
+  if(use_tx_scheduler) {
+    int safety_size, control_size, bulk_size;
+    double bulk_rate, bulk_burst;
+    ros::param::param<int>("~tx_queue_safety", safety_size, 8);
+    ros::param::param<int>("~tx_queue_control", control_size, 32);
+    ros::param::param<int>("~tx_queue_bulk", bulk_size, 64);
+    ros::param::param<double>("~tx_bulk_rate", bulk_rate, 4000.0);    // bytes/s, 0 = unlimited
+    ros::param::param<double>("~tx_bulk_burst", bulk_burst, 1024.0);  // bytes
+
+    //Path chunks time out from transmission, not from the bulk queue
+    tx_scheduler = new TxScheduler([this](char* frame, uint8_t len) {
+      if(!captain->send_frame(frame, len)) return false;
+      if((uint8_t) frame[1] == SC_SET_PATH && path_uploader != NULL) path_uploader->transmitted(frame+2, len-2);
+      return true;
+    });
+    tx_scheduler->configure(TX_SAFETY, safety_size, TX_REPLACE_SAME_ID);
+    tx_scheduler->configure(TX_CONTROL, control_size, TX_REPLACE_SAME_ID);
+    tx_scheduler->configure(TX_BULK, bulk_size, TX_DROP_NEWEST);
+    tx_scheduler->setBulkRate(bulk_rate, bulk_burst);
+    tx_scheduler->start();
+    captain->setScheduler(tx_scheduler);
+  }
+
+  //Black box of recent traffic, 0 frames to disable
+  int blackbox_frames;
+  double blackbox_seconds, blackbox_post_trigger;
+  std::string blackbox_dir;
+  ros::param::param<int>("~blackbox_frames", blackbox_frames, 8192);
+  ros::param::param<double>("~blackbox_seconds", blackbox_seconds, 10.0);
+  ros::param::param<double>("~blackbox_post_trigger", blackbox_post_trigger, 1.0);   // s recorded after the event
+  ros::param::param<std::string>("~blackbox_dir", blackbox_dir, "/tmp");
+  if(blackbox_frames > 0) {
+    blackbox.configure(blackbox_frames, blackbox_seconds, blackbox_post_trigger, blackbox_dir);
+    blackbox.start();
+    captain->setBlackBox(&blackbox);
+  }
+
+  //Receive lanes, started by start_rx_lanes() once the node is set up
+  bool use_rx_lanes;
+  ros::param::param<bool>("~rx_lanes", use_rx_lanes, true);
+  if(use_rx_lanes) rx_dispatcher = new RxDispatcher([this](RxFrame& frame) { decode(frame); });
+
+  //Header stamps: "captain" clock, "host" (captain time with the estimated offset) or "receive" time
+  std::string timestamp_mode;
+  double clock_window, clock_min_delay;
+  int clock_windows;
+  ros::param::param<std::string>("~timestamp_mode", timestamp_mode, "captain");
+  ros::param::param<double>("~clock_window", clock_window, 1.0);        // s per minimum
+  ros::param::param<int>("~clock_windows", clock_windows, 32);          // minima in the skew fit
+  ros::param::param<double>("~clock_min_delay", clock_min_delay, 0.0);  // s, assumed minimum one-way delay
+  captain_clock.configure(clock_window, clock_windows, clock_min_delay);
+  if(timestamp_mode == "host") stamp_mode = STAMP_HOST;
+  else if(timestamp_mode == "receive") stamp_mode = STAMP_RECEIVE;
+  else if(timestamp_mode != "captain") ROS_WARN("Unknown timestamp_mode %s, using captain", timestamp_mode.c_str());
+
+  //Raw frame relay to local subscribers, e.g. ["127.0.0.1:9000", "/tmp/lolo_relay;13,14"]
+  std::vector<std::string> relay_targets;
+  int relay_uplink_port;
+  std::string relay_uplink_path;
+  ros::param::get("~relay_targets", relay_targets);
+  ros::param::param<int>("~relay_uplink_port", relay_uplink_port, 0);
+  ros::param::param<std::string>("~relay_uplink_path", relay_uplink_path, "");
+  for(size_t i=0;i<relay_targets.size();i++) {
+    if(relay.addTarget(relay_targets[i])) ROS_INFO("Relaying captain frames to %s", relay_targets[i].c_str());
+    else ROS_ERROR("Invalid relay target %s", relay_targets[i].c_str());
+  }
+  if(!relay.start(captain, relay_uplink_port, relay_uplink_path)) ROS_ERROR("Could not start relay uplink");
+
+  //Node handles for the separate callback queues
+  ros::NodeHandle safety_nh(*n), control_nh(*n), bulk_nh(*n);
+  init_spinner(safety_spinner, safety_nh);
+  init_spinner(control_spinner, control_nh);
+  init_spinner(bulk_spinner, bulk_nh);
+
   //==================================//
   //=========== Subscribers ==========//
   //==================================//
 
   //information / other things
-  heartbeat_sub  = n->subscribe<std_msgs::Empty>("/lolo/core/heartbeat", 1, &RosInterFace::ros_callback_heartbeat, this);
-  //done_sub  = n->subscribe<std_msgs::Empty>("/lolo/core/mission_complete", 1, &RosInterFace::ros_callback_done, this);
-  abort_sub  = n->subscribe<std_msgs::Empty>("/lolo/core/abort", 1, &RosInterFace::ros_callback_abort, this);
+  heartbeat_sub  = safety_nh.subscribe<std_msgs::Empty>("/lolo/core/heartbeat", 1, &RosInterFace::ros_callback_heartbeat, this);
+  //done_sub  = safety_nh.subscribe<std_msgs::Empty>("/lolo/core/mission_complete", 1, &RosInterFace::ros_callback_done, this);
+  abort_sub  = safety_nh.subscribe<std_msgs::Empty>("/lolo/core/abort", 1, &RosInterFace::ros_callback_abort, this);
 
   //Control commands: High level
-  waypoint_sub  = n->subscribe<geographic_msgs::GeoPoint>("/lolo/ctrl/waypoint_setpoint"  ,1, &RosInterFace::ros_callback_waypoint, this);
-  speed_sub     = n->subscribe<std_msgs::Float64>("/lolo/ctrl/speed_setpoint"       ,1, &RosInterFace::ros_callback_speed,this);
-  depth_sub     = n->subscribe<std_msgs::Float64>("/lolo/ctrl/depth_setpoint"       ,1, &RosInterFace::ros_callback_depth,this);
-  altitude_sub  = n->subscribe<std_msgs::Float64>("/lolo/ctrl/altitude_setpoint"    ,1, &RosInterFace::ros_callback_altitude,this);
+  waypoint_sub  = control_nh.subscribe<geographic_msgs::GeoPoint>("/lolo/ctrl/waypoint_setpoint"  ,1, &RosInterFace::ros_callback_waypoint, this);
+  waypoint_utm_sub = control_nh.subscribe<geometry_msgs::Point>("/lolo/ctrl/waypoint_setpoint_utm" ,1, &RosInterFace::ros_callback_waypoint_utm, this);
+  path_sub      = control_nh.subscribe<geographic_msgs::GeoPath>("/lolo/ctrl/waypoint_path"    ,1, &RosInterFace::ros_callback_path, this);
+  speed_sub     = control_nh.subscribe<std_msgs::Float64>("/lolo/ctrl/speed_setpoint"       ,1, &RosInterFace::ros_callback_speed,this);
+  depth_sub     = control_nh.subscribe<std_msgs::Float64>("/lolo/ctrl/depth_setpoint"       ,1, &RosInterFace::ros_callback_depth,this);
+  altitude_sub  = control_nh.subscribe<std_msgs::Float64>("/lolo/ctrl/altitude_setpoint"    ,1, &RosInterFace::ros_callback_altitude,this);
 
   //Control commands medium level
-  yaw_sub       = n->subscribe<std_msgs::Float64>("/lolo/ctrl/yaw_setpoint"          ,1, &RosInterFace::ros_callback_yaw,this);
-  yawrate_sub   = n->subscribe<std_msgs::Float64>("/lolo/ctrl/yawrate_setpoint"      ,1, &RosInterFace::ros_callback_yawrate,this);
-  pitch_sub     = n->subscribe<std_msgs::Float64>("/lolo/ctrl/pitch_setpoint"        ,1, &RosInterFace::ros_callback_pitch,this);
-  rpm_sub       = n->subscribe<smarc_msgs::ThrusterRPM>("/lolo/ctrl/rpm_setpoint"          ,1, &RosInterFace::ros_callback_rpm, this);
+  yaw_sub       = control_nh.subscribe<std_msgs::Float64>("/lolo/ctrl/yaw_setpoint"          ,1, &RosInterFace::ros_callback_yaw,this);
+  yawrate_sub   = control_nh.subscribe<std_msgs::Float64>("/lolo/ctrl/yawrate_setpoint"      ,1, &RosInterFace::ros_callback_yawrate,this);
+  pitch_sub     = control_nh.subscribe<std_msgs::Float64>("/lolo/ctrl/pitch_setpoint"        ,1, &RosInterFace::ros_callback_pitch,this);
+  rpm_sub       = control_nh.subscribe<smarc_msgs::ThrusterRPM>("/lolo/ctrl/rpm_setpoint"          ,1, &RosInterFace::ros_callback_rpm, this);
 
   //Control commands low level
   //Thruster
-  thrusterPort_sub = n->subscribe<smarc_msgs::ThrusterRPM>("/lolo/core/thruster1_cmd", 1, &RosInterFace::ros_callback_thrusterPort, this);
-  thrusterStrb_sub = n->subscribe<smarc_msgs::ThrusterRPM>("/lolo/core/thruster2_cmd", 1, &RosInterFace::ros_callback_thrusterStrb, this);
+  thrusterPort_sub = control_nh.subscribe<smarc_msgs::ThrusterRPM>("/lolo/core/thruster1_cmd", 1, &RosInterFace::ros_callback_thrusterPort, this);
+  thrusterStrb_sub = control_nh.subscribe<smarc_msgs::ThrusterRPM>("/lolo/core/thruster2_cmd", 1, &RosInterFace::ros_callback_thrusterStrb, this);
 
   //control surfaces
-  rudder_sub      = n->subscribe<std_msgs::Float32>("/lolo/core/rudder_cmd"   ,1, &RosInterFace::ros_callback_rudder, this);
-  elevator_sub    = n->subscribe<std_msgs::Float32>("/lolo/core/elevator_cmd" ,1, &RosInterFace::ros_callback_elevator, this);
+  rudder_sub      = control_nh.subscribe<std_msgs::Float32>("/lolo/core/rudder_cmd"   ,1, &RosInterFace::ros_callback_rudder, this);
+  elevator_sub    = control_nh.subscribe<std_msgs::Float32>("/lolo/core/elevator_cmd" ,1, &RosInterFace::ros_callback_elevator, this);
 
   //"Service"
-  service_sub     = n->subscribe<lolo_msgs::CaptainService>("/lolo/core/captain_srv_in" ,1, &RosInterFace::ros_callback_service, this);
+  service_sub     = bulk_nh.subscribe<lolo_msgs::CaptainService>("/lolo/core/captain_srv_in" ,1, &RosInterFace::ros_callback_service, this);
 
   //menu
-  menu_sub        = n->subscribe<std_msgs::String>("/lolo/console_in", 1, &RosInterFace::ros_callback_menu, this);
+  menu_sub        = bulk_nh.subscribe<std_msgs::String>("/lolo/console_in", 1, &RosInterFace::ros_callback_menu, this);
 
   //==================================//
   //=========== Publishers ===========//
@@ -45,16 +158,25 @@ void RosInterFace::init(ros::NodeHandle* nh, CaptainInterFace* cap) {
   // --- Thrusters --- //
   thrusterPort_pub     = n->advertise<smarc_msgs::ThrusterFeedback>("/lolo/core/thruster1_fb", 10);
   thrusterStrb_pub     = n->advertise<smarc_msgs::ThrusterFeedback>("/lolo/core/thruster2_fb", 10);
+  thruster_port_msg.header.frame_id = "lolo/thruster_port";
+  thruster_strb_msg.header.frame_id = "lolo/thruster_stbd";
 
   // --- Rudders --- //
   rudder_angle_pub    = n->advertise<smarc_msgs::FloatStamped>("/lolo/core/rudder_fb", 10);
+  rudder_msg.header.frame_id = "lolo/rudder_port";
 
   // --- Elevator --- //
   elevator_angle_pub      = n->advertise<smarc_msgs::FloatStamped>("/lolo/core/elevator_fb", 10);
+  elevator_msg.header.frame_id = "lolo/elvator";
 
   // --- Elevons --- //
   elevon_port_angle_pub   = n->advertise<smarc_msgs::FloatStamped>("/lolo/core/elevon_port_fb", 10);
   elevon_strb_angle_pub   = n->advertise<smarc_msgs::FloatStamped>("/lolo/core/elevon_strb_fb", 10);
+  elevon_port_msg.header.frame_id = "lolo/elevon_port";
+  elevon_strb_msg.header.frame_id = "lolo/elevon_stbd";
+
+  // --- Joint states --- //
+  init_joint_states();
 
   //Battery
   battery_pub = n->advertise<sensor_msgs::BatteryState>("/lolo/core/battery",10);
@@ -62,20 +184,81 @@ void RosInterFace::init(ros::NodeHandle* nh, CaptainInterFace* cap) {
   //Leak sensors
   leak_dome   = n->advertise<smarc_msgs::Leak>("/lolo/core/leak", 10);
 
-  control_status_pub        = n->advertise<lolo_msgs::CaptainStatus>("/lolo/core/control_status", 10);
-  ctrl_status_waypoint_pub  = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_waypoint_controller_status",10);
-  ctrl_status_yaw_pub       = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_yaw_controller_status",10);
-  ctrl_status_yawrate_pub   = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_yawrate_controller_status",10);
-  ctrl_status_depth_pub     = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_depth_controller_status",10);
-  ctrl_status_altitude_pub  = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_altitude_controller_status",10);
-  ctrl_status_pitch_pub     = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_pitch_controller_status",10);
-  ctrl_status_speed_pub     = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_speed_controller_status",10);
+  //Dead reckoning. Off by default, the CS_IMU and CS_POSITION layouts are unconfirmed
+  ros::param::param<bool>("~publish_dr", publish_dr, false);
+  if(publish_dr) {
+    dr_latlon_pub = n->advertise<geographic_msgs::GeoPoint>("/lolo/dr/lat_lon", 10);
+    dr_depth_pub  = n->advertise<std_msgs::Float64>("/lolo/dr/depth", 10);
+    dr_roll_pub   = n->advertise<std_msgs::Float64>("/lolo/dr/roll", 10);
+    dr_pitch_pub  = n->advertise<std_msgs::Float64>("/lolo/dr/pitch", 10);
+    dr_yaw_pub    = n->advertise<std_msgs::Float64>("/lolo/dr/yaw", 10);
+    dr_odom_pub   = n->advertise<nav_msgs::Odometry>("/lolo/dr/odom", 10);
+  }
+
+  //Odometry covariance. Diagonal, position in m^2 and orientation in rad^2
+  double position_variance, depth_variance, orientation_variance, rate_variance;
+  ros::param::param<double>("~dr_position_variance", position_variance, 1.0);
+  ros::param::param<double>("~dr_depth_variance", depth_variance, 0.01);
+  ros::param::param<double>("~dr_orientation_variance", orientation_variance, 0.001);
+  ros::param::param<double>("~dr_rate_variance", rate_variance, 0.001);
+  dr_odom.header.frame_id = "utm";
+  dr_odom.child_frame_id = "lolo/base_link";
+  dr_odom.pose.covariance[0]  = position_variance;
+  dr_odom.pose.covariance[7]  = position_variance;
+  dr_odom.pose.covariance[14] = depth_variance;
+  dr_odom.pose.covariance[21] = orientation_variance;
+  dr_odom.pose.covariance[28] = orientation_variance;
+  dr_odom.pose.covariance[35] = orientation_variance;
+  dr_odom.twist.covariance[0]  = -1; //Linear velocity is not provided
+  dr_odom.twist.covariance[21] = rate_variance;
+  dr_odom.twist.covariance[28] = rate_variance;
+  dr_odom.twist.covariance[35] = rate_variance;
+
+  //The utm pose goes to world_ned through the utm -> world_ned transform
+  ros::param::param<bool>("~publish_tf", publish_tf, false);
+  publish_tf = publish_tf && publish_dr;
+  if(publish_tf) {
+    tf_broadcaster = new tf2_ros::TransformBroadcaster();
+    tf_buffer = new tf2_ros::Buffer();
+    tf_listener = new tf2_ros::TransformListener(*tf_buffer);
+    base_link_tf.header.frame_id = "world_ned";
+    base_link_tf.child_frame_id = dr_odom.child_frame_id;
+  }
+
+  //Captain status. Off by default, the CS_STATUS layout is unconfirmed
+  ros::param::param<bool>("~publish_status", publish_status, false);
+
+  //Status topics are latched and only published on change
+  if(publish_status) control_status_pub = n->advertise<lolo_msgs::CaptainStatus>("/lolo/core/control_status", 10, true);
+  ctrl_status_waypoint_pub  = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_waypoint_controller_status",10,true);
+  ctrl_status_yaw_pub       = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_yaw_controller_status",10,true);
+  ctrl_status_yawrate_pub   = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_yawrate_controller_status",10,true);
+  ctrl_status_depth_pub     = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_depth_controller_status",10,true);
+  ctrl_status_altitude_pub  = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_altitude_controller_status",10,true);
+  ctrl_status_pitch_pub     = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_pitch_controller_status",10,true);
+  ctrl_status_speed_pub     = n->advertise<smarc_msgs::ControllerStatus>("/lolo/ctrl/onboard_speed_controller_status",10,true);
   //ctrl_status_rpm_pub      = n->advertise<lolo_msgs::ControllerStatus>("/lolo/ctrl/onboard_rpm_controller_status");
   //ctrl_status_rpm_strb_pub = n->advertise<lolo_msgs::ControllerStatus>("/lolo/ctrl/onboard_rpm_strb_controller_status");
   //ctrl_status_rpm_port_pub = n->advertise<lolo_msgs::ControllerStatus>("/lolo/ctrl/onboard_rpm_port_controller_status");
   //ctrl_status_elevator_pub = n->advertise<lolo_msgs::ControllerStatus>("/lolo/ctrl/onboard_elevator_controller_status");
   //ctrl_status_rudder_pub   = n->advertise<lolo_msgs::ControllerStatus>("/lolo/ctrl/onboard_rudder_controller_status");
   //ctrl_status_VBS_pub      = n->advertise<lolo_msgs::ControllerStatus>("/lolo/ctrl/onboard_VBS_controller_status");
+  ctrl_status_msgs[CONTROLLER_WAYPOINT].service_name  = "/lolo/ctrl/toggle_onboard_waypoint_ctrl";
+  ctrl_status_msgs[CONTROLLER_YAW].service_name       = "/lolo/ctrl/toggle_onboard_yaw_ctrl";
+  ctrl_status_msgs[CONTROLLER_YAWRATE].service_name   = "/lolo/ctrl/toggle_onboard_yawrate_ctrl";
+  ctrl_status_msgs[CONTROLLER_DEPTH].service_name     = "/lolo/ctrl/toggle_onboard_depth_ctrl";
+  ctrl_status_msgs[CONTROLLER_ALTITUDE].service_name  = "/lolo/ctrl/toggle_onboard_altitude_ctrl";
+  ctrl_status_msgs[CONTROLLER_PITCH].service_name     = "/lolo/ctrl/toggle_onboard_pitch_ctrl";
+  ctrl_status_msgs[CONTROLLER_SPEED].service_name     = "/lolo/ctrl/toggle_onboard_speed_ctrl";
+
+  //Waypoint path upload, acknowledged through the service channel
+  path_uploader = new PathUploader([this](uint8_t id, const char* data, uint8_t len) { return captain->send_payload(id, data, len); });
+  path_confirmed_pub = n->advertise<std_msgs::Int32>("/lolo/ctrl/waypoint_path_confirmed", 1, true);
+  path_upload_timer = n->createTimer(ros::Duration(0.1), &RosInterFace::path_upload_timer_callback, this);
+  memset(&path_upload_last, 0, sizeof(path_upload_last));
+
+  //Captain streams enabled by subscriber demand, through the service channel as well
+  init_stream_control();
 
   //"Service"
   service_pub             = n->advertise<lolo_msgs::CaptainService>("/lolo/core/captain_srv_out", 10);
@@ -89,4 +272,45 @@ void RosInterFace::init(ros::NodeHandle* nh, CaptainInterFace* cap) {
   //Log publishers
   missonlog_pub = n->advertise<std_msgs::String>("/lolo/log/mission", 1);
   datalog_pub = n->advertise<std_msgs::String>("/lolo/log/data", 1);
+
+  //Decimation, throttling and aggregation of the telemetry topics above
+  init_topic_policies();
+
+  //Diagnostics
+  diagnostics_pub = n->advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+  diagnostics_timer = n->createTimer(ros::Duration(1.0), &RosInterFace::publish_diagnostics, this);
+
+  //==================================//
+  //============ Services ============//
+  //==================================//
+  vehicle_state_srv = bulk_nh.advertiseService("/lolo/core/vehicle_state", &RosInterFace::ros_service_vehicle_state, this);
+  blackbox_srv = bulk_nh.advertiseService("/lolo/core/captain_blackbox", &RosInterFace::ros_service_blackbox, this);
+
+  safety_spinner.start();
+  control_spinner.start();
+  bulk_spinner.start();
 };
+
+void RosInterFace::init_spinner(CallbackSpinner& spinner, ros::NodeHandle& nh) {
+  //Optional cpu pinning and SCHED_FIFO priority, e.g. ~spinner_control_cpu: 2, ~spinner_control_priority: 50
+  int cpu, priority;
+  ros::param::param<int>("~spinner_" + spinner.getName() + "_cpu", cpu, -1);
+  ros::param::param<int>("~spinner_" + spinner.getName() + "_priority", priority, 0);
+  spinner.setAffinity(cpu);
+  spinner.setPriority(priority);
+  nh.setCallbackQueue(spinner.getQueue());
+}
+
+void RosInterFace::stop_spinners() {
+  safety_spinner.stop();
+  control_spinner.stop();
+  bulk_spinner.stop();
+  if(rx_dispatcher != NULL) rx_dispatcher->stop();
+  blackbox.stop();
+}
+
+void RosInterFace::start_rx_lanes() {
+  if(rx_dispatcher == NULL) return;
+  rx_dispatcher->start();
+  ROS_INFO("Captain frames decoded on the feedback, service and log lanes");
+}
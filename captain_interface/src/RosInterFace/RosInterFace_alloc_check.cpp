@@ -0,0 +1,93 @@
+#include "captain_interface/RosInterFace/RosInterFace.h"
+#include <string.h>
+
+#define ALLOC_CHECK_WARMUP  100
+#define ALLOC_CHECK_ROUNDS  1000
+
+//Synthetic frames with the same layout as the captain sends
+struct AllocCheckFrame {
+  char data[255];
+  uint8_t len;
+
+  void begin(uint8_t id) {len = 0; data[len++] = '#'; data[len++] = id;}
+  void add(const void* p, uint8_t n) {memcpy(data + len, p, n); len += n;}
+  void add_float(float f) {add(&f, 4);}
+  void add_header(uint64_t timestamp, uint32_t sequence) {
+    uint32_t msb = timestamp >> 32, lsb = timestamp;
+    add(&msb, 4); add(&lsb, 4); add(&sequence, 4);
+  }
+  void end() {len = CaptainInterFace::finish_frame(data, len, false);}
+};
+
+static void build_surface(AllocCheckFrame& f, uint8_t id, int round) {
+  f.begin(id);
+  f.add_header(1600000000000000ULL + round * 10000ULL, round);
+  f.add_float(0.01f * (round % 50));
+  f.add_float(0.01f * (round % 40));
+  f.end();
+}
+
+static void build_thruster(AllocCheckFrame& f, uint8_t id, int round) {
+  f.begin(id);
+  f.add_header(1600000000000000ULL + round * 10000ULL, round);
+  for(int i=0;i<6;i++) f.add_float(100.0f + round + i);
+  f.end();
+}
+
+static void build_ctrl_status(AllocCheckFrame& f, int round) {
+  f.begin(CS_CTRL_STATUS);
+  for(int i=0;i<VEHICLESTATE_N_CONTROLLERS;i++) {
+    uint8_t enabled = ((round >> (i % 4)) & 1);  //every controller toggles now and then
+    f.add(&enabled, 1);
+  }
+  f.end();
+}
+
+bool RosInterFace::run_alloc_check() {
+  if(!alloc_hooks_installed()) {
+    ROS_ERROR("Allocation check: the allocation hooks are not linked");
+    return false;
+  }
+
+  const uint8_t ids[] = {CS_THRUSTER_PORT, CS_THRUSTER_STRB, CS_RUDDER, CS_ELEVATOR,
+                         CS_ELEVON_PORT, CS_ELEVON_STRB, CS_CTRL_STATUS};
+  const int n_ids = sizeof(ids) / sizeof(ids[0]);
+  AllocCheckFrame frame;
+
+  //The check runs without subscribers. Take the paths that fill and publish
+  //the messages, not the early returns
+  alloc_checking = true;
+  bool was_enabled = alloc_tracking_enabled();
+  alloc_tracking_enable(true);
+
+  for(int round=0;round<ALLOC_CHECK_WARMUP+ALLOC_CHECK_ROUNDS;round++) {
+    if(round == ALLOC_CHECK_WARMUP) alloc_counters_reset();   //first frames may size buffers
+    for(int i=0;i<n_ids;i++) {
+      if(ids[i] == CS_CTRL_STATUS) build_ctrl_status(frame, round);
+      else if(ids[i] == CS_THRUSTER_PORT || ids[i] == CS_THRUSTER_STRB) build_thruster(frame, ids[i], round);
+      else build_surface(frame, ids[i], round);
+      captain->inject(frame.data, frame.len);
+    }
+  }
+
+  bool passed = true;
+  for(int i=0;i<n_ids;i++) {
+    uint32_t count = alloc_counters.decode[ids[i]];
+    uint32_t received = captain->counters.received[ids[i]];
+    ROS_INFO("Allocation check: message %3d: %u allocations in %d frames (%u decoded)", ids[i], count, ALLOC_CHECK_ROUNDS, received);
+    if(count > 0) passed = false;
+    if(received < ALLOC_CHECK_WARMUP + ALLOC_CHECK_ROUNDS) {
+      ROS_ERROR("Allocation check: message %d was not decoded", ids[i]);
+      passed = false;
+    }
+  }
+  ROS_INFO("Allocation check: %u allocations while publishing (not counted)", alloc_counters.publish.load());
+
+  if(passed) ROS_INFO("Allocation check passed");
+  else ROS_ERROR("Allocation check failed");
+
+  alloc_tracking_enable(was_enabled);
+  alloc_counters_reset();
+  alloc_checking = false;
+  return passed;
+}
@@ -1,225 +1,424 @@
 #include "captain_interface/RosInterFace/RosInterFace.h"
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 #include <limits.h>
+#include <math.h>
+
+ros::Time RosInterFace::stamp(uint64_t captain_us, const RxFrame& frame) {
+  uint64_t ns;
+  switch(stamp_mode) {
+    case STAMP_HOST:
+      if(captain_clock.toHost(captain_us, ns)) break;
+      //receive time until the offset is known
+    case STAMP_RECEIVE:
+      if(frame.rx_ns != 0) { ns = frame.rx_ns; break; }
+      //captain time without a receive time
+    default:
+      ns = captain_us * 1000;
+  }
+  ros::Time t;
+  t.fromNSec(ns);
+  return t;
+}
+
+//The payloads are decoded by MessageCodec, shared with captain_decode and the
+//telemetry store. Frames shorter than their layout are dropped there with a
+//warning. The callbacks below only map the decoded messages to the vehicle
+//state cache and to ROS messages.
+//
+//Subscriber gating. Frames the vehicle state cache holds (control surfaces,
+//thrusters, IMU, position, status, controller status, leaks) are always
+//decoded into the cache, and only building their messages is skipped without
+//subscribers. The other frames (text, mission and data log) return before
+//decoding without subscribers; the menu stream is still printed to the console.
+
+//Fields aggregated by the topic policies
+static void set_angle(smarc_msgs::FloatStamped& msg, const float* v) {msg.data = v[0];}
+static void set_value(std_msgs::Float64& msg, const float* v) {msg.data = v[0];}
+static void set_thruster(smarc_msgs::ThrusterFeedback& msg, const float* v) {
+  msg.rpm.rpm = v[0];
+  msg.current = v[1];
+  msg.torque = v[2];
+}
+
+void RosInterFace::captain_callback_LEAK(RxFrame& frame) {
+  vehicle_state.edit().leaks++;
+  vehicle_state.commit();
+  blackbox.trigger("leak");
 
-void RosInterFace::captain_callback_LEAK() {
   smarc_msgs::Leak msg;
-  leak_dome.publish(msg);
+  publish(leak_dome, msg);
 }
 
-void RosInterFace::captain_callback_CONTROL() {
+void RosInterFace::captain_callback_CONTROL(RxFrame& frame) {
   //TODO send control feedback information
 }
 
-void RosInterFace::captain_callback_RUDDER() {
-  uint64_t timestamp    = captain->parse_llong();
-  uint32_t sequence     = captain->parse_long();
-  uint64_t sec = timestamp / 1000000;
-  uint64_t usec = timestamp % 1000000;
-
-  float target_angle    = captain->parse_float();
-  float current_angle   = captain->parse_float();
-
-  smarc_msgs::FloatStamped angle_message;
-  angle_message.data = current_angle;
-  angle_message.header.stamp = ros::Time(sec,usec*1000);
-  angle_message.header.seq = sequence;
-  angle_message.header.frame_id = "lolo/rudder_port";
-  rudder_angle_pub.publish(angle_message);
-}
-
-void RosInterFace::captain_callback_ELEVATOR() {
-  uint64_t timestamp    = captain->parse_llong();
-  uint32_t sequence     = captain->parse_long();
-  uint64_t sec = timestamp / 1000000;
-  uint64_t usec = timestamp % 1000000;
-
-  float target_angle    = captain->parse_float();
-  float current_angle   = captain->parse_float();
-
-  smarc_msgs::FloatStamped angle_message;
-  angle_message.data = current_angle;
-  angle_message.header.stamp = ros::Time(sec,usec*1000);
-  angle_message.header.seq = sequence;
-  angle_message.header.frame_id = "lolo/elvator";
-  elevator_angle_pub.publish(angle_message);
-}
-
-void RosInterFace::captain_callback_ELEVON_PORT() {
-  uint64_t timestamp    = captain->parse_llong();
-  uint32_t sequence     = captain->parse_long();
-  uint64_t sec = timestamp / 1000000;
-  uint64_t usec = timestamp % 1000000;
-
-  float target_angle    = captain->parse_float();
-  float current_angle   = captain->parse_float();
-
-  smarc_msgs::FloatStamped angle_message;
-  angle_message.data = current_angle;
-  angle_message.header.stamp = ros::Time(sec,usec*1000);
-  angle_message.header.seq = sequence;
-  angle_message.header.frame_id = "lolo/elevon_port";
-  elevon_port_angle_pub.publish(angle_message);
-}
-
-void RosInterFace::captain_callback_ELEVON_STRB() {
-  uint64_t timestamp    = captain->parse_llong();
-  uint32_t sequence     = captain->parse_long(); 
-  uint64_t sec = timestamp / 1000000;
-  uint64_t usec = timestamp % 1000000;
-
-  float target_angle    = captain->parse_float();
-  float current_angle   = captain->parse_float();
-
-  smarc_msgs::FloatStamped angle_message;
-  angle_message.data = current_angle;
-  angle_message.header.stamp = ros::Time(sec,usec*1000);
-  angle_message.header.seq = sequence;
-  angle_message.header.frame_id = "lolo/elevon_stbd";
-  elevon_strb_angle_pub.publish(angle_message);
-}
-
-void RosInterFace::captain_callback_THRUSTER_PORT() {
-  uint64_t timestamp    = captain->parse_llong();
-  uint32_t sequence     = captain->parse_long();
-  uint64_t sec = timestamp / 1000000;
-  uint64_t usec = timestamp % 1000000;
-
-  float rpm_setpoint    = captain->parse_float();
-  float rpm             = captain->parse_float();
-  float current         = captain->parse_float();
-  float torque          = captain->parse_float();
-  float energy          = captain->parse_float();
-  float voltage         = captain->parse_float();
-
-  smarc_msgs::ThrusterFeedback thruster_msg;
-  thruster_msg.header.stamp = ros::Time(sec,usec*1000);
-  thruster_msg.header.seq = sequence;
-  thruster_msg.header.frame_id = "lolo/thruster_port";
-  thruster_msg.rpm.rpm = rpm;
-  thruster_msg.current = current;
-  thruster_msg.torque = torque;
-  thrusterPort_pub.publish(thruster_msg);
-}
-
-void RosInterFace::captain_callback_THRUSTER_STRB() {
-  uint64_t timestamp    = captain->parse_llong();
-  uint32_t sequence     = captain->parse_long();
-  uint64_t sec = timestamp / 1000000;
-  uint64_t usec = timestamp % 1000000;
-
-  float rpm_setpoint    = captain->parse_float();
-  float rpm             = captain->parse_float();
-  float current         = captain->parse_float();
-  float torque          = captain->parse_float();
-  float energy          = captain->parse_float();
-  float voltage         = captain->parse_float();
-  
-  smarc_msgs::ThrusterFeedback thruster_msg;
-  thruster_msg.header.stamp = ros::Time(sec,usec*1000);
-  thruster_msg.header.seq = sequence;
-  thruster_msg.header.frame_id = "lolo/thruster_stbd";
-  thruster_msg.rpm.rpm = rpm;
-  thruster_msg.current = current;
-  thruster_msg.torque = torque;
-  thrusterStrb_pub.publish(thruster_msg);
-}
-
-void RosInterFace::captain_callback_BATTERY() {
+void RosInterFace::captain_callback_RUDDER(RxFrame& frame) {
+  SurfaceMessage m;
+  if(!decode_surface(frame.msgID, frame.data, frame.len, m)) return;
+
+  ControlSurfaceState& surface = vehicle_state.edit().rudder;
+  surface.timestamp = m.timestamp;
+  surface.target_angle = m.target_angle;
+  surface.angle = m.angle;
+  vehicle_state.commit();
+  joint_state_feedback(JOINT_SOURCE_RUDDER);
+
+  if(!topic_admit(TOPIC_RUDDER, &m.angle)) return;
+
+  rudder_msg.header.stamp = stamp(m.timestamp, frame);
+  rudder_msg.header.seq = m.sequence;
+  publish_topic(TOPIC_RUDDER, rudder_msg, set_angle);
+}
+
+void RosInterFace::captain_callback_ELEVATOR(RxFrame& frame) {
+  SurfaceMessage m;
+  if(!decode_surface(frame.msgID, frame.data, frame.len, m)) return;
+
+  ControlSurfaceState& surface = vehicle_state.edit().elevator;
+  surface.timestamp = m.timestamp;
+  surface.target_angle = m.target_angle;
+  surface.angle = m.angle;
+  vehicle_state.commit();
+  joint_state_feedback(JOINT_SOURCE_ELEVATOR);
+
+  if(!topic_admit(TOPIC_ELEVATOR, &m.angle)) return;
+
+  elevator_msg.header.stamp = stamp(m.timestamp, frame);
+  elevator_msg.header.seq = m.sequence;
+  publish_topic(TOPIC_ELEVATOR, elevator_msg, set_angle);
+}
+
+void RosInterFace::captain_callback_ELEVON_PORT(RxFrame& frame) {
+  SurfaceMessage m;
+  if(!decode_surface(frame.msgID, frame.data, frame.len, m)) return;
+
+  ControlSurfaceState& surface = vehicle_state.edit().elevon_port;
+  surface.timestamp = m.timestamp;
+  surface.target_angle = m.target_angle;
+  surface.angle = m.angle;
+  vehicle_state.commit();
+  joint_state_feedback(JOINT_SOURCE_ELEVON_PORT);
+
+  if(!topic_admit(TOPIC_ELEVON_PORT, &m.angle)) return;
+
+  elevon_port_msg.header.stamp = stamp(m.timestamp, frame);
+  elevon_port_msg.header.seq = m.sequence;
+  publish_topic(TOPIC_ELEVON_PORT, elevon_port_msg, set_angle);
+}
+
+void RosInterFace::captain_callback_ELEVON_STRB(RxFrame& frame) {
+  SurfaceMessage m;
+  if(!decode_surface(frame.msgID, frame.data, frame.len, m)) return;
+
+  ControlSurfaceState& surface = vehicle_state.edit().elevon_strb;
+  surface.timestamp = m.timestamp;
+  surface.target_angle = m.target_angle;
+  surface.angle = m.angle;
+  vehicle_state.commit();
+  joint_state_feedback(JOINT_SOURCE_ELEVON_STRB);
+
+  if(!topic_admit(TOPIC_ELEVON_STRB, &m.angle)) return;
+
+  elevon_strb_msg.header.stamp = stamp(m.timestamp, frame);
+  elevon_strb_msg.header.seq = m.sequence;
+  publish_topic(TOPIC_ELEVON_STRB, elevon_strb_msg, set_angle);
+}
+
+void RosInterFace::captain_callback_THRUSTER_PORT(RxFrame& frame) {
+  ThrusterMessage m;
+  if(!decode_thruster(frame.msgID, frame.data, frame.len, m)) return;
+
+  ThrusterState& thruster = vehicle_state.edit().thruster_port;
+  thruster.timestamp = m.timestamp;
+  thruster.rpm_setpoint = m.rpm_setpoint;
+  thruster.rpm = m.rpm;
+  thruster.current = m.current;
+  thruster.torque = m.torque;
+  thruster.energy = m.energy;
+  thruster.voltage = m.voltage;
+  vehicle_state.commit();
+  joint_state_feedback(JOINT_SOURCE_THRUSTER_PORT);
+
+  float fields[3] = {m.rpm, m.current, m.torque};
+  if(!topic_admit(TOPIC_THRUSTER_PORT, fields)) return;
+
+  thruster_port_msg.header.stamp = stamp(m.timestamp, frame);
+  thruster_port_msg.header.seq = m.sequence;
+  publish_topic(TOPIC_THRUSTER_PORT, thruster_port_msg, set_thruster);
+}
+
+void RosInterFace::captain_callback_THRUSTER_STRB(RxFrame& frame) {
+  ThrusterMessage m;
+  if(!decode_thruster(frame.msgID, frame.data, frame.len, m)) return;
+
+  ThrusterState& thruster = vehicle_state.edit().thruster_strb;
+  thruster.timestamp = m.timestamp;
+  thruster.rpm_setpoint = m.rpm_setpoint;
+  thruster.rpm = m.rpm;
+  thruster.current = m.current;
+  thruster.torque = m.torque;
+  thruster.energy = m.energy;
+  thruster.voltage = m.voltage;
+  vehicle_state.commit();
+  joint_state_feedback(JOINT_SOURCE_THRUSTER_STRB);
+
+  float fields[3] = {m.rpm, m.current, m.torque};
+  if(!topic_admit(TOPIC_THRUSTER_STRB, fields)) return;
+
+  thruster_strb_msg.header.stamp = stamp(m.timestamp, frame);
+  thruster_strb_msg.header.seq = m.sequence;
+  publish_topic(TOPIC_THRUSTER_STRB, thruster_strb_msg, set_thruster);
+}
+
+void RosInterFace::captain_callback_BATTERY(RxFrame& frame) {
   //TODO parse and publish battery information
 }
 
-void RosInterFace::captain_callback_CTRL_STATUS() {
-  bool scientistinterface_enable_waypoint = captain->parse_byte();
-  bool scientistinterface_enable_yaw      = captain->parse_byte();
-  bool scientistinterface_enable_yawrate  = captain->parse_byte();
-  bool scientistinterface_enable_depth    = captain->parse_byte();
-  bool scientistinterface_enable_altitude = captain->parse_byte();
-  bool scientistinterface_enable_pitch    = captain->parse_byte();
-  bool scientistinterface_enable_speed    = captain->parse_byte();
-  bool scientistinterface_enable_rpm      = captain->parse_byte();
-  bool scientistinterface_enable_rpm_strb = captain->parse_byte();
-  bool scientistinterface_enable_rpm_port = captain->parse_byte();
-  bool scientistinterface_enable_elevator = captain->parse_byte();
-  bool scientistinterface_enable_rudder   = captain->parse_byte();
-  bool scientistinterface_enable_VBS      = captain->parse_byte();
-
-  smarc_msgs::ControllerStatus msg_waypoint;
-  msg_waypoint.control_status = scientistinterface_enable_waypoint;
-  msg_waypoint.service_name = "/lolo/ctrl/toggle_onboard_waypoint_ctrl";
-  ctrl_status_waypoint_pub.publish(msg_waypoint);
-
-  smarc_msgs::ControllerStatus msg_yaw;
-  msg_yaw.control_status = scientistinterface_enable_yaw;
-  msg_yaw.service_name = "/lolo/ctrl/toggle_onboard_yaw_ctrl";
-  ctrl_status_yaw_pub.publish(msg_waypoint);
-
-  smarc_msgs::ControllerStatus msg_yawrate;
-  msg_yawrate.control_status = scientistinterface_enable_yawrate;
-  msg_yawrate.service_name = "/lolo/ctrl/toggle_onboard_yawrate_ctrl";
-  ctrl_status_yawrate_pub.publish(msg_yawrate);
-
-  smarc_msgs::ControllerStatus msg_depth;
-  msg_depth.control_status = scientistinterface_enable_depth;
-  msg_depth.service_name = "/lolo/ctrl/toggle_onboard_depth_ctrl";
-  ctrl_status_depth_pub.publish(msg_depth);
-
-  smarc_msgs::ControllerStatus msg_altitude;
-  msg_altitude.control_status = scientistinterface_enable_altitude;
-  msg_altitude.service_name = "/lolo/ctrl/toggle_onboard_altitude_ctrl";
-  ctrl_status_altitude_pub.publish(msg_altitude);
-
-  smarc_msgs::ControllerStatus msg_pitch;
-  msg_pitch.control_status = scientistinterface_enable_pitch;
-  msg_pitch.service_name = "/lolo/ctrl/toggle_onboard_pitch_ctrl";
-  ctrl_status_pitch_pub.publish(msg_pitch);
-
-  smarc_msgs::ControllerStatus msg_speed;
-  msg_speed.control_status = scientistinterface_enable_speed;
-  msg_speed.service_name = "/lolo/ctrl/toggle_onboard_speed_ctrl";
-  ctrl_status_speed_pub.publish(msg_speed);
+//CS_IMU, CS_POSITION and CS_STATUS layouts are unconfirmed, see MessageCodec
+void RosInterFace::captain_callback_IMU(RxFrame& frame) {
+  ImuMessage m;
+  if(!decode_imu(frame.data, frame.len, m)) return;
+
+  //Euler angles [rad] and body rates [rad/s]
+  AttitudeState& attitude = vehicle_state.edit().attitude;
+  attitude.timestamp    = m.timestamp;
+  attitude.roll         = m.roll;
+  attitude.pitch        = m.pitch;
+  attitude.yaw          = m.yaw;
+  attitude.roll_rate    = m.roll_rate;
+  attitude.pitch_rate   = m.pitch_rate;
+  attitude.yaw_rate     = m.yaw_rate;
+  vehicle_state.commit();
+
+  if(!publish_dr) return;
+
+  std_msgs::Float64 angle;
+  if(topic_admit(TOPIC_DR_ROLL, &attitude.roll))   publish_topic(TOPIC_DR_ROLL, angle, set_value);
+  if(topic_admit(TOPIC_DR_PITCH, &attitude.pitch)) publish_topic(TOPIC_DR_PITCH, angle, set_value);
+  if(topic_admit(TOPIC_DR_YAW, &attitude.yaw))     publish_topic(TOPIC_DR_YAW, angle, set_value);
+}
+
+void RosInterFace::captain_callback_POSITION(RxFrame& frame) {
+  PositionMessage m;
+  if(!decode_position(frame.data, frame.len, m)) return;
+
+  uint64_t timestamp    = m.timestamp;
+  double lat            = m.latitude * (180 / PI);
+  double lon            = m.longitude * (180 / PI);
+  float depth           = m.depth;
+  float altitude        = m.altitude;
+
+  VehicleState& state = vehicle_state.edit();
+  state.position.timestamp = timestamp;
+  state.position.latitude = lat;
+  state.position.longitude = lon;
+  state.position.depth = depth;
+  state.position.altitude = altitude;
+  vehicle_state.commit();
+
+  if(!publish_dr) return;
+
+  if(topic_admit(TOPIC_DR_LATLON)) {
+    geographic_msgs::GeoPoint latlon;
+    latlon.latitude = lat;
+    latlon.longitude = lon;
+    latlon.altitude = -depth;
+    publish(dr_latlon_pub, latlon);
+  }
+
+  if(topic_admit(TOPIC_DR_DEPTH, &depth)) {
+    std_msgs::Float64 depth_msg;
+    publish_topic(TOPIC_DR_DEPTH, depth_msg, set_value);
+  }
+
+  bool odom = topic_admit(TOPIC_DR_ODOM);
+  if(!odom && !publish_tf) return;
+
+  //Pose in UTM using the latest attitude
+  const AttitudeState& attitude = state.attitude;
+  double easting, northing;
+  utm.toUTM(lat, lon, easting, northing);
+
+  double cr = cos(0.5*attitude.roll),  sr = sin(0.5*attitude.roll);
+  double cp = cos(0.5*attitude.pitch), sp = sin(0.5*attitude.pitch);
+  double cy = cos(0.5*attitude.yaw),   sy = sin(0.5*attitude.yaw);
+
+  geometry_msgs::Pose& pose = dr_odom.pose.pose;
+  pose.position.x = easting;
+  pose.position.y = northing;
+  pose.position.z = -depth;
+  pose.orientation.w = cr*cp*cy + sr*sp*sy;
+  pose.orientation.x = sr*cp*cy - cr*sp*sy;
+  pose.orientation.y = cr*sp*cy + sr*cp*sy;
+  pose.orientation.z = cr*cp*sy - sr*sp*cy;
+
+  if(publish_tf) broadcast_base_link(pose);
+  if(!odom) return;
+
+  dr_odom.header.stamp = stamp(timestamp, frame);
+  dr_odom.header.seq = m.sequence;
+  dr_odom.twist.twist.angular.x = attitude.roll_rate;
+  dr_odom.twist.twist.angular.y = attitude.pitch_rate;
+  dr_odom.twist.twist.angular.z = attitude.yaw_rate;
+  publish(dr_odom_pub, dr_odom);
+}
+
+void RosInterFace::broadcast_base_link(const geometry_msgs::Pose& utm_pose) {
+  AllocScope scope(ALLOC_SCOPE_PUBLISH);
+  geometry_msgs::TransformStamped utm_to_ned;
+  try {
+    utm_to_ned = tf_buffer->lookupTransform("world_ned", "utm", ros::Time(0));
+  } catch(tf2::TransformException& e) {
+    CLOG(LOG_LEVEL_WARN, 1, "No utm -> world_ned transform, %s not broadcast: %s", base_link_tf.child_frame_id.c_str(), e.what());
+    return;
+  }
+
+  geometry_msgs::Pose pose;
+  tf2::doTransform(utm_pose, pose, utm_to_ned);
+  base_link_tf.header.stamp = ros::Time::now();
+  base_link_tf.transform.translation.x = pose.position.x;
+  base_link_tf.transform.translation.y = pose.position.y;
+  base_link_tf.transform.translation.z = pose.position.z;
+  base_link_tf.transform.rotation = pose.orientation;
+  tf_broadcaster->sendTransform(base_link_tf);
+}
+
+void RosInterFace::captain_callback_STATUS(RxFrame& frame) {
+  if(!publish_status) return;
+  StatusMessage m;
+  if(!decode_status(frame.data, frame.len, m)) return;
+
+  CaptainState status;
+  status.timestamp            = m.timestamp;
+  status.active_control_input = m.active_control_input;
+  status.target_latitude      = m.target_latitude * (180 / PI);
+  status.target_longitude     = m.target_longitude * (180 / PI);
+  status.target_yaw           = m.target_yaw;
+  status.target_pitch         = m.target_pitch;
+  status.target_speed         = m.target_speed;
+  status.target_rpm           = m.target_rpm;
+  status.target_depth         = m.target_depth;
+  status.target_altitude      = m.target_altitude;
+
+  CaptainState& cached = vehicle_state.edit().captain;
+  bool changed = cached.timestamp == 0
+    || status.active_control_input != cached.active_control_input
+    || status.target_latitude  != cached.target_latitude
+    || status.target_longitude != cached.target_longitude
+    || status.target_yaw       != cached.target_yaw
+    || status.target_pitch     != cached.target_pitch
+    || status.target_speed     != cached.target_speed
+    || status.target_rpm       != cached.target_rpm
+    || status.target_depth     != cached.target_depth
+    || status.target_altitude  != cached.target_altitude;
+  cached = status;
+  vehicle_state.commit();
+
+  //Latched, only published when something changes
+  if(!changed) return;
+
+  lolo_msgs::CaptainStatus msg;
+  msg.header.stamp = stamp(m.timestamp, frame);
+  msg.header.seq = m.sequence;
+  msg.active_control_input  = status.active_control_input;
+  msg.targetWaypoint_lat    = status.target_latitude;
+  msg.targetWaypoint_lon    = status.target_longitude;
+  msg.targetYaw             = status.target_yaw;
+  msg.targetPitch           = status.target_pitch;
+  msg.targetSpeed           = status.target_speed;
+  msg.targetRPM             = status.target_rpm;
+  msg.targetDepth           = status.target_depth;
+  msg.targetAltitude        = status.target_altitude;
+  publish(control_status_pub, msg);
+}
+
+void RosInterFace::publish_controller_status(ros::Publisher& pub, int controller, bool enabled) {
+  smarc_msgs::ControllerStatus& msg = ctrl_status_msgs[controller];
+  msg.control_status = enabled;
+  publish(pub, msg);
+}
+
+void RosInterFace::captain_callback_CTRL_STATUS(RxFrame& frame) {
+  CtrlStatusMessage m;
+  if(!decode_ctrl_status(frame.data, frame.len, m)) return;
+
+  bool enabled[VEHICLESTATE_N_CONTROLLERS];
+  for(int i=0;i<VEHICLESTATE_N_CONTROLLERS;i++) enabled[i] = m.enabled[i] != 0;
+
+  //Controllers whose status changed since the last frame
+  VehicleState& state = vehicle_state.edit();
+  bool changed[VEHICLESTATE_N_CONTROLLERS];
+  for(int i=0;i<VEHICLESTATE_N_CONTROLLERS;i++) {
+    changed[i] = state.controller_updates == 0 || enabled[i] != state.controller_enabled[i];
+    state.controller_enabled[i] = enabled[i];
+  }
+  state.controller_updates++;
+  vehicle_state.commit();
+
+  //Latched, only published when the status changes
+  if(changed[CONTROLLER_WAYPOINT]) publish_controller_status(ctrl_status_waypoint_pub, CONTROLLER_WAYPOINT, enabled[CONTROLLER_WAYPOINT]);
+  if(changed[CONTROLLER_YAW])      publish_controller_status(ctrl_status_yaw_pub,      CONTROLLER_YAW,      enabled[CONTROLLER_YAW]);
+  if(changed[CONTROLLER_YAWRATE])  publish_controller_status(ctrl_status_yawrate_pub,  CONTROLLER_YAWRATE,  enabled[CONTROLLER_YAWRATE]);
+  if(changed[CONTROLLER_DEPTH])    publish_controller_status(ctrl_status_depth_pub,    CONTROLLER_DEPTH,    enabled[CONTROLLER_DEPTH]);
+  if(changed[CONTROLLER_ALTITUDE]) publish_controller_status(ctrl_status_altitude_pub, CONTROLLER_ALTITUDE, enabled[CONTROLLER_ALTITUDE]);
+  if(changed[CONTROLLER_PITCH])    publish_controller_status(ctrl_status_pitch_pub,    CONTROLLER_PITCH,    enabled[CONTROLLER_PITCH]);
+  if(changed[CONTROLLER_SPEED])    publish_controller_status(ctrl_status_speed_pub,    CONTROLLER_SPEED,    enabled[CONTROLLER_SPEED]);
 };
 
-void RosInterFace::captain_callback_SERVICE() {
-  std::cout << "Received service response from captain" << std::endl;
+void RosInterFace::captain_callback_SERVICE(RxFrame& frame) {
+  ServiceMessage m;
+  if(!decode_service(frame.data, frame.len, m)) return;
+
   lolo_msgs::CaptainService msg;
-  msg.ref = captain->parse_int();
-  msg.reply = captain->parse_byte();
+  msg.ref = m.ref;
+  msg.reply = m.reply;
+  if(path_uploader != NULL && path_uploader->handle_ack(msg.ref, msg.reply)) return;
+  if(stream_controller != NULL && stream_controller->handle_ack(msg.ref, msg.reply)) return;
+  CLOG_INFO("Received service response from captain");
   //TODO Add data to array if it ever gets used
-  service_pub.publish(msg);
+  publish(service_pub, msg);
 }
 
-void RosInterFace::captain_callback_TEXT() {
-  int length = captain->parse_byte();
-  std::string text = captain->parse_string(length);
+void RosInterFace::captain_callback_TEXT(RxFrame& frame) {
+  if(!topic_admit(TOPIC_TEXT)) return;
+
+  std::string text;
+  if(!decode_text(frame.data, frame.len, text)) return;
   std_msgs::String msg;
   msg.data = text.c_str();
-  text_pub.publish(msg);
+  publish(text_pub, msg);
 }
 
-void RosInterFace::captain_callback_MENUSTREAM() {
-  int length = captain->parse_byte();
-  std::string text = captain->parse_string(length);
-  printf("%s\n",text.c_str());
+void RosInterFace::captain_callback_MENUSTREAM(RxFrame& frame) {
+  std::string text;
+  if(!decode_text(frame.data, frame.len, text)) return;
+  CLOG(LOG_LEVEL_INFO, 200, "%s", text.c_str());   //menu pages come in bursts
+  if(menu_pub.getNumSubscribers() == 0) return;
   std_msgs::String msg;
   msg.data = text.c_str();
-  menu_pub.publish(msg);
+  publish(menu_pub, msg);
 }
 
-void RosInterFace::captain_callback_MISSIONLOG() {
-  int length = captain->parse_byte();
-  std::string text = captain->parse_string(length);
+void RosInterFace::captain_callback_MISSIONLOG(RxFrame& frame) {
+  if(!topic_admit(TOPIC_MISSIONLOG)) return;
+
+  std::string text;
+  if(!decode_text(frame.data, frame.len, text)) return;
   //printf("%s\n",text.c_str());
   std_msgs::String msg;
   msg.data = text.c_str();
-  missonlog_pub.publish(msg);
+  publish(missonlog_pub, msg);
 }
 
-void RosInterFace::captain_callback_DATALOG() {
-  int length = captain->parse_byte();
-  std::string text = captain->parse_string(length);
+void RosInterFace::captain_callback_DATALOG(RxFrame& frame) {
+  if(!topic_admit(TOPIC_DATALOG)) return;
+
+  std::string text;
+  if(!decode_text(frame.data, frame.len, text)) return;
   //printf("%s\n",text.c_str());
   std_msgs::String msg;
   msg.data = text.c_str();
-  datalog_pub.publish(msg);
+  publish(datalog_pub, msg);
 }
 
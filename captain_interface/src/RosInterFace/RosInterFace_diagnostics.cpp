@@ -0,0 +1,222 @@
+#include "captain_interface/RosInterFace/RosInterFace.h"
+#include <stdio.h>
+#include <string.h>
+
+static void add_value(diagnostic_msgs::DiagnosticStatus& status, const char* key, double value) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%g", value);
+  diagnostic_msgs::KeyValue kv;
+  kv.key = key;
+  kv.value = buf;
+  status.values.push_back(kv);
+}
+
+void RosInterFace::publish_diagnostics(const ros::TimerEvent& event) {
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+
+  //Link counters
+  diagnostic_msgs::DiagnosticStatus link;
+  link.name = "captain_interface: link";
+  link.level = diagnostic_msgs::DiagnosticStatus::OK;
+  uint32_t received = 0;
+  for(int i=0;i<256;i++) received += captain->counters.received[i];
+  add_value(link, "received", received);
+  add_value(link, "checksum_errors", captain->counters.checksum_errors);
+  add_value(link, "sent", captain->counters.sent);
+  link.values.push_back(diagnostic_msgs::KeyValue());
+  link.values.back().key = "integrity";
+  link.values.back().value = captain->crcMode() ? "crc32c" : "xor";
+  if(relay.isActive()) {
+    add_value(link, "relay_dropped", relay.dropped);
+    add_value(link, "relay_uplinked", relay.uplinked);
+    add_value(link, "relay_rejected", relay.rejected);
+  }
+  if(telemetry_store.isOpen()) add_value(link, "store_dropped", telemetry_store.dropped);
+  if(redundant_link != NULL) add_value(link, "stale_frames", redundant_link->staleFrames());
+  msg.status.push_back(link);
+
+  //Captain clock. Offset is host - captain, the delay includes clock_min_delay
+  ClockOffsetStatus clock_status = captain_clock.status();
+  diagnostic_msgs::DiagnosticStatus clock;
+  clock.name = "captain_interface: clock";
+  clock.level = clock_status.valid ? diagnostic_msgs::DiagnosticStatus::OK : diagnostic_msgs::DiagnosticStatus::WARN;
+  if(!clock_status.valid) clock.message = "no offset estimate yet";
+  char offset[32];
+  snprintf(offset, sizeof(offset), "%.6f", clock_status.offset_s);   //%g would round large offsets
+  clock.values.push_back(diagnostic_msgs::KeyValue());
+  clock.values.back().key = "offset_s";
+  clock.values.back().value = offset;
+  add_value(clock, "skew_ppm", clock_status.skew_ppm);
+  add_value(clock, "delay_avg_ms", clock_status.delay_avg_ms);
+  add_value(clock, "delay_min_ms", clock_status.delay_min_ms);
+  add_value(clock, "delay_max_ms", clock_status.delay_max_ms);
+  add_value(clock, "samples", clock_status.samples);
+  add_value(clock, "resets", clock_status.resets);
+  msg.status.push_back(clock);
+
+  //Redundant paths. Win rate is the share of frames a path delivered first
+  if(redundant_link != NULL) {
+    for(int p=0;p<redundant_link->pathCount();p++) {
+      RedundantPathStats stats = redundant_link->stats(p);
+      diagnostic_msgs::DiagnosticStatus path;
+      path.name = "captain_interface: path " + std::to_string(p);
+      path.message = redundant_link->pathName(p);
+      path.level = stats.received == 0 ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+      uint32_t compared = stats.wins + stats.duplicates;
+      add_value(path, "received", stats.received);
+      add_value(path, "wins", stats.wins);
+      add_value(path, "duplicates", stats.duplicates);
+      add_value(path, "win_rate", compared > 0 ? (double) stats.wins / compared : 0);
+      add_value(path, "checksum_errors", stats.checksum_errors);
+      add_value(path, "lag_avg_ms", stats.lag_avg_ms);
+      add_value(path, "lag_max_ms", stats.lag_max_ms);
+      msg.status.push_back(path);
+    }
+  }
+
+  //Transmit queues
+  if(tx_scheduler != NULL) {
+    const char* names[TX_N_CLASSES] = {"captain_interface: tx safety", "captain_interface: tx control", "captain_interface: tx bulk"};
+    for(int c=0;c<TX_N_CLASSES;c++) {
+      TxClassStats stats = tx_scheduler->stats((TxClass) c);
+      diagnostic_msgs::DiagnosticStatus tx;
+      tx.name = names[c];
+      tx.level = stats.dropped > 0 && c != TX_CONTROL ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+      add_value(tx, "depth", stats.depth);
+      add_value(tx, "max_depth", stats.max_depth);
+      add_value(tx, "enqueued", stats.enqueued);
+      add_value(tx, "sent", stats.sent);
+      add_value(tx, "dropped", stats.dropped);
+      add_value(tx, "latency_avg_us", stats.latency_avg_us);
+      add_value(tx, "latency_max_us", stats.latency_max_us);
+      msg.status.push_back(tx);
+    }
+  }
+
+  //Black box
+  if(blackbox.isActive()) {
+    BlackBoxStats stats = blackbox.stats();
+    diagnostic_msgs::DiagnosticStatus bb;
+    bb.name = "captain_interface: blackbox";
+    bb.level = stats.dumps > 0 ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+    if(stats.dumps > 0) bb.message = "dumped to " + stats.last_dump;
+    add_value(bb, "recorded", stats.recorded);
+    add_value(bb, "dumps", stats.dumps);
+    add_value(bb, "suppressed_triggers", stats.suppressed);
+    msg.status.push_back(bb);
+  }
+
+  //Demand driven streams
+  if(stream_controller != NULL) {
+    StreamControlStatus streams = stream_controller->status();
+    diagnostic_msgs::DiagnosticStatus sc;
+    sc.name = "captain_interface: streams";
+    sc.level = streams.rejected > 0 ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+    if(streams.rejected > 0) sc.message = "captain refused stream requests";
+    add_value(sc, "managed", streams.managed);
+    add_value(sc, "enabled", streams.enabled);
+    add_value(sc, "confirmed", streams.confirmed);
+    add_value(sc, "pending", streams.pending);
+    add_value(sc, "rejected", streams.rejected);
+    add_value(sc, "requests", streams.requests);
+    add_value(sc, "retransmits", streams.retransmits);
+    add_value(sc, "resyncs", streams.resyncs);
+    msg.status.push_back(sc);
+  }
+
+  //Topic policies, frames decoded and messages published per topic that is not passed through
+  diagnostic_msgs::DiagnosticStatus tp;
+  tp.name = "captain_interface: topic policies";
+  tp.level = diagnostic_msgs::DiagnosticStatus::OK;
+  for(int t=0;t<TOPIC_N;t++) {
+    if(topic_policies[t].policy() == POLICY_PASS) continue;
+    std::string name = topic_name(t);
+    tp.values.push_back(diagnostic_msgs::KeyValue());
+    tp.values.back().key = name;
+    tp.values.back().value = topic_policies[t].describe();
+    add_value(tp, (name + " received").c_str(), topic_policies[t].receivedCount());
+    add_value(tp, (name + " published").c_str(), topic_policies[t].publishedCount());
+  }
+  if(!tp.values.empty()) msg.status.push_back(tp);
+
+  //Log. Suppressed messages are listed per call site
+  LogStats log = log_stats();
+  diagnostic_msgs::DiagnosticStatus logging;
+  logging.name = "captain_interface: log";
+  logging.level = log.dropped > 0 ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+  add_value(logging, "written", log.written);
+  add_value(logging, "dropped", log.dropped);
+  add_value(logging, "suppressed", log.suppressed);
+  log_for_each_site([&logging](const LogSite& site) {
+    const char* file = strrchr(site.file, '/');
+    std::string key = std::string("suppressed ") + (file != NULL ? file + 1 : site.file) + ":" + std::to_string(site.line);
+    add_value(logging, key.c_str(), site.suppressed_total.load());
+  });
+  msg.status.push_back(logging);
+
+  //Receive lanes
+  if(rx_dispatcher != NULL && rx_dispatcher->running()) {
+    for(int l=0;l<RX_N_LANES;l++) {
+      RxLaneStats stats = rx_dispatcher->stats((RxLane) l);
+      diagnostic_msgs::DiagnosticStatus rx;
+      rx.name = std::string("captain_interface: rx ") + RxDispatcher::laneName((RxLane) l);
+      rx.level = stats.dropped > 0 ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+      add_value(rx, "depth", stats.depth);
+      add_value(rx, "max_depth", stats.max_depth);
+      add_value(rx, "dispatched", stats.dispatched);
+      add_value(rx, "handled", stats.handled);
+      add_value(rx, "dropped", stats.dropped);
+      add_value(rx, "latency_avg_us", stats.latency_avg_us);
+      add_value(rx, "latency_max_us", stats.latency_max_us);
+      add_value(rx, "handler_max_us", stats.handler_max_us);
+      msg.status.push_back(rx);
+    }
+  }
+
+  //Waypoint path upload
+  if(path_uploader != NULL) {
+    PathUploadStatus path = path_uploader->status();
+    diagnostic_msgs::DiagnosticStatus upload;
+    upload.name = "captain_interface: path upload";
+    upload.level = path.failed > 0 ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+    add_value(upload, "points", path.points);
+    add_value(upload, "confirmed", path.confirmed);
+    add_value(upload, "pending_frames", path.pending);
+    add_value(upload, "failed_frames", path.failed);
+    add_value(upload, "frames_sent", path.frames_sent);
+    add_value(upload, "retransmits", path.retransmits);
+    msg.status.push_back(upload);
+  }
+
+  //Callback queues
+  CallbackSpinner* spinners[3] = {&safety_spinner, &control_spinner, &bulk_spinner};
+  for(int i=0;i<3;i++) {
+    CallbackQueueStats stats = spinners[i]->stats();
+    diagnostic_msgs::DiagnosticStatus queue;
+    queue.name = "captain_interface: callbacks " + spinners[i]->getName();
+    queue.level = diagnostic_msgs::DiagnosticStatus::OK;
+    add_value(queue, "callbacks", stats.callbacks);
+    add_value(queue, "delay_avg_ms", stats.delay_avg_ms);
+    add_value(queue, "delay_max_ms", stats.delay_max_ms);
+    add_value(queue, "callback_max_ms", stats.callback_max_ms);
+    msg.status.push_back(queue);
+  }
+
+  //Heap allocations while decoding, per message ID. Only IDs that allocated are listed
+  if(alloc_tracking_enabled()) {
+    diagnostic_msgs::DiagnosticStatus alloc;
+    alloc.name = "captain_interface: allocations";
+    alloc.level = diagnostic_msgs::DiagnosticStatus::OK;
+    for(int i=0;i<256;i++) {
+      uint32_t count = alloc_counters.decode[i];
+      if(count == 0) continue;
+      std::string key = "decode_" + std::to_string(i);
+      add_value(alloc, key.c_str(), count);
+    }
+    add_value(alloc, "publish", alloc_counters.publish);
+    msg.status.push_back(alloc);
+  }
+
+  diagnostics_pub.publish(msg);
+}
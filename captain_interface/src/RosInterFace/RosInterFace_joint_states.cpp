@@ -0,0 +1,68 @@
+#include "captain_interface/RosInterFace/RosInterFace.h"
+#include <math.h>
+
+//Thruster joints only turn for visualization, scaled down like the old converter
+#define THRUSTER_VISUAL_SCALE 0.1
+
+void RosInterFace::init_joint_states() {
+  ros::param::param<double>("~joint_state_rate", joint_state_rate, 10.0);
+
+  const char* names[JOINT_N] = {
+    "lolo/elevon_port_joint",
+    "lolo/elevon_stbd_joint",
+    "lolo/rudder_port_joint",
+    "lolo/rudder_stbd_joint",
+    "lolo/elevator_joint",
+    "lolo/thruster_port_joint",
+    "lolo/thruster_stbd_joint"};
+
+  //Allocated once, only the values change
+  joint_state.name.assign(names, names + JOINT_N);
+  joint_state.position.assign(JOINT_N, 0.0);
+  joint_state.velocity.assign(JOINT_N, 0.0);
+  joint_state_updated = 0;
+  joint_state_last = ros::Time::now();
+
+  joint_state_pub = n->advertise<sensor_msgs::JointState>("/lolo/command_states", 10);
+
+  //Fixed rate, or as soon as every surface and thruster has reported once
+  if(joint_state_rate > 0) {
+    joint_state_timer = n->createTimer(ros::Duration(1.0 / joint_state_rate), &RosInterFace::joint_state_timer_callback, this);
+  }
+}
+
+void RosInterFace::joint_state_timer_callback(const ros::TimerEvent& event) {
+  publish_joint_state(vehicle_state.snapshot());
+}
+
+void RosInterFace::joint_state_feedback(uint8_t source) {
+  if(joint_state_rate > 0) return;
+  joint_state_updated |= source;
+  if(joint_state_updated != JOINT_SOURCE_ALL) return;
+  joint_state_updated = 0;
+  publish_joint_state(vehicle_state.edit());
+}
+
+void RosInterFace::publish_joint_state(const VehicleState& state) {
+  if(joint_state_pub.getNumSubscribers() == 0) return;
+
+  ros::Time now = ros::Time::now();
+  double dt = (now - joint_state_last).toSec();
+  joint_state_last = now;
+
+  //Sign conventions of the urdf
+  joint_state.position[JOINT_ELEVON_PORT] = -state.elevon_port.angle;
+  joint_state.position[JOINT_ELEVON_STRB] = -state.elevon_strb.angle;
+  joint_state.position[JOINT_RUDDER_PORT] = state.rudder.angle;
+  joint_state.position[JOINT_RUDDER_STRB] = state.rudder.angle;
+  joint_state.position[JOINT_ELEVATOR]    = -state.elevator.angle;
+
+  joint_state.velocity[JOINT_THRUSTER_PORT] = -THRUSTER_VISUAL_SCALE * 2.0*PI/60.0 * state.thruster_port.rpm;
+  joint_state.velocity[JOINT_THRUSTER_STRB] =  THRUSTER_VISUAL_SCALE * 2.0*PI/60.0 * state.thruster_strb.rpm;
+  for(int j=JOINT_THRUSTER_PORT;j<=JOINT_THRUSTER_STRB;j++) {
+    joint_state.position[j] = fmod(joint_state.position[j] + dt * joint_state.velocity[j], 2.0*PI);
+  }
+
+  joint_state.header.stamp = now;
+  publish(joint_state_pub, joint_state);
+}
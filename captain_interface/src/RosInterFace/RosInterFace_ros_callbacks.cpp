@@ -17,15 +17,46 @@ void RosInterFace::ros_callback_done(const std_msgs::Empty::ConstPtr &_msg) {
 };
 */
 
-void RosInterFace::ros_callback_waypoint(const geographic_msgs::GeoPoint::ConstPtr &_msg) {
-  double lat = _msg->latitude;
-  double lon = _msg->longitude;
+void RosInterFace::send_waypoint(double lat, double lon) {
   captain->new_package(SC_SET_TARGET_WAYPOINT); // set target waypoint
   captain->add_double((PI / 180) * lat);
   captain->add_double((PI / 180) * lon);
   captain->send_package();
 };
 
+void RosInterFace::ros_callback_waypoint(const geographic_msgs::GeoPoint::ConstPtr &_msg) {
+  send_waypoint(_msg->latitude, _msg->longitude);
+};
+
+void RosInterFace::ros_callback_waypoint_utm(const geometry_msgs::Point::ConstPtr &_msg) {
+  //x = easting, y = northing in the configured UTM zone
+  double lat, lon;
+  utm.toLatLon(_msg->x, _msg->y, lat, lon);
+  send_waypoint(lat, lon);
+};
+
+void RosInterFace::ros_callback_path(const geographic_msgs::GeoPath::ConstPtr &_msg) {
+  std::vector<PathPoint> points(_msg->poses.size());
+  for(size_t i=0;i<points.size();i++) {
+    points[i].latitude  = _msg->poses[i].pose.position.latitude;
+    points[i].longitude = _msg->poses[i].pose.position.longitude;
+  }
+  if(!path_uploader->upload(points)) ROS_WARN("Waypoint path too long: %d points, max %d", (int) points.size(), PATH_MAX_POINTS);
+};
+
+void RosInterFace::path_upload_timer_callback(const ros::TimerEvent& event) {
+  path_uploader->poll();
+  PathUploadStatus status = path_uploader->status();
+  if(status.confirmed != path_upload_last.confirmed || status.points != path_upload_last.points) {
+    std_msgs::Int32 msg;
+    msg.data = status.confirmed;
+    path_confirmed_pub.publish(msg);
+    if(status.pending == 0 && status.confirmed == status.points) ROS_INFO("Waypoint path confirmed by captain: %d points", (int) status.points);
+  }
+  if(status.failed != path_upload_last.failed) ROS_WARN("Waypoint path upload failed, %d of %d points confirmed", (int) status.confirmed, (int) status.points);
+  path_upload_last = status;
+};
+
 void RosInterFace::ros_callback_speed(const std_msgs::Float64::ConstPtr &_msg) {
   float targetSpeed = _msg->data;
   captain->new_package(SC_SET_TARGET_SPEED);
@@ -103,7 +134,7 @@ void RosInterFace::ros_callback_thrusterStrb(const smarc_msgs::ThrusterRPM::Cons
 };
 
 void RosInterFace::ros_callback_service(const lolo_msgs::CaptainService::ConstPtr &_msg) {
-  std::cout << "Send service request to captain" << std::endl;
+  CLOG_INFO("Send service request to captain");
   captain->new_package(SC_REQUEST_IN);
   captain->add_int(_msg->ref);
   captain->add_byte(_msg->id);
@@ -124,3 +155,53 @@ void RosInterFace::ros_callback_menu(const std_msgs::String::ConstPtr &_msg) {
   }
   captain->send_package();
 };
+
+bool RosInterFace::ros_service_vehicle_state(lolo_msgs::GetVehicleState::Request &req, lolo_msgs::GetVehicleState::Response &res) {
+  VehicleState state = vehicle_state.snapshot();
+  stream_hold_until = ros::Time::now() + ros::Duration(stream_hold);   //fresh state for the next requests
+
+  uint64_t timestamp = state.captain.timestamp;
+  res.status.header.stamp = ros::Time(timestamp / 1000000, (timestamp % 1000000)*1000);
+  res.status.active_control_input = state.captain.active_control_input;
+  res.status.targetWaypoint_lat   = state.captain.target_latitude;
+  res.status.targetWaypoint_lon   = state.captain.target_longitude;
+  res.status.targetYaw            = state.captain.target_yaw;
+  res.status.targetPitch          = state.captain.target_pitch;
+  res.status.targetSpeed          = state.captain.target_speed;
+  res.status.targetRPM            = state.captain.target_rpm;
+  res.status.targetDepth          = state.captain.target_depth;
+  res.status.targetAltitude       = state.captain.target_altitude;
+
+  res.latitude  = state.position.latitude;
+  res.longitude = state.position.longitude;
+  res.depth     = state.position.depth;
+  res.altitude  = state.position.altitude;
+  res.roll      = state.attitude.roll;
+  res.pitch     = state.attitude.pitch;
+  res.yaw       = state.attitude.yaw;
+
+  res.rudder_angle      = state.rudder.angle;
+  res.elevator_angle    = state.elevator.angle;
+  res.elevon_port_angle = state.elevon_port.angle;
+  res.elevon_strb_angle = state.elevon_strb.angle;
+
+  res.thruster_port_rpm     = state.thruster_port.rpm;
+  res.thruster_strb_rpm     = state.thruster_strb.rpm;
+  res.thruster_port_current = state.thruster_port.current;
+  res.thruster_strb_current = state.thruster_strb.current;
+
+  res.controller_enabled.assign(state.controller_enabled, state.controller_enabled + VEHICLESTATE_N_CONTROLLERS);
+  return true;
+};
+
+bool RosInterFace::ros_service_blackbox(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res) {
+  if(!blackbox.isActive()) {
+    res.success = false;
+    res.message = "black box disabled, see ~blackbox_frames";
+    return true;
+  }
+  std::string path = blackbox.dump("request");
+  res.success = !path.empty();
+  res.message = res.success ? path : "could not write to the black box directory";
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "captain_interface/RosInterFace/RosInterFace.h"
+#include <stdlib.h>
+#include <map>
+
+#define STREAM_CONTROL_PERIOD 0.5   // s between demand checks
+
+//Streams that are only decoded for topics. The others update the vehicle
+//state or the controller status and keep their captain defaults
+static const uint8_t managed_streams[] = {
+  CS_RUDDER, CS_ELEVATOR, CS_ELEVON_PORT, CS_ELEVON_STRB, CS_THRUSTER_PORT, CS_THRUSTER_STRB,
+  CS_IMU, CS_POSITION, CS_TEXT, CS_MISSIONLOG, CS_DATALOG};
+
+void RosInterFace::init_stream_control() {
+  bool stream_control;
+  double stream_timeout;
+  int stream_retries;
+  std::map<std::string, double> stream_rates;   // {"18": 20.0}, message ID -> Hz
+  ros::param::param<bool>("~stream_control", stream_control, false);
+  ros::param::param<double>("~stream_silence", stream_silence, 3.0);
+  ros::param::param<double>("~stream_hold", stream_hold, 30.0);
+  ros::param::param<double>("~stream_timeout", stream_timeout, 0.5);
+  ros::param::param<int>("~stream_retries", stream_retries, 3);
+  ros::param::get("~stream_rates", stream_rates);
+  if(!stream_control) return;
+
+  stream_controller = new StreamController([this](uint8_t id, const char* data, uint8_t len) { return captain->send_payload(id, data, len); });
+  stream_controller->setRetry(stream_timeout, stream_retries);
+  for(size_t i=0;i<sizeof(managed_streams);i++) {
+    std::map<std::string, double>::iterator rate = stream_rates.find(std::to_string(managed_streams[i]));
+    stream_controller->manage(managed_streams[i], rate != stream_rates.end() ? rate->second : 0);
+  }
+  for(std::map<std::string, double>::iterator it=stream_rates.begin();it!=stream_rates.end();it++) {
+    if(!stream_controller->isManaged(atoi(it->first.c_str()))) ROS_WARN("stream_rates: %s is not a managed stream", it->first.c_str());
+  }
+
+  stream_clock_resets = captain_clock.resets();
+  stream_link_silent = stream_silence;    //the first frames also resend the requests
+  stream_control_timer = n->createTimer(ros::Duration(STREAM_CONTROL_PERIOD), &RosInterFace::stream_control_timer_callback, this);
+  ROS_INFO("Captain streams enabled on demand");
+}
+
+bool RosInterFace::stream_demand(uint8_t stream) {
+  //Recorders and relays take every stream
+  if(telemetry_store.isOpen() || shm_telemetry.isOpen() || relay.isActive()) return true;
+  if(ros::Time::now() < stream_hold_until) return true;
+
+  bool joints = joint_state_pub.getNumSubscribers() > 0;
+  switch(stream) {
+    case CS_RUDDER:        return joints || topic_subscribed(TOPIC_RUDDER);
+    case CS_ELEVATOR:      return joints || topic_subscribed(TOPIC_ELEVATOR);
+    case CS_ELEVON_PORT:   return joints || topic_subscribed(TOPIC_ELEVON_PORT);
+    case CS_ELEVON_STRB:   return joints || topic_subscribed(TOPIC_ELEVON_STRB);
+    case CS_THRUSTER_PORT: return joints || topic_subscribed(TOPIC_THRUSTER_PORT);
+    case CS_THRUSTER_STRB: return joints || topic_subscribed(TOPIC_THRUSTER_STRB);
+    //The odometry and the base link transform take the orientation from the IMU.
+    //Listeners of the transform cannot be counted, so publish_tf keeps both on
+    case CS_IMU:           return publish_dr && (publish_tf || topic_subscribed(TOPIC_DR_ROLL) || topic_subscribed(TOPIC_DR_PITCH) || topic_subscribed(TOPIC_DR_YAW) || topic_subscribed(TOPIC_DR_ODOM));
+    case CS_POSITION:      return publish_dr && (publish_tf || topic_subscribed(TOPIC_DR_LATLON) || topic_subscribed(TOPIC_DR_DEPTH) || topic_subscribed(TOPIC_DR_ODOM));
+    case CS_TEXT:          return topic_subscribed(TOPIC_TEXT);
+    case CS_MISSIONLOG:    return topic_subscribed(TOPIC_MISSIONLOG);
+    case CS_DATALOG:       return topic_subscribed(TOPIC_DATALOG);
+  }
+  return true;
+}
+
+void RosInterFace::stream_control_timer_callback(const ros::TimerEvent& event) {
+  //The captain forgets the requests when it restarts: send them again when
+  //frames arrive after a silent link, or when the captain clock stepped
+  uint32_t frames = 0;
+  for(int i=0;i<256;i++) frames += captain->counters.received[i];
+  bool resync = false;
+  if(frames == stream_link_frames) stream_link_silent += STREAM_CONTROL_PERIOD;
+  else {
+    resync = stream_link_silent >= stream_silence;
+    stream_link_silent = 0;
+  }
+  stream_link_frames = frames;
+
+  uint32_t resets = captain_clock.resets();
+  if(resets != stream_clock_resets) resync = true;
+  stream_clock_resets = resets;
+
+  for(size_t i=0;i<sizeof(managed_streams);i++) stream_controller->setDemand(managed_streams[i], stream_demand(managed_streams[i]));
+  if(resync) stream_controller->resync();
+  else stream_controller->poll();
+}
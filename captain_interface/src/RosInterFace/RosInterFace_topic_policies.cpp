@@ -0,0 +1,113 @@
+#include "captain_interface/RosInterFace/RosInterFace.h"
+#include <chrono>
+
+//Topics with a policy. fields: floats passed to the policy, aggregate: the mean of them is meaningful
+static const struct {
+  const char* name;
+  ros::Publisher RosInterFace::* pub;
+  int fields;
+  bool aggregate;
+} topic_table[RosInterFace::TOPIC_N] = {
+  {"/lolo/core/rudder_fb",       &RosInterFace::rudder_angle_pub,      1, true},   // angle
+  {"/lolo/core/elevator_fb",     &RosInterFace::elevator_angle_pub,    1, true},
+  {"/lolo/core/elevon_port_fb",  &RosInterFace::elevon_port_angle_pub, 1, true},
+  {"/lolo/core/elevon_strb_fb",  &RosInterFace::elevon_strb_angle_pub, 1, true},
+  {"/lolo/core/thruster1_fb",    &RosInterFace::thrusterPort_pub,      3, true},   // rpm, current, torque
+  {"/lolo/core/thruster2_fb",    &RosInterFace::thrusterStrb_pub,      3, true},
+  {"/lolo/dr/lat_lon",           &RosInterFace::dr_latlon_pub,         0, false},
+  {"/lolo/dr/depth",             &RosInterFace::dr_depth_pub,          1, true},
+  {"/lolo/dr/roll",              &RosInterFace::dr_roll_pub,           1, true},
+  {"/lolo/dr/pitch",             &RosInterFace::dr_pitch_pub,          1, true},
+  {"/lolo/dr/yaw",               &RosInterFace::dr_yaw_pub,            1, false},  // wraps at +-pi
+  {"/lolo/dr/odom",              &RosInterFace::dr_odom_pub,           0, false},
+  {"/lolo/text",                 &RosInterFace::text_pub,              0, false},
+  {"/lolo/log/mission",          &RosInterFace::missonlog_pub,         0, false},
+  {"/lolo/log/data",             &RosInterFace::datalog_pub,           0, false},
+};
+
+static uint64_t steady_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//Numeric entry of a policy, ints and doubles alike
+static bool get_number(XmlRpc::XmlRpcValue& entry, const char* key, double& value) {
+  if(!entry.hasMember(key)) return false;
+  XmlRpc::XmlRpcValue& v = entry[key];
+  if(v.getType() == XmlRpc::XmlRpcValue::TypeInt) value = (int) v;
+  else if(v.getType() == XmlRpc::XmlRpcValue::TypeDouble) value = (double) v;
+  else return false;
+  return true;
+}
+
+ros::Publisher& RosInterFace::topic_publisher(int topic) {
+  return this->*topic_table[topic].pub;
+}
+
+const char* RosInterFace::topic_name(int topic) {
+  return topic_table[topic].name;
+}
+
+bool RosInterFace::topic_subscribed(int topic) {
+  if(alloc_checking) return true;
+  return topic_publisher(topic).getNumSubscribers() > 0
+    || topic_min_pub[topic].getNumSubscribers() > 0
+    || topic_max_pub[topic].getNumSubscribers() > 0;
+}
+
+bool RosInterFace::topic_admit(int topic, const float* values) {
+  if(!topic_subscribed(topic)) return false;
+  return topic_policies[topic].admit(steady_ns(), values, values != NULL ? topic_table[topic].fields : 0);
+}
+
+template<class M> void RosInterFace::advertise_min_max(int topic) {
+  std::string name = topic_table[topic].name;
+  topic_min_pub[topic] = n->advertise<M>(name + "/min", 10);
+  topic_max_pub[topic] = n->advertise<M>(name + "/max", 10);
+}
+
+void RosInterFace::init_topic_policies() {
+  //e.g. [{topic: /lolo/core/thruster1_fb, policy: aggregate, window: 0.5}, {topic: /lolo/dr/roll, policy: decimate, n: 10}]
+  XmlRpc::XmlRpcValue policies;
+  if(!ros::param::get("~topic_policies", policies)) return;
+  if(policies.getType() != XmlRpc::XmlRpcValue::TypeArray) {
+    ROS_ERROR("topic_policies must be a list");
+    return;
+  }
+
+  for(int i=0;i<policies.size();i++) {
+    XmlRpc::XmlRpcValue& entry = policies[i];
+    if(entry.getType() != XmlRpc::XmlRpcValue::TypeStruct || !entry.hasMember("topic") || !entry.hasMember("policy")
+      || entry["topic"].getType() != XmlRpc::XmlRpcValue::TypeString || entry["policy"].getType() != XmlRpc::XmlRpcValue::TypeString) {
+      ROS_WARN("topic_policies[%d]: needs a topic and a policy", i);
+      continue;
+    }
+    std::string name = entry["topic"];
+    std::string policy_name = entry["policy"];
+
+    int topic = 0;
+    while(topic < TOPIC_N && name != topic_table[topic].name) topic++;
+    if(topic == TOPIC_N) { ROS_WARN("topic_policies: %s has no policy support", name.c_str()); continue; }
+
+    TopicPolicyMode mode;
+    if(!TopicPolicy::parseMode(policy_name, mode)) { ROS_WARN("topic_policies: unknown policy %s for %s", policy_name.c_str(), name.c_str()); continue; }
+    if(mode == POLICY_AGGREGATE && !topic_table[topic].aggregate) { ROS_WARN("topic_policies: %s can not be aggregated", name.c_str()); continue; }
+
+    //n for decimate, rate [Hz] for throttle, window [s] for aggregate
+    const char* key = mode == POLICY_DECIMATE ? "n" : mode == POLICY_THROTTLE ? "rate" : "window";
+    double value = 0;
+    if(mode != POLICY_PASS && !get_number(entry, key, value)) { ROS_WARN("topic_policies: %s %s needs %s", name.c_str(), policy_name.c_str(), key); continue; }
+    if(!topic_policies[topic].configure(mode, value)) { ROS_WARN("topic_policies: %s %s: invalid %s %g", name.c_str(), policy_name.c_str(), key, value); continue; }
+
+    if(mode == POLICY_AGGREGATE) {
+      switch(topic) {
+        case TOPIC_THRUSTER_PORT:
+        case TOPIC_THRUSTER_STRB: advertise_min_max<smarc_msgs::ThrusterFeedback>(topic); break;
+        case TOPIC_DR_DEPTH:
+        case TOPIC_DR_ROLL:
+        case TOPIC_DR_PITCH:      advertise_min_max<std_msgs::Float64>(topic); break;
+        default:                  advertise_min_max<smarc_msgs::FloatStamped>(topic);   //control surfaces
+      }
+    }
+    ROS_INFO("Topic policy %s: %s", name.c_str(), topic_policies[topic].describe().c_str());
+  }
+}
@@ -0,0 +1,226 @@
+#include <captain_interface/RxDispatcher/RxDispatcher.h>
+#include <captain_interface/scientistmsg.h>
+#include <captain_interface/Tracing/Tracing.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+//----------------------------------------------------------------
+//-----------------------------RxFrame----------------------------
+//----------------------------------------------------------------
+void RxFrame::set(uint8_t _msgID, const char* payload, uint8_t _len, uint64_t _rx_ns) {
+  msgID = _msgID;
+  len = _len;
+  pos = 0;
+  rx_ns = _rx_ns;
+  if(payload != data) memcpy(data, payload, len);
+  received = Clock::now();
+}
+
+uint8_t RxFrame::parse_byte() {
+  if(pos >= len) return 0;
+  return data[pos++];
+}
+
+std::string RxFrame::parse_string(int Nchars) {
+  std::string s;
+  s.reserve(Nchars);
+  for(int i=0;i<Nchars;i++) s += ((char) parse_byte());
+  return s;
+}
+
+float RxFrame::parse_float() {
+  uint8_t b[4];
+  for(int i=0;i<4;i++) b[i] = parse_byte();
+  float value;
+  memcpy(&value, b, 4);
+  return value;
+}
+
+double RxFrame::parse_double() {
+  uint8_t b[8];
+  for(int i=0;i<8;i++) b[i] = parse_byte();
+  double value;
+  memcpy(&value, b, 8);
+  return value;
+}
+
+uint32_t RxFrame::parse_long() {
+  uint8_t b[4];
+  for(int i=0;i<4;i++) b[i] = parse_byte();
+  uint32_t value;
+  memcpy(&value, b, 4);
+  return value;
+}
+
+uint64_t RxFrame::parse_llong() {
+  //Most significant half first, like CaptainInterFace::parse_llong
+  uint32_t msb = parse_long();
+  uint32_t lsb = parse_long();
+  return (((uint64_t) msb) << 32) + lsb;
+}
+
+int RxFrame::parse_int() {
+  //2 bytes, not sign extended, like CaptainInterFace::parse_int
+  uint8_t lsb = parse_byte();
+  uint8_t msb = parse_byte();
+  return lsb | (msb << 8);
+}
+
+//----------------------------------------------------------------
+void RxDispatcher::RxQueue::grow() {
+  std::vector<RxFrame> larger(frames.size() * 2);
+  for(size_t i=0;i<count;i++) larger[i] = at(i);
+  frames.swap(larger);
+  head = 0;
+}
+
+//----------------------------------------------------------------
+//---------------------------RxDispatcher-------------------------
+//----------------------------------------------------------------
+RxDispatcher::RxDispatcher(Handler _handler) : handler(_handler) {
+  stopped = true;
+  for(int l=0;l<RX_N_LANES;l++) memset(&lanes[l].stats, 0, sizeof(RxLaneStats));
+  configure(RX_FEEDBACK, 64,  true);    //only the newest state matters
+  configure(RX_SERVICE,  64,  false);
+  configure(RX_LOG,      256, false);
+}
+
+void RxDispatcher::configure(RxLane l, size_t capacity, bool drop_oldest) {
+  std::lock_guard<std::mutex> lock(lanes[l].mutex);
+  RxQueue& q = lanes[l].queue;
+  q.frames.resize(std::max((size_t) 1, capacity));
+  q.head = 0;
+  q.count = 0;
+  q.drop_oldest = drop_oldest;
+
+  RxQueue& c = lanes[l].critical;
+  c.frames.resize(16);
+  c.head = 0;
+  c.count = 0;
+  c.drop_oldest = false;
+}
+
+RxLane RxDispatcher::classify(uint8_t msgID) {
+  switch(msgID) {
+    case CS_REQUEST_OUT:
+    case CS_TEXT:
+      return RX_SERVICE;
+    case CS_MENUSTREAM:
+    case CS_MISSIONLOG:
+    case CS_DATALOG:
+      return RX_LOG;
+    default:
+      return RX_FEEDBACK;
+  }
+}
+
+bool RxDispatcher::critical(uint8_t msgID) {
+  switch(msgID) {
+    case LINK_HELLO:
+    case CS_LEAK:
+    case CS_STATUS:
+    case CS_CTRL_STATUS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+const char* RxDispatcher::laneName(RxLane l) {
+  switch(l) {
+    case RX_FEEDBACK: return "feedback";
+    case RX_SERVICE:  return "service";
+    case RX_LOG:      return "log";
+    default:          return "unknown";
+  }
+}
+
+//----------------------------------------------------------------
+bool RxDispatcher::dispatch(uint8_t msgID, const char* payload, uint8_t len, uint64_t rx_ns) {
+  RxLane l = classify(msgID);
+  Lane& lane = lanes[l];
+  {
+    std::lock_guard<std::mutex> lock(lane.mutex);
+    RxQueue& q = critical(msgID) ? lane.critical : lane.queue;
+    if(q.count == q.frames.size()) {
+      //Only allocates when the lane is that far behind
+      if(&q == &lane.critical) q.grow();
+      else {
+        lane.stats.dropped++;
+        if(!q.drop_oldest) return false;
+        q.pop();
+      }
+    }
+    q.at(q.count).set(msgID, payload, len, rx_ns);
+    q.count++;
+    lane.stats.dispatched++;
+    lane.stats.max_depth = std::max(lane.stats.max_depth, (uint32_t) (lane.queue.count + lane.critical.count));
+  }
+  lane.cv.notify_one();
+  return true;
+}
+
+//----------------------------------------------------------------
+void RxDispatcher::start() {
+  if(!stopped) return;
+  stopped = false;
+  for(int l=0;l<RX_N_LANES;l++) lanes[l].thread = std::thread(&RxDispatcher::run, this, (RxLane) l);
+}
+
+void RxDispatcher::stop() {
+  if(stopped) return;
+  stopped = true;
+  for(int l=0;l<RX_N_LANES;l++) {
+    { std::lock_guard<std::mutex> lock(lanes[l].mutex); }  //no wait in between check and sleep
+    lanes[l].cv.notify_one();
+    if(lanes[l].thread.joinable()) lanes[l].thread.join();
+  }
+}
+
+void RxDispatcher::run(RxLane l) {
+  char name[16];
+  snprintf(name, sizeof(name), "rx_%s", laneName(l));
+  TRACE_THREAD(name);
+
+  Lane& lane = lanes[l];
+  RxFrame frame;
+  std::unique_lock<std::mutex> lock(lane.mutex);
+
+  while(!stopped) {
+    RxQueue& q = lane.critical.count > 0 ? lane.critical : lane.queue;
+    if(q.count == 0) { lane.cv.wait(lock); continue; }
+
+    frame = q.at(0);
+    q.pop();
+
+    lock.unlock();
+    Clock::time_point start = Clock::now();
+    handler(frame);
+    Clock::time_point end = Clock::now();
+    lock.lock();
+
+    double latency_us = std::chrono::duration<double, std::micro>(start - frame.received).count();
+    double handler_us = std::chrono::duration<double, std::micro>(end - start).count();
+    lane.stats.handled++;
+    lane.latency_sum_us += latency_us;
+    lane.stats.latency_max_us = std::max(lane.stats.latency_max_us, latency_us);
+    lane.stats.handler_max_us = std::max(lane.stats.handler_max_us, handler_us);
+  }
+}
+
+RxLaneStats RxDispatcher::stats(RxLane l) {
+  Lane& lane = lanes[l];
+  std::lock_guard<std::mutex> lock(lane.mutex);
+  RxLaneStats s = lane.stats;
+  s.depth = lane.queue.count + lane.critical.count;
+
+  //Latency over the frames handled since the last call
+  uint32_t n = s.handled - lane.handled_at_last_stats;
+  s.latency_avg_us = n > 0 ? lane.latency_sum_us / n : 0;
+  lane.handled_at_last_stats = s.handled;
+  lane.latency_sum_us = 0;
+  lane.stats.latency_max_us = 0;
+  lane.stats.handler_max_us = 0;
+  return s;
+}
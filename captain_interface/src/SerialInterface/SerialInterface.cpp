@@ -0,0 +1,136 @@
+#include <captain_interface/SerialInterface/SerialInterface.h>
+#include <captain_interface/Tracing/Tracing.h>
+#include <captain_interface/ClockSync/ClockSync.h>
+#include <captain_interface/Log/Log.h>
+#include <captain_interface/LinkTuning/LinkTuning.h>
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <poll.h>
+
+#define SERIAL_WRITE_LIMIT 65536 // Pending bytes before frames are dropped
+
+SerialInterface::SerialInterface() : port(io_service) {
+  stopped = true;
+  write_overflows = 0;
+  write_pending.reserve(SERIAL_WRITE_LIMIT);
+  write_active.reserve(SERIAL_WRITE_LIMIT);
+};
+
+bool SerialInterface::setup(const std::string& device, unsigned baud) {
+  int fd = ::open(device.c_str(), O_RDWR | O_NOCTTY);
+  if(fd < 0) { CLOG_ERROR("%s: %s", device.c_str(), strerror(errno)); return false; }
+  return attach(fd, baud);
+}
+
+bool SerialInterface::attach(int fd, unsigned baud) {
+  stop();
+  boost::system::error_code error;
+  port.assign(fd, error);
+  if(error) { CLOG_ERROR("Serial: %s", error.message().c_str()); ::close(fd); return false; }
+  if(!configure(baud)) { port.close(error); return false; }
+
+  stopped = false;
+  read_thread = std::thread(&SerialInterface::readData, this);
+  write_thread = std::thread(&SerialInterface::writeData, this);
+  return true;
+}
+
+bool SerialInterface::configure(unsigned baud) {
+  //8N1, no flow control
+  boost::system::error_code error;
+  port.set_option(boost::asio::serial_port_base::baud_rate(baud), error);
+  if(error) { CLOG_ERROR("Serial: baud rate %u: %s", baud, error.message().c_str()); return false; }
+  port.set_option(boost::asio::serial_port_base::character_size(8), error);
+  port.set_option(boost::asio::serial_port_base::parity(boost::asio::serial_port_base::parity::none), error);
+  port.set_option(boost::asio::serial_port_base::stop_bits(boost::asio::serial_port_base::stop_bits::one), error);
+  port.set_option(boost::asio::serial_port_base::flow_control(boost::asio::serial_port_base::flow_control::none), error);
+
+  //Raw mode. With VMIN = VTIME = 0 a read after poll() returns the whole
+  //block buffered by the tty layer without waiting for more
+  int fd = port.native_handle();
+  termios tio;
+  if(tcgetattr(fd, &tio) != 0) { CLOG_ERROR("tcgetattr: %s", strerror(errno)); return false; }
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cc[VMIN] = SERIAL_READ_MIN;
+  tio.c_cc[VTIME] = SERIAL_READ_GAP;
+  if(tcsetattr(fd, TCSANOW, &tio) != 0) { CLOG_ERROR("tcsetattr: %s", strerror(errno)); return false; }
+  tcflush(fd, TCIOFLUSH);
+  return true;
+}
+
+//No socket options on a tty, only the reader and writer threads
+void SerialInterface::applyLinkProfile(const LinkProfile& profile, std::vector<std::string>& report) {
+  if(read_thread.joinable()) report.push_back(tune_thread(read_thread.native_handle(), "serial reader", profile));
+  if(write_thread.joinable()) report.push_back(tune_thread(write_thread.native_handle(), "serial writer", profile));
+}
+
+void SerialInterface::stop() {
+  if(stopped) return;
+  {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    stopped = true;
+  }
+  write_cv.notify_all();
+  if(read_thread.joinable()) read_thread.join();
+  if(write_thread.joinable()) write_thread.join();
+  boost::system::error_code error;
+  port.close(error);
+}
+
+//----------------------------------------------------------------
+void SerialInterface::readData() {
+  CLOG_INFO("Reading started");
+  TRACE_THREAD("serial_rx");
+  char rbuf[SERIAL_READ_BLOCK];
+  pollfd pfd = {port.native_handle(), POLLIN, 0};
+  while(!stopped) {
+    //Wait with a timeout so stop() does not depend on traffic
+    int ready = poll(&pfd, 1, 100);
+    if(ready <= 0) continue;
+
+    boost::system::error_code error;
+    size_t len = port.read_some(boost::asio::buffer(rbuf, sizeof(rbuf)), error);
+    if(error) {
+      if(!stopped) CLOG_ERROR("Serial read error: %s", error.message().c_str());
+      break;
+    }
+    TRACE_SPAN("receive", len);
+    setReceiveTime(realtime_ns());   //a tty has no kernel timestamps
+    for(size_t i=0;i<len;i++) parse_data(rbuf[i]);
+  }
+  CLOG_INFO("Reading done!");
+}
+
+bool SerialInterface::send_data(char* buf, uint8_t len) {
+  std::lock_guard<std::mutex> lock(write_mutex);
+  if(stopped) return false;
+  if(write_pending.size() + len > SERIAL_WRITE_LIMIT) { write_overflows++; return false; }
+  write_pending.insert(write_pending.end(), buf, buf + len);
+  write_cv.notify_one();
+  return true;
+}
+
+void SerialInterface::writeData() {
+  TRACE_THREAD("serial_tx");
+  std::unique_lock<std::mutex> lock(write_mutex);
+  while(true) {
+    write_cv.wait(lock, [this]{ return stopped || !write_pending.empty(); });
+    if(stopped) break;
+
+    //Take everything queued so far and write it without holding the lock
+    write_active.swap(write_pending);
+    lock.unlock();
+    TRACE_SPAN("write", write_active.size());
+    boost::system::error_code error;
+    boost::asio::write(port, boost::asio::buffer(write_active), error);
+    if(error) CLOG_ERROR("Serial write error: %s", error.message().c_str());
+    write_active.clear();
+    lock.lock();
+  }
+}
@@ -0,0 +1,126 @@
+#include <captain_interface/SharedTelemetry/SharedTelemetry.h>
+#include <captain_interface/Log/Log.h>
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <new>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//----------------------------------------------------------------
+//-----------------------------Writer-----------------------------
+//----------------------------------------------------------------
+bool SharedTelemetryWriter::open(const std::string& _name) {
+  close();
+  name = _name;
+
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+  if(fd < 0) { CLOG_ERROR("shm_open %s: %s", name.c_str(), strerror(errno)); return false; }
+  if(ftruncate(fd, sizeof(SharedTelemetryRegion)) != 0) { CLOG_ERROR("ftruncate: %s", strerror(errno)); ::close(fd); return false; }
+
+  void* mem = mmap(NULL, sizeof(SharedTelemetryRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(mem == MAP_FAILED) { CLOG_ERROR("mmap: %s", strerror(errno)); return false; }
+
+  //Readers check magic, so set it last
+  region = new (mem) SharedTelemetryRegion();
+  region->version = SHARED_TELEMETRY_VERSION;
+  region->ring_size = SHARED_TELEMETRY_RING_SIZE;
+  region->head.store(0);
+  std::atomic_thread_fence(std::memory_order_release);
+  region->magic = SHARED_TELEMETRY_MAGIC;
+  return true;
+}
+
+void SharedTelemetryWriter::close() {
+  if(region == NULL) return;
+  region->magic = 0;
+  munmap(region, sizeof(SharedTelemetryRegion));
+  shm_unlink(name.c_str());
+  region = NULL;
+}
+
+void SharedTelemetryWriter::write(uint8_t msgID, const char* data, uint8_t length) {
+  if(region == NULL) return;
+
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+
+  uint64_t index = region->head.load(std::memory_order_relaxed);
+  frame.index = index;
+  frame.rx_time_ns = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  frame.msgID = msgID;
+  frame.length = length;
+  memcpy(frame.data, data, length);
+
+  region->latest[msgID].store(frame);
+  region->ring[index & (SHARED_TELEMETRY_RING_SIZE-1)].store(frame);
+  region->head.store(index+1, std::memory_order_release);
+}
+
+//----------------------------------------------------------------
+//-----------------------------Reader-----------------------------
+//----------------------------------------------------------------
+bool SharedTelemetryReader::open(const std::string& name) {
+  close();
+
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if(fd < 0) return false;
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(SharedTelemetryRegion)) { ::close(fd); return false; }
+
+  void* mem = mmap(NULL, sizeof(SharedTelemetryRegion), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(mem == MAP_FAILED) return false;
+
+  region = (const SharedTelemetryRegion*) mem;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if(region->magic != SHARED_TELEMETRY_MAGIC || region->version != SHARED_TELEMETRY_VERSION) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void SharedTelemetryReader::close() {
+  if(region == NULL) return;
+  munmap((void*) region, sizeof(SharedTelemetryRegion));
+  region = NULL;
+}
+
+bool SharedTelemetryReader::latest(uint8_t msgID, TelemetryFrame& frame) const {
+  if(region == NULL) return false;
+  if(region->latest[msgID].version() == 0) return false;
+  frame = region->latest[msgID].load();
+  return true;
+}
+
+uint64_t SharedTelemetryReader::head() const {
+  if(region == NULL) return 0;
+  return region->head.load(std::memory_order_acquire);
+}
+
+bool SharedTelemetryReader::next(uint64_t& cursor, TelemetryFrame& frame, uint64_t* lost) const {
+  if(region == NULL) return false;
+
+  while(true) {
+    uint64_t h = head();
+    if(cursor >= h) return false;
+    if(h - cursor > SHARED_TELEMETRY_RING_SIZE) {
+      if(lost) *lost += h - cursor - SHARED_TELEMETRY_RING_SIZE;
+      cursor = h - SHARED_TELEMETRY_RING_SIZE;
+    }
+
+    const Seqlock<TelemetryFrame>& slot = region->ring[cursor & (SHARED_TELEMETRY_RING_SIZE-1)];
+    if(slot.try_load(frame) && frame.index == cursor) {
+      cursor++;
+      return true;
+    }
+    //Slot is being overwritten, the writer is lapping us. Try again
+  }
+}
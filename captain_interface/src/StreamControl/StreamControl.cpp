@@ -0,0 +1,109 @@
+#include <captain_interface/StreamControl/StreamControl.h>
+#include <captain_interface/scientistmsg.h>
+#include <string.h>
+
+StreamController::StreamController(SendFunction _send) : send(_send) {
+  memset(&counters, 0, sizeof(counters));
+};
+
+void StreamController::manage(uint8_t id, float rate) {
+  std::lock_guard<std::mutex> lock(mutex);
+  Stream& s = streams[id];
+  s.managed = true;
+  s.rate = rate;
+}
+
+void StreamController::setDemand(uint8_t id, bool wanted) {
+  std::lock_guard<std::mutex> lock(mutex);
+  Stream& s = streams[id];
+  if(!s.managed || (s.requested && s.wanted == wanted)) return;
+  s.wanted = wanted;
+  s.rejected = false;
+  new_request(id, s);
+}
+
+void StreamController::setRate(uint8_t id, float rate) {
+  std::lock_guard<std::mutex> lock(mutex);
+  Stream& s = streams[id];
+  if(!s.managed || s.rate == rate) return;
+  s.rate = rate;
+  if(s.requested && s.wanted) new_request(id, s);
+}
+
+void StreamController::resync() {
+  std::lock_guard<std::mutex> lock(mutex);
+  counters.resyncs++;
+  for(int id=0;id<256;id++) {
+    Stream& s = streams[id];
+    if(!s.managed) continue;
+    s.rejected = false;
+    new_request(id, s);
+  }
+}
+
+void StreamController::new_request(uint8_t id, Stream& s) {
+  s.generation = (s.generation + 1) & 0x3F;
+  s.requested = true;
+  s.confirmed = false;
+  s.pending = true;
+  s.retries = 0;
+  counters.requests++;
+  send_request(id, s);
+}
+
+void StreamController::send_request(uint8_t id, Stream& s) {
+  char buf[9];
+  uint8_t n = 0;
+  uint16_t ref = STREAM_REF_FLAG | (s.generation << 8) | id;
+  float rate = s.wanted ? s.rate : 0;
+  memcpy(buf+n, &ref, 2); n += 2;   //Same byte order as add_int
+  buf[n++] = SERVICE_STREAM;
+  buf[n++] = s.wanted ? SERVICE_ACTION_ENABLE : SERVICE_ACTION_DISABLE;
+  buf[n++] = id;
+  memcpy(buf+n, &rate, 4); n += 4;
+  s.sent = Clock::now();
+  send(SC_REQUEST_IN, buf, n);
+}
+
+bool StreamController::handle_ack(uint16_t ref, uint8_t reply) {
+  if((ref & 0xC000) != STREAM_REF_FLAG) return false;   //0x8000 is PATH_REF_FLAG
+  std::lock_guard<std::mutex> lock(mutex);
+
+  Stream& s = streams[ref & 0xFF];
+  if(!s.pending || ((ref >> 8) & 0x3F) != s.generation) return true; //Stale acknowledgements are consumed as well
+  s.pending = false;
+  if(reply == SERVICE_ACTION_SUCCESS) s.confirmed = true;
+  else s.rejected = true;
+  return true;
+}
+
+void StreamController::poll() {
+  std::lock_guard<std::mutex> lock(mutex);
+  Clock::time_point now = Clock::now();
+  for(int id=0;id<256;id++) {
+    Stream& s = streams[id];
+    if(!s.pending || std::chrono::duration<double>(now - s.sent).count() < timeout) continue;
+    if(s.retries >= max_retries) {
+      s.pending = false;    //Sent again with the next resync()
+      continue;
+    }
+    s.retries++;
+    counters.retransmits++;
+    send_request(id, s);
+  }
+}
+
+StreamControlStatus StreamController::status() {
+  std::lock_guard<std::mutex> lock(mutex);
+  StreamControlStatus c = counters;
+  for(int id=0;id<256;id++) {
+    const Stream& s = streams[id];
+    if(!s.managed) continue;
+    c.managed++;
+    if(s.wanted) c.enabled++;
+    if(s.confirmed) c.confirmed++;
+    if(s.pending) c.pending++;
+    if(s.rejected) c.rejected++;
+  }
+  return c;
+}
@@ -0,0 +1,344 @@
+#include <captain_interface/TelemetryStore/TelemetryStore.h>
+#include <captain_interface/Log/Log.h>
+
+#include <stdio.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//Messages recorded: the layouts that start with the captain timestamp
+static const MessageLayout* recorded_layout(uint8_t msgID) {
+  const MessageLayout* layout = message_layout(msgID);
+  if(layout == NULL || layout->fields[0].type != FIELD_LLONG || strcmp(layout->fields[0].name, "timestamp") != 0) return NULL;
+  return layout;
+}
+
+static bool write_all(int fd, const char* data, size_t length) {
+  while(length > 0) {
+    ssize_t n = ::write(fd, data, length);
+    if(n < 0) { if(errno == EINTR) continue; return false; }
+    data += n;
+    length -= n;
+  }
+  return true;
+}
+
+static void reset_stats(TelemetryFieldStats& s) {
+  s.min = std::numeric_limits<double>::infinity();
+  s.max = -std::numeric_limits<double>::infinity();
+  s.sum = 0;
+}
+
+//----------------------------------------------------------------
+//-----------------------------Writer-----------------------------
+//----------------------------------------------------------------
+bool TelemetryStoreWriter::open(const std::string& base_dir, uint32_t _chunk_rows, size_t queue_size) {
+  close();
+  chunk_rows = std::max((uint32_t) 1, _chunk_rows);
+
+  //Two starts in the same second get their own directories
+  char name[32];
+  time_t now = time(NULL);
+  strftime(name, sizeof(name), "%Y%m%d_%H%M%S", localtime(&now));
+  mkdir(base_dir.c_str(), 0755);
+  std::string path = base_dir + "/" + name;
+  for(int i=1; mkdir(path.c_str(), 0755) != 0; i++) {
+    if(errno != EEXIST || i == 100) { CLOG_ERROR("mkdir %s: %s", path.c_str(), strerror(errno)); return false; }
+    path = base_dir + "/" + name + "_" + std::to_string(i);
+  }
+
+  dir = path;
+  failed = false;
+  dropped = 0;
+  queue.resize(std::max((size_t) 1, queue_size));
+  queue_head = queue_count = 0;
+  stopping = false;
+  last_flush = std::chrono::steady_clock::now();
+  thread = std::thread(&TelemetryStoreWriter::run, this);
+  return true;
+}
+
+void TelemetryStoreWriter::close() {
+  if(!isOpen()) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  cv.notify_one();
+  if(thread.joinable()) thread.join();
+
+  flush();
+  for(int i=0;i<256;i++) {
+    Table* t = tables[i];
+    if(t == NULL) continue;
+    for(size_t c=0;c<t->columns.size();c++) ::close(t->columns[c].fd);
+    ::close(t->index_fd);
+    delete t;
+    tables[i] = NULL;
+  }
+  dir.clear();
+}
+
+bool TelemetryStoreWriter::write(uint8_t msgID, const char* data, uint8_t length) {
+  if(!isOpen() || recorded_layout(msgID) == NULL) return false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(queue_count == queue.size()) { dropped++; return false; }
+    Record& r = queue[(queue_head + queue_count) % queue.size()];
+    r.msgID = msgID;
+    r.length = length;
+    memcpy(r.data, data, length);
+    queue_count++;
+  }
+  cv.notify_one();
+  return true;
+}
+
+void TelemetryStoreWriter::run() {
+  Record r;
+  std::unique_lock<std::mutex> lock(mutex);
+  while(true) {
+    cv.wait_for(lock, std::chrono::duration<double>(flush_interval), [this] {return queue_count > 0 || stopping;});
+    if(queue_count == 0 && stopping) return;
+
+    if(queue_count > 0) {
+      r = queue[queue_head];
+      queue_head = (queue_head + 1) % queue.size();
+      queue_count--;
+      lock.unlock();
+      append(r.msgID, r.data, r.length);
+    }
+    else lock.unlock();
+
+    if(std::chrono::duration<double>(std::chrono::steady_clock::now() - last_flush).count() > flush_interval) flush();
+    lock.lock();
+  }
+}
+
+TelemetryStoreWriter::Table* TelemetryStoreWriter::open_table(uint8_t msgID) {
+  const MessageLayout* layout = recorded_layout(msgID);
+  if(layout == NULL) return NULL;
+
+  Table* t = new Table();
+  t->layout = layout;
+  t->columns.resize(layout->n_fields);
+
+  std::string prefix = dir + "/" + layout->name + ".";
+  bool ok = true;
+  for(int i=0;i<layout->n_fields;i++) {
+    Column& c = t->columns[i];
+    c.fd = ::open((prefix + layout->fields[i].name).c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND, 0644);
+    c.pending.reserve(chunk_rows * message_field_size(layout->fields[i].type));
+    reset_stats(c.stats);
+    ok = ok && c.fd >= 0;
+  }
+
+  t->index_fd = ::open((prefix + "index").c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND, 0644);
+  TelemetryIndexHeader header = {TELEMETRY_INDEX_MAGIC, TELEMETRY_INDEX_VERSION, msgID, layout->n_fields, chunk_rows, 0};
+  ok = ok && t->index_fd >= 0 && write_all(t->index_fd, (const char*) &header, sizeof(header));
+
+  if(!ok) {
+    CLOG_ERROR("Telemetry store: %s", strerror(errno));
+    for(size_t i=0;i<t->columns.size();i++) if(t->columns[i].fd >= 0) ::close(t->columns[i].fd);
+    if(t->index_fd >= 0) ::close(t->index_fd);
+    delete t;
+    return NULL;
+  }
+  return t;
+}
+
+bool TelemetryStoreWriter::append(uint8_t msgID, const char* data, uint8_t length) {
+  if(failed) return false;
+
+  Table* t = tables[msgID];
+  if(t == NULL) {
+    if(recorded_layout(msgID) == NULL) return false;
+    t = tables[msgID] = open_table(msgID);
+    if(t == NULL) {
+      CLOG_ERROR("Telemetry store: could not create files in %s, recording stopped", dir.c_str());
+      failed = true;
+      return false;
+    }
+  }
+
+  //Short frames would leave the columns out of step
+  const MessageLayout* layout = t->layout;
+  uint64_t row[32];
+  if(!message_decode(layout, data, length, row)) return false;
+
+  for(int i=0;i<layout->n_fields;i++) {
+    Column& c = t->columns[i];
+    MessageFieldType type = layout->fields[i].type;
+    const char* native = (const char*) row + layout->fields[i].offset;
+
+    c.pending.insert(c.pending.end(), native, native + message_field_size(type));
+    double v = message_field_value(type, native);
+    c.stats.min = std::min(c.stats.min, v);
+    c.stats.max = std::max(c.stats.max, v);
+    c.stats.sum += v;
+  }
+
+  uint64_t timestamp;
+  memcpy(&timestamp, &t->columns[0].pending[t->columns[0].pending.size() - 8], 8);
+  if(t->chunk_fill == 0) t->t_first = timestamp;
+  t->t_last = timestamp;
+  t->rows++;
+  t->chunk_fill++;
+
+  if(t->chunk_fill == chunk_rows) {
+    flush_table(t);
+    write_chunk_index(t);
+  }
+  return true;
+}
+
+void TelemetryStoreWriter::write_chunk_index(Table* t) {
+  std::vector<char> entry(sizeof(TelemetryChunkIndex) + t->columns.size() * sizeof(TelemetryFieldStats));
+  TelemetryChunkIndex* chunk = (TelemetryChunkIndex*) &entry[0];
+  chunk->first_row = t->rows - t->chunk_fill;
+  chunk->t_first = t->t_first;
+  chunk->t_last = t->t_last;
+  TelemetryFieldStats* stats = (TelemetryFieldStats*) (chunk+1);
+  for(size_t i=0;i<t->columns.size();i++) {
+    stats[i] = t->columns[i].stats;
+    reset_stats(t->columns[i].stats);
+  }
+  write_all(t->index_fd, &entry[0], entry.size());
+  t->chunk_fill = 0;
+}
+
+void TelemetryStoreWriter::flush_table(Table* t) {
+  for(size_t i=0;i<t->columns.size();i++) {
+    Column& c = t->columns[i];
+    if(c.pending.empty()) continue;
+    if(!write_all(c.fd, &c.pending[0], c.pending.size())) CLOG_ERROR("Telemetry store: %s", strerror(errno));
+    c.pending.clear();
+  }
+}
+
+void TelemetryStoreWriter::flush() {
+  for(int i=0;i<256;i++) if(tables[i] != NULL) flush_table(tables[i]);
+  last_flush = std::chrono::steady_clock::now();
+}
+
+//----------------------------------------------------------------
+//-----------------------------Reader-----------------------------
+//----------------------------------------------------------------
+const char* TelemetryStoreReader::map_file(const std::string& path, size_t& length) {
+  length = 0;
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0) return NULL;
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return NULL; }
+  void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(addr == MAP_FAILED) return NULL;
+
+  Mapping m = {addr, (size_t) st.st_size};
+  mappings.push_back(m);
+  length = st.st_size;
+  return (const char*) addr;
+}
+
+bool TelemetryStoreReader::open(const std::string& dir) {
+  close();
+
+  int n_layouts;
+  const MessageLayout* layouts = message_layouts(n_layouts);
+  bool found = false;
+
+  for(int s=0;s<n_layouts;s++) {
+    const MessageLayout* layout = &layouts[s];
+    if(recorded_layout(layout->msgID) == NULL) continue;
+    TelemetryTable& t = tables[layout->msgID];
+    std::string prefix = dir + "/" + layout->name + ".";
+
+    const char* index = map_file(prefix + "index", t.index_bytes);
+    if(index == NULL || t.index_bytes < sizeof(TelemetryIndexHeader)) continue;
+    t.header = (const TelemetryIndexHeader*) index;
+    if(t.header->magic != TELEMETRY_INDEX_MAGIC || t.header->version != TELEMETRY_INDEX_VERSION || t.header->n_fields != layout->n_fields) {
+      CLOG_ERROR("%s: unknown index format", (prefix + "index").c_str());
+      continue;
+    }
+
+    //A crash can leave the columns with different lengths, use the shortest
+    t.columns.resize(layout->n_fields);
+    t.column_bytes.resize(layout->n_fields);
+    uint64_t rows = std::numeric_limits<uint64_t>::max();
+    for(int i=0;i<layout->n_fields;i++) {
+      t.columns[i] = map_file(prefix + layout->fields[i].name, t.column_bytes[i]);
+      rows = std::min(rows, (uint64_t) (t.column_bytes[i] / message_field_size(layout->fields[i].type)));
+    }
+    if(rows == 0) continue;
+
+    t.entry_size = sizeof(TelemetryChunkIndex) + layout->n_fields * sizeof(TelemetryFieldStats);
+    t.chunks = std::min((uint64_t) ((t.index_bytes - sizeof(TelemetryIndexHeader)) / t.entry_size), rows / t.header->chunk_rows);
+    t.rows = rows;
+    t.layout = layout;
+    found = true;
+  }
+  return found;
+}
+
+void TelemetryStoreReader::close() {
+  for(size_t i=0;i<mappings.size();i++) munmap(mappings[i].addr, mappings[i].length);
+  mappings.clear();
+  for(int i=0;i<256;i++) tables[i] = TelemetryTable();
+}
+
+const TelemetryTable* TelemetryStoreReader::table(const char* name) const {
+  const MessageLayout* layout = message_layout(name);
+  if(layout == NULL) return NULL;
+  return table(layout->msgID);
+}
+
+//----------------------------------------------------------------
+int TelemetryTable::field(const char* name) const {
+  for(int i=0;i<layout->n_fields;i++) if(strcmp(layout->fields[i].name, name) == 0) return i;
+  return -1;
+}
+
+uint64_t TelemetryTable::lower_bound(uint64_t t) const {
+  //Binary search on the mmapped timestamp column
+  uint64_t lo = 0, hi = rows;
+  while(lo < hi) {
+    uint64_t mid = lo + (hi - lo) / 2;
+    if(timestamp(mid) < t) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+void TelemetryTable::aggregate(int f, uint64_t begin, uint64_t end, uint64_t& count, TelemetryFieldStats& stats) const {
+  reset_stats(stats);
+  end = std::min(end, rows);
+  count = begin < end ? end - begin : 0;
+
+  uint64_t chunk_rows = header->chunk_rows;
+  uint64_t row = begin;
+  while(row < end) {
+    uint64_t c = row / chunk_rows;
+    if(row % chunk_rows == 0 && c < chunks && row + chunk_rows <= end) {
+      //Whole chunk from the index
+      const TelemetryFieldStats* s = chunk_stats(c, f);
+      stats.min = std::min(stats.min, s->min);
+      stats.max = std::max(stats.max, s->max);
+      stats.sum += s->sum;
+      row += chunk_rows;
+      continue;
+    }
+    uint64_t stop = std::min(end, (c+1) * chunk_rows);
+    for(;row<stop;row++) {
+      double v = value(f, row);
+      stats.min = std::min(stats.min, v);
+      stats.max = std::max(stats.max, v);
+      stats.sum += v;
+    }
+  }
+}
@@ -0,0 +1,104 @@
+#include <captain_interface/TopicPolicy/TopicPolicy.h>
+#include <stdio.h>
+#include <string.h>
+
+TopicPolicy::TopicPolicy() : received(0), published(0) {
+  memset(sum, 0, sizeof(sum));
+  memset(lo, 0, sizeof(lo));
+  memset(hi, 0, sizeof(hi));
+  memset(avg, 0, sizeof(avg));
+}
+
+bool TopicPolicy::parseMode(const std::string& name, TopicPolicyMode& m) {
+  if(name == "pass") m = POLICY_PASS;
+  else if(name == "decimate") m = POLICY_DECIMATE;
+  else if(name == "throttle") m = POLICY_THROTTLE;
+  else if(name == "aggregate") m = POLICY_AGGREGATE;
+  else return false;
+  return true;
+}
+
+bool TopicPolicy::configure(TopicPolicyMode m, double value) {
+  switch(m) {
+    case POLICY_PASS: break;
+    case POLICY_DECIMATE:
+      if(value < 1) return false;
+      every = (uint32_t) value;
+      break;
+    case POLICY_THROTTLE:
+      if(value <= 0) return false;
+      period_ns = (uint64_t) (1e9 / value);
+      break;
+    case POLICY_AGGREGATE:
+      if(value <= 0) return false;
+      period_ns = (uint64_t) (value * 1e9);
+      break;
+  }
+  mode = m;
+  count = 0;
+  last_ns = 0;
+  samples = 0;
+  return true;
+}
+
+void TopicPolicy::store(const float* values, int n) {
+  for(int i=0;i<n;i++) lo[i] = hi[i] = avg[i] = values[i];
+}
+
+bool TopicPolicy::admit(uint64_t now_ns, const float* values, int n) {
+  received++;
+  if(n > TOPIC_POLICY_FIELDS) n = TOPIC_POLICY_FIELDS;
+
+  switch(mode) {
+    case POLICY_PASS:
+      break;
+
+    case POLICY_DECIMATE:
+      if(count++ % every != 0) return false;
+      break;
+
+    case POLICY_THROTTLE:
+      if(last_ns != 0 && now_ns - last_ns < period_ns) return false;
+      //Keep the schedule while frames arrive on time, restart it after a gap
+      if(last_ns != 0 && now_ns - last_ns < 2 * period_ns) last_ns += period_ns;
+      else last_ns = now_ns;
+      break;
+
+    case POLICY_AGGREGATE:
+      if(samples > 0 && now_ns - sample_ns > period_ns) samples = 0;
+      if(samples == 0) {
+        last_ns = now_ns;
+        for(int i=0;i<n;i++) {
+          sum[i] = 0;
+          lo[i] = hi[i] = values[i];
+        }
+      }
+      for(int i=0;i<n;i++) {
+        sum[i] += values[i];
+        if(values[i] < lo[i]) lo[i] = values[i];
+        if(values[i] > hi[i]) hi[i] = values[i];
+      }
+      samples++;
+      sample_ns = now_ns;
+      if(now_ns - last_ns < period_ns) return false;
+      for(int i=0;i<n;i++) avg[i] = sum[i] / samples;
+      samples = 0;
+      published++;
+      return true;
+  }
+
+  store(values, n);
+  published++;
+  return true;
+}
+
+std::string TopicPolicy::describe() {
+  char buf[48];
+  switch(mode) {
+    case POLICY_DECIMATE:  snprintf(buf, sizeof(buf), "decimate %u", every); break;
+    case POLICY_THROTTLE:  snprintf(buf, sizeof(buf), "throttle %g Hz", 1e9 / period_ns); break;
+    case POLICY_AGGREGATE: snprintf(buf, sizeof(buf), "aggregate %g s", period_ns / 1e9); break;
+    default:               snprintf(buf, sizeof(buf), "pass");
+  }
+  return buf;
+}
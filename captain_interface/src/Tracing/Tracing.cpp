@@ -0,0 +1,125 @@
+#include <captain_interface/Tracing/Tracing.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <vector>
+
+#define TRACE_MAX_THREADS 64
+
+#ifdef CAPTAIN_TRACING
+std::atomic<bool> trace_active(true);
+#else
+std::atomic<bool> trace_active(false);
+#endif
+
+//One writer per ring. The reader copies the ring and discards whatever the
+//writer may have overwritten in the meantime
+struct TraceRing {
+  TraceEvent events[TRACE_RING_SIZE];
+  std::atomic<uint64_t> head;         // events written in total
+  char name[32];
+  int tid;
+};
+
+static std::atomic<TraceRing*> rings[TRACE_MAX_THREADS];
+static std::atomic<int> ring_count(0);
+static thread_local TraceRing* thread_ring = NULL;
+static thread_local bool thread_untraced = false;   //more threads than rings
+static std::atomic<bool> dump_requested(false);
+
+static TraceRing* get_ring() {
+  if(thread_ring != NULL || thread_untraced) return thread_ring;
+  int index = ring_count.fetch_add(1);
+  if(index >= TRACE_MAX_THREADS) { thread_untraced = true; return NULL; }
+
+  //Created once per thread and never freed, so a dump can still read threads that have exited
+  TraceRing* ring = new TraceRing();
+  ring->head = 0;
+  ring->tid = syscall(SYS_gettid);
+  if(pthread_getname_np(pthread_self(), ring->name, sizeof(ring->name)) != 0) ring->name[0] = 0;
+  rings[index].store(ring, std::memory_order_release);
+  thread_ring = ring;
+  return ring;
+}
+
+void trace_thread_name(const char* name) {
+  TraceRing* ring = get_ring();
+  if(ring == NULL) return;
+  strncpy(ring->name, name, sizeof(ring->name) - 1);
+  ring->name[sizeof(ring->name) - 1] = 0;
+}
+
+void trace_record(const char* name, uint64_t start_ns, uint64_t end_ns, int32_t arg) {
+  TraceRing* ring = get_ring();
+  if(ring == NULL) return;
+  uint64_t h = ring->head.load(std::memory_order_relaxed);
+  TraceEvent& e = ring->events[h & (TRACE_RING_SIZE - 1)];
+  e.name = name;
+  e.start_ns = start_ns;
+  e.duration_ns = end_ns - start_ns;
+  e.arg = arg;
+  ring->head.store(h + 1, std::memory_order_release);
+}
+
+//----------------------------------------------------------------
+bool trace_dump(const std::string& path) {
+  FILE* f = fopen(path.c_str(), "w");
+  if(f == NULL) return false;
+
+  fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"captain_interface\"}}", (int) getpid());
+
+  std::vector<TraceEvent> copy;
+  int n_rings = ring_count.load();
+  if(n_rings > TRACE_MAX_THREADS) n_rings = TRACE_MAX_THREADS;
+  for(int r=0;r<n_rings;r++) {
+    TraceRing* ring = rings[r].load(std::memory_order_acquire);
+    if(ring == NULL) continue;   //registration in progress
+
+    uint64_t end = ring->head.load(std::memory_order_acquire);
+    uint64_t begin = end > TRACE_RING_SIZE ? end - TRACE_RING_SIZE : 0;
+    copy.clear();
+    for(uint64_t i=begin;i<end;i++) copy.push_back(ring->events[i & (TRACE_RING_SIZE - 1)]);
+
+    //Entries the writer reached again while we were copying are not trustworthy
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t valid = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    size_t skip = valid > begin ? valid - begin : 0;
+
+    fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            (int) getpid(), ring->tid, ring->name[0] ? ring->name : "thread");
+    for(size_t i=skip;i<copy.size();i++) {
+      const TraceEvent& e = copy[i];
+      fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+              e.name, (int) getpid(), ring->tid, e.start_ns / 1000.0, e.duration_ns / 1000.0);
+      if(e.arg >= 0) fprintf(f, ",\"args\":{\"arg\":%d}", e.arg);
+      fprintf(f, "}");
+    }
+  }
+
+  fprintf(f, "\n]}\n");
+  bool ok = ferror(f) == 0;
+  fclose(f);
+  return ok;
+}
+
+//----------------------------------------------------------------
+static void trace_signal_handler(int) {
+  dump_requested = true;
+}
+
+void trace_install_signal(int signum) {
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = trace_signal_handler;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  sigaction(signum, &sa, NULL);
+}
+
+bool trace_dump_requested() {
+  return dump_requested.exchange(false);
+}
@@ -0,0 +1,201 @@
+#include <captain_interface/TxScheduler/TxScheduler.h>
+#include <captain_interface/scientistmsg.h>
+#include <captain_interface/Tracing/Tracing.h>
+#include <string.h>
+#include <algorithm>
+
+TxScheduler::TxScheduler(SendFunction _send) : send(_send) {
+  memset(class_stats, 0, sizeof(class_stats));
+  memset(latency_sum_us, 0, sizeof(latency_sum_us));
+  memset(sent_at_last_stats, 0, sizeof(sent_at_last_stats));
+  configure(TX_SAFETY,  8,  TX_REPLACE_SAME_ID);    //abort has its own slot
+  configure(TX_CONTROL, 32, TX_REPLACE_SAME_ID);
+  configure(TX_BULK,    64, TX_DROP_NEWEST);
+  bulk_refill = Clock::now();
+};
+
+void TxScheduler::configure(TxClass c, size_t capacity, TxDropPolicy policy) {
+  std::lock_guard<std::mutex> lock(mutex);
+  queues[c].frames.resize(std::max((size_t) 1, capacity));
+  queues[c].head = 0;
+  queues[c].count = 0;
+  queues[c].policy = policy;
+}
+
+void TxScheduler::setBulkRate(double bytes_per_sec, double burst_bytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  bulk_rate = bytes_per_sec;
+  bulk_burst = std::max(burst_bytes, 255.0); //Must fit at least one frame
+  bulk_tokens = bulk_burst;
+  bulk_refill = Clock::now();
+}
+
+TxClass TxScheduler::classify(uint8_t msgID) {
+  switch(msgID) {
+    case SC_ABORT:
+    case SC_HEARTBEAT:
+    case SC_DONE:
+      return TX_SAFETY;
+    case 0: //hello
+    case SC_SET_RUDDER:
+    case SC_SET_ELEVATOR:
+    case SC_SET_THRUSTER_PORT:
+    case SC_SET_THRUSTER_STRB:
+    case SC_SET_TARGET_PITCH:
+    case SC_SET_TARGET_YAW:
+    case SC_SET_TARGET_YAW_RATE:
+    case SC_SET_TARGET_SPEED:
+    case SC_SET_TARGET_RPM:
+    case SC_SET_TARGET_DEPTH:
+    case SC_SET_TARGET_ALTITUDE:
+    case SC_SET_TARGET_WAYPOINT:
+      return TX_CONTROL;
+    default:
+      return TX_BULK;
+  }
+}
+
+//----------------------------------------------------------------
+bool TxScheduler::TxQueue::push(const char* data, uint8_t len, uint32_t& dropped) {
+  uint8_t msgID = data[1];
+
+  if(policy == TX_REPLACE_SAME_ID) {
+    //Only the newest setpoint of each kind matters
+    for(size_t i=0;i<count;i++) {
+      TxFrame& f = at(i);
+      if(f.msgID != msgID) continue;
+      memcpy(f.data, data, len);
+      f.len = len;
+      dropped++;
+      return true;
+    }
+  }
+
+  if(count == frames.size()) {
+    if(policy == TX_DROP_NEWEST) { dropped++; return false; }
+    pop();
+    dropped++;
+  }
+
+  TxFrame& f = at(count);
+  memcpy(f.data, data, len);
+  f.len = len;
+  f.msgID = msgID;
+  f.enqueued = Clock::now();
+  count++;
+  return true;
+}
+
+bool TxScheduler::enqueue(const char* frame, uint8_t len) {
+  if(len < 2) return false;
+  uint8_t msgID = frame[1];
+  TxClass c = classify(msgID);
+
+  bool queued;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(msgID == SC_ABORT) {
+      //Abort goes first, and pending setpoints must not follow it
+      class_stats[TX_CONTROL].dropped += queues[TX_CONTROL].count;
+      queues[TX_CONTROL].count = 0;
+      if(abort_pending) class_stats[c].dropped++;
+      memcpy(abort_frame.data, frame, len);
+      abort_frame.len = len;
+      abort_frame.msgID = msgID;
+      abort_frame.enqueued = Clock::now();
+      abort_pending = true;
+      queued = true;
+    }
+    else queued = queues[c].push(frame, len, class_stats[c].dropped);
+
+    if(queued) class_stats[c].enqueued++;
+    class_stats[c].max_depth = std::max(class_stats[c].max_depth, (uint32_t) (queues[c].count + (c == TX_SAFETY && abort_pending)));
+  }
+  cv.notify_one();
+  return queued;
+}
+
+//----------------------------------------------------------------
+void TxScheduler::start() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if(!stopped) return;
+  stopped = false;
+  tx_thread = std::thread(&TxScheduler::run, this);
+}
+
+void TxScheduler::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+  }
+  cv.notify_one();
+  if(tx_thread.joinable()) tx_thread.join();
+}
+
+void TxScheduler::run() {
+  TRACE_THREAD("tx_scheduler");
+  TxFrame frame;
+  std::unique_lock<std::mutex> lock(mutex);
+
+  while(!stopped) {
+    //Pending abort, else the highest class with something to send
+    int c = -1;
+    if(abort_pending) c = TX_SAFETY;
+    else for(int i=0;i<TX_N_CLASSES;i++) {
+      if(queues[i].count > 0) { c = i; break; }
+    }
+    if(c < 0) { cv.wait(lock); continue; }
+
+    if(abort_pending) {
+      frame = abort_frame;
+      abort_pending = false;
+    }
+    else {
+      if(c == TX_BULK && bulk_rate > 0) {
+        Clock::time_point now = Clock::now();
+        double dt = std::chrono::duration<double>(now - bulk_refill).count();
+        bulk_tokens = std::min(bulk_burst, bulk_tokens + dt * bulk_rate);
+        bulk_refill = now;
+
+        uint8_t len = queues[c].at(0).len;
+        if(bulk_tokens < len) {
+          //Wait for tokens, or for a higher priority frame
+          double wait_s = (len - bulk_tokens) / bulk_rate;
+          cv.wait_for(lock, std::chrono::duration<double>(wait_s));
+          continue;
+        }
+        bulk_tokens -= len;
+      }
+
+      frame = queues[c].at(0);
+      queues[c].pop();
+    }
+
+    double latency_us = std::chrono::duration<double, std::micro>(Clock::now() - frame.enqueued).count();
+
+    lock.unlock();
+    bool ok = send(frame.data, frame.len);
+    lock.lock();
+
+    if(ok) {
+      class_stats[c].sent++;
+      latency_sum_us[c] += latency_us;
+      class_stats[c].latency_max_us = std::max(class_stats[c].latency_max_us, latency_us);
+    }
+    else class_stats[c].dropped++;
+  }
+}
+
+TxClassStats TxScheduler::stats(TxClass c) {
+  std::lock_guard<std::mutex> lock(mutex);
+  TxClassStats s = class_stats[c];
+  s.depth = queues[c].count + (c == TX_SAFETY && abort_pending);
+
+  //Latency over the frames sent since the last call
+  uint32_t n = s.sent - sent_at_last_stats[c];
+  s.latency_avg_us = n > 0 ? latency_sum_us[c] / n : 0;
+  sent_at_last_stats[c] = s.sent;
+  latency_sum_us[c] = 0;
+  class_stats[c].latency_max_us = 0;
+  return s;
+}
@@ -1,4 +1,8 @@
 #include <captain_interface/UDPInterface/UDPInterface.h>
+#include <captain_interface/Tracing/Tracing.h>
+#include <captain_interface/ClockSync/ClockSync.h>
+#include <captain_interface/Log/Log.h>
+#include <captain_interface/LinkTuning/LinkTuning.h>
 
 #include <iostream>
 #include <boost/asio.hpp>
@@ -18,31 +22,42 @@ UDPInterface::UDPInterface() {
 void UDPInterface::setup(boost::asio::ip::udp::socket* socket, boost::asio::ip::udp::endpoint* endpoint) {
   udpSocket = socket;
   lolo_endpoint = endpoint;
+  if(!enable_rx_timestamps(socket->native_handle())) CLOG_WARN("UDP: no kernel receive timestamps, using read time");
   //start thread for reading
   readThread = new boost::thread(boost::bind(&UDPInterface::readData, this));
 };
 
+void UDPInterface::applyLinkProfile(const LinkProfile& profile, std::vector<std::string>& report) {
+  report.push_back(tune_socket(udpSocket->native_handle(), "udp socket", profile));
+  report.push_back(tune_thread(readThread->native_handle(), "udp reader", profile));
+}
+
 void UDPInterface::loop(){ /*DO something?*/ };
 
 void UDPInterface::readData() {
-  printf("Reading started\n");
+  CLOG_INFO("Reading started");
+  TRACE_THREAD("udp_rx");
   bool ok = true;
   while(ok && !stopped) {
     try
     {
-      udp::endpoint sender_endpoint;
-      size_t len = udpSocket->receive_from(boost::asio::buffer(rbuf,256), sender_endpoint);
+      //recvmsg for the kernel receive timestamp
+      uint64_t rx_ns;
+      ssize_t len = recv_timestamped(udpSocket->native_handle(), rbuf.data(), rbuf.size(), rx_ns);
+      if(len <= 0) continue;
       //printf("Received %d bytes\n", (int) len);
-      for(uint16_t i =0;i<len;i++) {
+      TRACE_SPAN("receive", len);
+      setReceiveTime(rx_ns);
+      for(ssize_t i =0;i<len;i++) {
         parse_data(rbuf[i]);
       }
     }
     catch (std::exception& e)
     {
-      std::cerr << e.what() << std::endl;
+      CLOG_ERROR("UDP: %s", e.what());
     }
   }
-  printf("Reading done!\n");
+  CLOG_INFO("Reading done!");
 }
 
 bool UDPInterface::send_data(char* buf, uint8_t len) {
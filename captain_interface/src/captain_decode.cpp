@@ -0,0 +1,294 @@
+/*------------------------------------------------------------------------------------
+	Offline decoder for raw captain byte streams, e.g. the UDP payloads of port 8888
+	extracted from a tcpdump. Does not need ROS.
+
+	captain_decode INPUT [opts]
+	  --out DIR        write one file per message ID, statistics only without it
+	  --format F       csv (default) or bin
+	  --threads N      decoder threads, default all cores
+	  --chunk MB       input split size, default 64
+
+	csv: offset of the frame in INPUT, then the fields of the MessageCodec layout.
+	     Text messages as a quoted string, anything else as the payload in hex
+	bin: MessageCodec messages as packed rows in native byte order, anything
+	     else as records of [uint8 payload length][payload]
+------------------------------------------------------------------------------------*/
+
+#include <captain_interface/FrameScanner/FrameScanner.h>
+#include <captain_interface/MessageCodec/MessageCodec.h>
+#include <captain_interface/scientistmsg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <chrono>
+
+static void usage() {
+  fprintf(stderr, "usage: captain_decode INPUT [--out DIR] [--format csv|bin] [--threads N] [--chunk MB]\n");
+}
+
+static std::string message_name(uint8_t id) {
+  const MessageLayout* layout = message_layout(id);
+  if(layout != NULL) return layout->name;
+  switch(id) {
+    case LINK_HELLO:      return "hello";
+    case CS_LEAK:         return "leak";
+    case CS_TEXT:         return "text";
+    case CS_MENUSTREAM:   return "menustream";
+    case CS_MISSIONLOG:   return "missionlog";
+    case CS_DATALOG:      return "datalog";
+  }
+  return "msg_" + std::to_string(id);
+}
+
+//----------------------------------------------------------------
+//Decoded output of one chunk, appended to the files in chunk order
+struct ChunkResult {
+  FrameScanStats stats;
+  uint64_t short_frames;     // shorter than their layout
+  std::string out[256];
+};
+
+struct Decoder {
+  const char* data;
+  size_t size;
+  size_t chunk_size;
+  size_t n_chunks;
+  bool write;
+  bool csv;
+
+  void append_csv(std::string& out, size_t offset, uint8_t id, const char* payload, uint8_t len, uint64_t& short_frames);
+  void append_bin(std::string& out, uint8_t id, const char* payload, uint8_t len, uint64_t& short_frames);
+  void decode(size_t chunk, ChunkResult& result);
+};
+
+void Decoder::append_csv(std::string& out, size_t offset, uint8_t id, const char* payload, uint8_t len, uint64_t& short_frames) {
+  char line[1024];
+  int n = snprintf(line, sizeof(line), "%llu", (unsigned long long) offset);
+  std::string text;
+
+  const MessageLayout* layout = message_layout(id);
+  if(layout != NULL) {
+    uint64_t row[32];
+    if(len < message_size(layout)) { short_frames++; return; }
+    message_decode(layout, payload, len, row);
+    for(int i=0;i<layout->n_fields;i++) {
+      MessageFieldType type = layout->fields[i].type;
+      const char* v = (const char*) row + layout->fields[i].offset;
+      switch(type) {
+        case FIELD_BYTE:   n += snprintf(line+n, sizeof(line)-n, ",%u", (uint8_t) v[0]); break;
+        case FIELD_INT:    {uint16_t x; memcpy(&x, v, 2); n += snprintf(line+n, sizeof(line)-n, ",%u", x);} break;
+        case FIELD_LONG:   {uint32_t x; memcpy(&x, v, 4); n += snprintf(line+n, sizeof(line)-n, ",%u", x);} break;
+        case FIELD_LLONG:  {uint64_t x; memcpy(&x, v, 8); n += snprintf(line+n, sizeof(line)-n, ",%llu", (unsigned long long) x);} break;
+        case FIELD_FLOAT:  {float x;    memcpy(&x, v, 4); n += snprintf(line+n, sizeof(line)-n, ",%.9g", x);} break;
+        case FIELD_DOUBLE: {double x;   memcpy(&x, v, 8); n += snprintf(line+n, sizeof(line)-n, ",%.17g", x);} break;
+      }
+    }
+  }
+  else if(is_text_message(id) && decode_text(payload, len, text)) {
+    //Quotes doubled as in RFC 4180
+    line[n++] = ','; line[n++] = '"';
+    for(size_t i=0;i<text.size();i++) {
+      if(text[i] == '"') line[n++] = '"';
+      line[n++] = text[i];
+    }
+    line[n++] = '"';
+  }
+  else {
+    static const char hex[] = "0123456789abcdef";
+    line[n++] = ',';
+    for(int i=0;i<len;i++) {
+      line[n++] = hex[(uint8_t) payload[i] >> 4];
+      line[n++] = hex[payload[i] & 0x0F];
+    }
+  }
+  line[n++] = '\n';
+  out.append(line, n);
+}
+
+void Decoder::append_bin(std::string& out, uint8_t id, const char* payload, uint8_t len, uint64_t& short_frames) {
+  const MessageLayout* layout = message_layout(id);
+  if(layout != NULL) {
+    uint64_t row[32];
+    if(len < message_size(layout)) { short_frames++; return; }
+    message_decode(layout, payload, len, row);
+    for(int i=0;i<layout->n_fields;i++) out.append((const char*) row + layout->fields[i].offset, message_field_size(layout->fields[i].type));
+  }
+  else {
+    out.push_back((char) len);
+    out.append(payload, len);
+  }
+}
+
+void Decoder::decode(size_t chunk, ChunkResult& result) {
+  memset(&result.stats, 0, sizeof(result.stats));
+  result.short_frames = 0;
+
+  //Both ends moved to the end of a valid frame, so neighbouring chunks neither miss nor repeat a frame
+  size_t from = chunk == 0 ? 0 : FrameScanner::boundary(data, size, chunk * chunk_size);
+  size_t to = chunk + 1 == n_chunks ? size : FrameScanner::boundary(data, size, (chunk + 1) * chunk_size);
+
+  FrameScanner scanner(data, size, from, to);
+  ScannedFrame frame;
+  while(scanner.next(frame, result.stats)) {
+    if(!write) continue;
+    uint8_t id = data[frame.offset+1];
+    const char* payload = data + frame.offset + 2;
+    uint8_t len = frame.length - 4 - frame.trailer;
+    if(csv) append_csv(result.out[id], frame.offset, id, payload, len, result.short_frames);
+    else append_bin(result.out[id], id, payload, len, result.short_frames);
+  }
+}
+
+//----------------------------------------------------------------
+static FILE* open_output(const std::string& dir, uint8_t id, bool csv) {
+  std::string path = dir + "/" + message_name(id) + (csv ? ".csv" : ".bin");
+  FILE* f = fopen(path.c_str(), "w");
+  if(f == NULL) { fprintf(stderr, "Could not create %s\n", path.c_str()); return NULL; }
+  if(!csv) return f;
+
+  const MessageLayout* layout = message_layout(id);
+  fprintf(f, "offset");
+  if(layout != NULL) for(int i=0;i<layout->n_fields;i++) fprintf(f, ",%s", layout->fields[i].name);
+  else fprintf(f, is_text_message(id) ? ",text" : ",payload");
+  fprintf(f, "\n");
+  return f;
+}
+
+int main(int argc, char *argv[]) {
+  if(argc < 2) { usage(); return 1; }
+
+  std::string out_dir;
+  bool csv = true;
+  int threads = std::thread::hardware_concurrency();
+  double chunk_mb = 64;
+  for(int i=2;i<argc;i++) {
+    if(strcmp(argv[i], "--out") == 0 && i+1 < argc) out_dir = argv[++i];
+    else if(strcmp(argv[i], "--format") == 0 && i+1 < argc) {
+      std::string format = argv[++i];
+      if(format == "bin") csv = false;
+      else if(format != "csv") { usage(); return 1; }
+    }
+    else if(strcmp(argv[i], "--threads") == 0 && i+1 < argc) threads = atoi(argv[++i]);
+    else if(strcmp(argv[i], "--chunk") == 0 && i+1 < argc) chunk_mb = atof(argv[++i]);
+    else { usage(); return 1; }
+  }
+  if(threads < 1) threads = 1;
+  if(chunk_mb < 0.001) chunk_mb = 0.001;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  int fd = open(argv[1], O_RDONLY);
+  struct stat st;
+  if(fd < 0 || fstat(fd, &st) != 0) { fprintf(stderr, "Could not open %s\n", argv[1]); return 1; }
+  if(st.st_size == 0) { fprintf(stderr, "%s is empty\n", argv[1]); return 1; }
+  const char* data = (const char*) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(data == MAP_FAILED) { fprintf(stderr, "Could not map %s\n", argv[1]); return 1; }
+  madvise((void*) data, st.st_size, MADV_SEQUENTIAL);
+
+  if(!out_dir.empty()) mkdir(out_dir.c_str(), 0755);
+
+  Decoder decoder;
+  decoder.data = data;
+  decoder.size = st.st_size;
+  decoder.chunk_size = chunk_mb * 1024 * 1024;
+  decoder.n_chunks = (decoder.size + decoder.chunk_size - 1) / decoder.chunk_size;
+  decoder.write = !out_dir.empty();
+  decoder.csv = csv;
+
+  //Workers take chunks in order. The main thread writes finished chunks in order,
+  //at most 2 chunks per worker are held in memory
+  size_t max_pending = 2 * threads;
+  std::vector<std::unique_ptr<ChunkResult>> results(decoder.n_chunks);
+  std::atomic<size_t> next_chunk(0);
+  size_t written = 0;
+  std::mutex mutex;
+  std::condition_variable cv;
+
+  std::vector<std::thread> workers;
+  for(int t=0;t<threads;t++) {
+    workers.push_back(std::thread([&]() {
+      while(true) {
+        size_t chunk = next_chunk++;
+        if(chunk >= decoder.n_chunks) return;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait(lock, [&]{ return chunk < written + max_pending; });
+        }
+        std::unique_ptr<ChunkResult> result(new ChunkResult());
+        decoder.decode(chunk, *result);
+        std::lock_guard<std::mutex> lock(mutex);
+        results[chunk] = std::move(result);
+        cv.notify_all();
+      }
+    }));
+  }
+
+  FrameScanStats total;
+  memset(&total, 0, sizeof(total));
+  uint64_t short_frames = 0;
+  FILE* files[256] = {NULL};
+  bool write_failed = false;
+
+  for(size_t chunk=0;chunk<decoder.n_chunks;chunk++) {
+    std::unique_ptr<ChunkResult> result;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&]{ return results[chunk] != NULL; });
+      result = std::move(results[chunk]);
+    }
+
+    total.frames += result->stats.frames;
+    total.crc_frames += result->stats.crc_frames;
+    total.checksum_errors += result->stats.checksum_errors;
+    total.frame_bytes += result->stats.frame_bytes;
+    for(int id=0;id<256;id++) total.per_id[id] += result->stats.per_id[id];
+    short_frames += result->short_frames;
+
+    for(int id=0;id<256 && decoder.write;id++) {
+      std::string& out = result->out[id];
+      if(out.empty()) continue;
+      if(files[id] == NULL) files[id] = open_output(out_dir, id, csv);
+      if(files[id] == NULL || fwrite(out.data(), 1, out.size(), files[id]) != out.size()) write_failed = true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    written = chunk + 1;
+    cv.notify_all();
+  }
+
+  for(size_t t=0;t<workers.size();t++) workers[t].join();
+  for(int id=0;id<256;id++) if(files[id] != NULL && fclose(files[id]) != 0) write_failed = true;
+  munmap((void*) data, st.st_size);
+  close(fd);
+
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  //Statistics
+  printf("%-14s %12s\n", "message", "frames");
+  for(int id=0;id<256;id++) {
+    if(total.per_id[id] == 0) continue;
+    printf("%-14s %12llu\n", message_name(id).c_str(), (unsigned long long) total.per_id[id]);
+  }
+  printf("\n");
+  printf("input            %llu bytes\n", (unsigned long long) st.st_size);
+  printf("frames           %llu (%llu with CRC32C)\n", (unsigned long long) total.frames, (unsigned long long) total.crc_frames);
+  printf("checksum errors  %llu\n", (unsigned long long) total.checksum_errors);
+  printf("outside frames   %llu bytes\n", (unsigned long long) (st.st_size - total.frame_bytes));
+  if(short_frames > 0) printf("short frames     %llu (skipped)\n", (unsigned long long) short_frames);
+  printf("%.2f s, %.1f MB/s with %d threads\n", s, st.st_size / s / 1e6, threads);
+
+  if(write_failed) { fprintf(stderr, "Writing to %s failed\n", out_dir.c_str()); return 1; }
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*------------------------------------------------------------------------------------
+	Frame integrity benchmark, XOR checksum against CRC32C
+
+	crc_bench [--frames N] [--repeat R]
+
+	For a range of payload sizes, builds N frames with the XOR checksum and with
+	the CRC32C trailer and reports per frame the cost of framing them
+	(finish_frame) and of receiving them byte by byte through the parser
+	(inject), which is what the reader thread pays. The CRC32C itself is also
+	timed alone with the SSE4.2 instruction and with the software table.
+------------------------------------------------------------------------------------*/
+
+#include <captain_interface/CaptainInterFace/CaptainInterFace.h>
+#include <captain_interface/Crc32c/Crc32c.h>
+#include <captain_interface/scientistmsg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+typedef std::chrono::steady_clock Clock;
+
+static int frames = 1000;
+static int repeat = 200;
+static uint32_t received = 0;
+
+static void count_frame() {received++;}
+
+//Parser only, nothing is sent
+class BenchLink : public CaptainInterFace {
+protected:
+  bool send_data(char*, uint8_t) {return true;}
+};
+
+static double ns_per(Clock::time_point t0, long n) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+}
+
+//Encode and receive cost of one payload size in one mode
+static void run(BenchLink& link, bool crc, int size, double& encode_ns, double& receive_ns) {
+  std::vector<char> payload(size);
+  for(int i=0;i<size;i++) payload[i] = rand() & 0xFF;
+
+  char frame[255];
+  std::vector<char> stream;
+  Clock::time_point t0 = Clock::now();
+  volatile uint8_t sink = 0;
+  for(int r=0;r<repeat;r++) {
+    for(int i=0;i<frames;i++) {
+      frame[0] = '#';
+      frame[1] = CS_THRUSTER_PORT;
+      memcpy(frame + 2, payload.data(), size);
+      sink = sink + CaptainInterFace::finish_frame(frame, size + 2, crc);
+    }
+  }
+  encode_ns = ns_per(t0, (long) frames * repeat);
+
+  uint8_t len = CaptainInterFace::finish_frame(frame, size + 2, crc);
+  for(int i=0;i<frames;i++) stream.insert(stream.end(), frame, frame + len);
+
+  received = 0;
+  t0 = Clock::now();
+  for(int r=0;r<repeat;r++) link.inject(stream.data(), stream.size());
+  receive_ns = ns_per(t0, (long) frames * repeat);
+  if(received != (uint32_t) frames * repeat) printf("  (%s %d bytes: %u of %d frames parsed)\n", crc ? "crc32c" : "xor", size, received, frames * repeat);
+}
+
+int main(int argc, char *argv[]) {
+  for(int i=1;i<argc;i++) {
+    if(strcmp(argv[i], "--frames") == 0 && i+1 < argc) frames = atoi(argv[++i]);
+    else if(strcmp(argv[i], "--repeat") == 0 && i+1 < argc) repeat = atoi(argv[++i]);
+    else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+  }
+  if(frames <= 0 || repeat <= 0) { fprintf(stderr, "invalid arguments\n"); return 1; }
+
+  BenchLink xor_link, crc_link;
+  xor_link.setCallback(count_frame);
+  crc_link.setCallback(count_frame);
+
+  //Switch crc_link to CRC32C the way the captain does, with a hello reply
+  char hello[8] = {'#', LINK_HELLO, LINK_CAP_CRC32C};
+  crc_link.setCapabilities(LINK_CAP_CRC32C);
+  crc_link.inject(hello, CaptainInterFace::finish_frame(hello, 3, false));
+  if(!crc_link.crcMode()) { fprintf(stderr, "CRC32C mode not accepted\n"); return 1; }
+
+  printf("%d frames x %d, SSE4.2 crc32 %s\n", frames, repeat, crc32c_hw_available() ? "available" : "not available, table only");
+  printf("ns per frame       encode            receive      crc32c alone\n");
+  printf("payload  %10s %8s  %12s %8s  %9s %7s\n", "xor", "crc32c", "xor", "crc32c", "hw", "sw");
+  const int sizes[] = {8, 32, 64, 128, 240};
+  for(int size : sizes) {
+    double xor_encode, xor_receive, crc_encode, crc_receive;
+    run(xor_link, false, size, xor_encode, xor_receive);
+    run(crc_link, true, size, crc_encode, crc_receive);
+
+    //Checksum alone over '#', ID and payload
+    std::vector<char> data(size + 2, 0x5A);
+    volatile uint32_t sink = 0;
+    Clock::time_point t0 = Clock::now();
+    for(int i=0;i<frames*repeat;i++) sink = sink + crc32c(data.data(), data.size());
+    double hw = ns_per(t0, (long) frames * repeat);
+    t0 = Clock::now();
+    for(int i=0;i<frames*repeat;i++) sink = sink + crc32c_sw(data.data(), data.size());
+    double sw = ns_per(t0, (long) frames * repeat);
+
+    printf("%7d  %10.1f %8.1f  %12.1f %8.1f  %9.1f %7.1f\n", size, xor_encode, crc_encode, xor_receive, crc_receive, hw, sw);
+  }
+  return 0;
+}
@@ -5,16 +5,75 @@
 #include <boost/thread/thread.hpp>
 #include "captain_interface/RosInterFace/RosInterFace.h"
 #include "captain_interface/UDPInterface/UDPInterface.h"
+#include "captain_interface/SerialInterface/SerialInterface.h"
+#include "captain_interface/RedundantInterface/RedundantInterface.h"
+#include "captain_interface/LinkTuning/LinkTuning.h"
 #include <stdint.h>
+#include <signal.h>
+#include <time.h>
 
 #define PORT 8888
 
-UDPInterface captain;
+UDPInterface udp_captain;
+SerialInterface serial_captain;
+RedundantInterface redundant_captain;
+CaptainInterFace* captain = &udp_captain;
 RosInterFace rosInterface;
 
 //TODO use boost::bind to skip this step
 void callback_captain() { rosInterface.captain_callback(); };
 
+//Write the trace rings to <dir>/captain_trace_<time>.json
+void dump_trace(const std::string& dir) {
+  char stamp[32];
+  time_t now = time(NULL);
+  strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+  std::string path = dir + "/captain_trace_" + stamp + ".json";
+  if(trace_dump(path)) ROS_INFO("Trace written to %s", path.c_str());
+  else ROS_ERROR("Could not write trace to %s", path.c_str());
+}
+
+//Lines of the asynchronous log, called on its flusher thread
+void ros_log_sink(LogLevel level, const char* text) {
+  if(level == LOG_LEVEL_ERROR) ROS_ERROR("%s", text);
+  else if(level == LOG_LEVEL_WARN) ROS_WARN("%s", text);
+  else ROS_INFO("%s", text);
+}
+
+//Socket options and scheduling of the link I/O threads. ~link_profile picks a preset,
+//the other ~link_* parameters override single settings of it
+void apply_link_profile() {
+  std::string name;
+  ros::param::param<std::string>("~link_profile", name, "default");
+  bool known;
+  LinkProfile profile = LinkProfile::preset(name, &known);
+  if(!known) ROS_WARN("Unknown link_profile %s, using default", name.c_str());
+
+  ros::param::param<int>("~link_rcvbuf", profile.rcvbuf, profile.rcvbuf);
+  ros::param::param<int>("~link_sndbuf", profile.sndbuf, profile.sndbuf);
+  ros::param::param<int>("~link_busy_poll", profile.busy_poll_us, profile.busy_poll_us);
+  ros::param::param<int>("~link_dscp", profile.dscp, profile.dscp);
+  ros::param::param<int>("~link_socket_priority", profile.socket_priority, profile.socket_priority);
+  ros::param::param<bool>("~link_rx_timestamps", profile.rx_timestamps, profile.rx_timestamps);
+  ros::param::param<int>("~link_thread_priority", profile.thread_priority, profile.thread_priority);
+  ros::param::param<int>("~link_thread_cpu", profile.thread_cpu, profile.thread_cpu);
+  ros::param::param<bool>("~link_mlockall", profile.lock_memory, profile.lock_memory);
+
+  //What the kernel accepted, not what was asked for
+  std::vector<std::string> report;
+  captain->applyLinkProfile(profile, report);
+  if(rosInterface.tx_scheduler != NULL) report.push_back(tune_thread(rosInterface.tx_scheduler->thread(), "tx scheduler", profile));
+  if(rosInterface.rx_dispatcher != NULL && rosInterface.rx_dispatcher->running()) {
+    for(int l=0;l<RX_N_LANES;l++) {
+      std::string lane = std::string("rx ") + RxDispatcher::laneName((RxLane) l) + " lane";
+      report.push_back(tune_thread(rosInterface.rx_dispatcher->thread((RxLane) l), lane, profile));
+    }
+  }
+  report.push_back(tune_memory(profile));
+  ROS_INFO("Link profile %s:", name.c_str());
+  for(size_t i=0;i<report.size();i++) ROS_INFO("  %s", report[i].c_str());
+}
+
 #include <iostream>
 #include <boost/asio.hpp>
 
@@ -27,38 +86,118 @@ using std::endl;
 
 int main(int argc, char *argv[]) {
 
-  printf("main::ros init\n");
+  CLOG_INFO("main::ros init");
 
   ros::init(argc,argv, "CaptainInterface");
 
+  //Messages from the I/O threads are queued and written to rosconsole by the log thread
+  int log_rate_limit;
+  ros::param::param<int>("~log_rate_limit", log_rate_limit, 10);   // per call site and second, 0 = unlimited
+  log_set_rate_limit(log_rate_limit);
+  log_set_sink(ros_log_sink);
+  log_start();
+
+  //Transport to the captain: "udp", "serial" or "redundant" (two udp paths)
+  std::string transport;
+  ros::param::param<std::string>("~transport", transport, "udp");
+  if(transport == "serial") captain = &serial_captain;
+  else if(transport == "redundant") {
+    captain = &redundant_captain;
+    rosInterface.redundant_link = &redundant_captain;
+  }
+  else if(transport != "udp") ROS_WARN("Unknown transport %s, using udp", transport.c_str());
+
   //Init subscribers and publishers
   ros::NodeHandle n;
-  rosInterface.init(&n, &captain);
+  rosInterface.init(&n, captain);
 
   //Set callback
-  captain.setCallback(callback_captain);
+  captain->setCallback(callback_captain);
+
+  //Decode synthetic telemetry and fail if it allocates. No connection to the captain is made
+  bool alloc_check = false;
+  ros::param::param<bool>("~alloc_check", alloc_check, false);
+  if(alloc_check) {
+    bool passed = rosInterface.run_alloc_check();
+    rosInterface.stop_spinners();
+    log_stop();
+    return passed ? 0 : 1;
+  }
+
+  //Decode on the receive lanes from here on. The allocation check above runs inline
+  rosInterface.start_rx_lanes();
+
+  //Offer CRC32C integrity to the captain. Used only if the captain accepts it in the hello reply
+  bool use_crc32c = false;
+  ros::param::param<bool>("~crc32c", use_crc32c, false);
+  if(use_crc32c) captain->setCapabilities(LINK_CAP_CRC32C);
 
   //parameters
   int lolo_port = 8888;
   std::string lolo_ip_str;
 
   ros::param::param<std::string>("~captain_ip", lolo_ip_str, "192.168.1.90");
+  ros::param::param<int>("~captain_port", lolo_port, PORT); //e.g. captain_standin.py on the same machine
   ip::address lolo_ip = ip::address::from_string(lolo_ip_str);
 
-  ROS_INFO("Captain ip address: %s", lolo_ip_str.c_str());
+  std::string serial_device;
+  int serial_baud;
+  ros::param::param<std::string>("~serial_device", serial_device, "/dev/ttyUSB0");
+  ros::param::param<int>("~serial_baud", serial_baud, 921600);
+
+  //Second path for the redundant transport, e.g. the captain's address on the tether
+  std::string lolo_ip_2_str;
+  int local_port_2;
+  ros::param::param<std::string>("~captain_ip_2", lolo_ip_2_str, "");
+  ros::param::param<int>("~local_port_2", local_port_2, 8887);
 
   //Create udp socket
   boost::asio::io_service io_service;
   udp::endpoint receiver_endpoint;
   receiver_endpoint.address(lolo_ip);
   receiver_endpoint.port(lolo_port);
+  udp::socket socket(io_service);
+
+  if(captain == &serial_captain) {
+    ROS_INFO("Captain serial device: %s at %d baud", serial_device.c_str(), serial_baud);
+    if(!serial_captain.setup(serial_device, serial_baud)) {
+      ROS_FATAL("Could not open %s", serial_device.c_str());
+      log_stop();
+      return 1;
+    }
+  }
+  else if(captain == &redundant_captain) {
+    if(!redundant_captain.addPath(8888, lolo_ip_str, lolo_port)) {
+      ROS_FATAL("Could not open path to %s", lolo_ip_str.c_str());
+      log_stop();
+      return 1;
+    }
+    if(lolo_ip_2_str.empty() || !redundant_captain.addPath(local_port_2, lolo_ip_2_str, lolo_port)) {
+      ROS_FATAL("Redundant transport needs a second path, check captain_ip_2 and local_port_2");
+      log_stop();
+      return 1;
+    }
+    for(int p=0;p<redundant_captain.pathCount();p++) ROS_INFO("Captain path %d: %s", p, redundant_captain.pathName(p).c_str());
+    redundant_captain.start();
+  }
+  else {
+    ROS_INFO("Captain ip address: %s", lolo_ip_str.c_str());
+    socket.open(udp::v4());
+    socket.bind(udp::endpoint(udp::v4(), 8888));
+    udp_captain.setup(&socket, &receiver_endpoint);
+  }
+  apply_link_profile();
 
-  udp::socket socket(io_service, udp::endpoint(udp::v4(), 8888));
-  captain.setup(&socket, &receiver_endpoint);
-  
   //Send something to the captain so it can get the ip of the scientist computer
-  captain.new_package(0);
-  captain.send_package();
+  captain->send_hello();
+
+#ifdef CAPTAIN_TRACING
+  //kill -USR1 <pid> dumps the most recent trace spans
+  std::string trace_dir;
+  ros::param::param<std::string>("~trace_dir", trace_dir, "/tmp");
+  trace_install_signal(SIGUSR1);
+  ROS_INFO("Tracing enabled, send SIGUSR1 to write a trace to %s", trace_dir.c_str());
+#endif
   
   int i=0;
   ros::Rate loop_rate(1000);
@@ -66,17 +205,23 @@ int main(int argc, char *argv[]) {
     ros::spinOnce();
     loop_rate.sleep();
     //captain.loop(); //send heartbeat to lolo?
+#ifdef CAPTAIN_TRACING
+    if(trace_dump_requested()) dump_trace(trace_dir);
+#endif
 
     if(i > 1000) {
       //Send something to the captain so it can get the ip of the scientist computer
-      captain.new_package(0);
-      captain.send_package();
+      captain->send_hello();
       i=0;
     }
     i++;
   }
 
-  captain.stop();
+  rosInterface.stop_spinners();
+  udp_captain.stop();
+  serial_captain.stop();
+  redundant_captain.stop();
+  log_stop();
   //Clear UDP socket
  return 0;
 }
@@ -0,0 +1,112 @@
+/*------------------------------------------------------------------------------------
+	Receive lane latency benchmark
+
+	rx_lane_bench [--seconds S] [--rate HZ] [--burst N] [--interval S] [--log-cost US]
+
+	Feeds thruster feedback frames at RATE and, in the burst runs, N console frames
+	every INTERVAL seconds whose handler blocks for LOG_COST microseconds (a slow
+	printf or publisher). Reports the feedback latency from arrival to handler for
+	decoding on the reader thread (inline) and on the receive lanes.
+------------------------------------------------------------------------------------*/
+
+#include <captain_interface/RxDispatcher/RxDispatcher.h>
+#include <captain_interface/scientistmsg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds = 3;
+static double rate = 500;          // Hz, feedback frames
+static int burst = 200;            // console frames per burst
+static double interval = 0.5;      // s between bursts
+static int log_cost_us = 200;
+
+static Clock::time_point t0;
+static std::vector<double> latencies_us;
+
+static uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+}
+
+//Payload starts with the scheduled arrival time, so inline and lanes are measured the same way
+static void handler(RxFrame& frame) {
+  uint64_t scheduled = frame.parse_llong();
+  if(RxDispatcher::classify(frame.msgID) == RX_FEEDBACK) {
+    latencies_us.push_back((now_ns() - scheduled) * 1e-3);
+    for(int i=0;i<6;i++) frame.parse_float();
+  }
+  else std::this_thread::sleep_for(std::chrono::microseconds(log_cost_us));
+}
+
+static void run(const char* name, bool lanes, bool bursts) {
+  latencies_us.clear();
+  latencies_us.reserve(seconds * rate + 16);
+  RxDispatcher dispatcher(handler);
+  dispatcher.configure(RX_LOG, 4 * burst, false);
+  if(lanes) dispatcher.start();
+  RxFrame frame;
+
+  t0 = Clock::now();
+  uint64_t end_ns = seconds * 1e9;
+  uint64_t feedback_ns = 1e9 / rate;
+  uint64_t burst_ns = interval * 1e9;
+  uint64_t next_feedback = 0, next_burst = burst_ns / 2;
+  uint32_t sequence = 0;
+
+  while(next_feedback < end_ns) {
+    bool is_burst = bursts && next_burst < next_feedback;
+    uint64_t scheduled = is_burst ? next_burst : next_feedback;
+    while(now_ns() < scheduled) std::this_thread::sleep_for(std::chrono::microseconds(50));
+
+    char payload[64];
+    uint32_t msb = scheduled >> 32, lsb = scheduled;
+    memcpy(payload, &msb, 4);
+    memcpy(payload + 4, &lsb, 4);
+    int n = is_burst ? burst : 1;
+    uint8_t id = is_burst ? CS_MENUSTREAM : CS_THRUSTER_PORT;
+    if(is_burst) next_burst += burst_ns;
+    else { memcpy(payload + 8, &sequence, 4); sequence++; next_feedback += feedback_ns; }
+
+    for(int i=0;i<n;i++) {
+      if(lanes) dispatcher.dispatch(id, payload, 36);
+      else { frame.set(id, payload, 36); handler(frame); }
+    }
+  }
+  if(lanes) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));  //let the feedback lane finish
+    dispatcher.stop();
+  }
+
+  std::vector<double>& l = latencies_us;
+  std::sort(l.begin(), l.end());
+  if(l.empty()) return;
+  RxLaneStats log = dispatcher.stats(RX_LOG);
+  printf("%-8s %-9s %7zu  p50 %8.1f  p99 %8.1f  max %8.1f us", name, bursts ? "bursts" : "quiet",
+         l.size(), l[l.size() / 2], l[l.size() * 99 / 100], l.back());
+  if(lanes && bursts) printf("  (log dropped %u)", log.dropped);
+  printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+  for(int i=1;i<argc;i++) {
+    if(strcmp(argv[i], "--seconds") == 0 && i+1 < argc) seconds = atof(argv[++i]);
+    else if(strcmp(argv[i], "--rate") == 0 && i+1 < argc) rate = atof(argv[++i]);
+    else if(strcmp(argv[i], "--burst") == 0 && i+1 < argc) burst = atoi(argv[++i]);
+    else if(strcmp(argv[i], "--interval") == 0 && i+1 < argc) interval = atof(argv[++i]);
+    else if(strcmp(argv[i], "--log-cost") == 0 && i+1 < argc) log_cost_us = atoi(argv[++i]);
+    else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+  }
+  if(rate <= 0 || seconds <= 0 || interval <= 0 || burst < 0) { fprintf(stderr, "invalid arguments\n"); return 1; }
+
+  printf("feedback %.0f Hz, bursts of %d console frames every %.2f s, %d us each\n", rate, burst, interval, log_cost_us);
+  printf("decoding            frames  feedback latency\n");
+  run("inline", false, false);
+  run("inline", false, true);
+  run("lanes", true, false);
+  run("lanes", true, true);
+  return 0;
+}
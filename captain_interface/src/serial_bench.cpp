@@ -0,0 +1,78 @@
+/*------------------------------------------------------------------------------------
+	Serial transport throughput benchmark
+
+	serial_bench [DEVICE_A DEVICE_B] [--frames N] [--payload BYTES] [--baud BAUD]
+
+	Sends N frames from A to B through SerialInterface and reports the decoded
+	frame rate against the line rate of BAUD (default 921600, 10 bits per byte).
+	Without devices an internal PTY pair is used. For a socat pair:
+	  socat -d -d pty,raw,echo=0 pty,raw,echo=0
+------------------------------------------------------------------------------------*/
+
+#include <captain_interface/SerialInterface/SerialInterface.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pty.h>
+#include <chrono>
+#include <thread>
+#include <atomic>
+
+typedef std::chrono::steady_clock Clock;
+
+SerialInterface tx;
+SerialInterface rx;
+std::atomic<uint32_t> received(0);
+
+void callback_rx() { received++; };
+
+int main(int argc, char *argv[]) {
+  std::string device_a, device_b;
+  int frames = 100000;
+  int payload = 36;         // thruster feedback frame
+  unsigned baud = 921600;
+  for(int i=1;i<argc;i++) {
+    if(strcmp(argv[i], "--frames") == 0 && i+1 < argc) frames = atoi(argv[++i]);
+    else if(strcmp(argv[i], "--payload") == 0 && i+1 < argc) payload = atoi(argv[++i]);
+    else if(strcmp(argv[i], "--baud") == 0 && i+1 < argc) baud = atoi(argv[++i]);
+    else if(device_a.empty()) device_a = argv[i];
+    else device_b = argv[i];
+  }
+  if(payload < 1 || payload > 240) { fprintf(stderr, "payload must be 1-240 bytes\n"); return 1; }
+
+  rx.setCallback(callback_rx);
+  bool ok;
+  if(device_b.empty()) {
+    int master, slave;
+    if(openpty(&master, &slave, NULL, NULL, NULL) != 0) { perror("openpty"); return 1; }
+    ok = tx.attach(master, baud) && rx.attach(slave, baud);
+  }
+  else ok = tx.setup(device_a, baud) && rx.setup(device_b, baud);
+  if(!ok) return 1;
+
+  char data[240];
+  for(int i=0;i<payload;i++) data[i] = i;
+  int frame_bytes = payload + 5;
+
+  //Keep at most ~64 frames in flight so the PTY buffer does not overflow
+  Clock::time_point start = Clock::now();
+  for(int i=0;i<frames;i++) {
+    while(i - (int) received > 64) std::this_thread::yield();
+    tx.send_payload(13, data, payload);
+  }
+  Clock::time_point deadline = Clock::now() + std::chrono::seconds(2);
+  while((int) received < frames && Clock::now() < deadline) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  double line_rate = baud / 10.0; // bytes/s with start and stop bits
+  double byte_rate = received * (double) frame_bytes / seconds;
+  printf("frames %u/%d, %d bytes each, %.3f s\n", (uint32_t) received, frames, frame_bytes, seconds);
+  printf("%.0f frames/s, %.0f bytes/s, %.1fx the %u baud line rate (%.0f frames/s)\n",
+    received / seconds, byte_rate, byte_rate / line_rate, baud, line_rate / frame_bytes);
+  printf("checksum errors %u, write overflows %u\n", (uint32_t) rx.counters.checksum_errors, tx.overflows());
+
+  tx.stop();
+  rx.stop();
+  return (int) received == frames ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+/*------------------------------------------------------------------------------------
+	Shared memory telemetry fan-out benchmark
+
+	shm_fanout_bench [--seconds S] [--rate HZ] [--max-readers N]
+
+	Writes thruster feedback frames at RATE into a SharedTelemetry region and
+	reads them back from 1, 2, 4, ... MAX_READERS reader processes that poll the
+	ring. Reports the writer cost per frame, which should not grow with the
+	number of readers, the latency from write to read in the slowest reader and
+	the frames the readers lost to the writer lapping them.
+------------------------------------------------------------------------------------*/
+
+#include <captain_interface/SharedTelemetry/SharedTelemetry.h>
+#include <captain_interface/scientistmsg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+
+#define STOP_ID 0xFF
+
+static double seconds = 2;
+static double rate = 1000;        // Hz
+static int max_readers = 16;
+
+//Filled in by every reader process
+struct ReaderResult {
+  std::atomic<int> ready;
+  uint64_t frames;
+  uint64_t lost;
+  double p50_us, p99_us, max_us;
+};
+
+static uint64_t realtime_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t monotonic_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void reader(const std::string& name, ReaderResult& result) {
+  SharedTelemetryReader shm;
+  if(!shm.open(name)) { fprintf(stderr, "reader: cannot open %s\n", name.c_str()); _exit(1); }
+  std::vector<double> latencies_us;
+  latencies_us.reserve(seconds * rate + 16);
+
+  uint64_t cursor = shm.head();
+  uint64_t lost = 0;
+  TelemetryFrame frame;
+  result.ready++;
+  while(true) {
+    if(!shm.next(cursor, frame, &lost)) { sched_yield(); continue; }
+    if(frame.msgID == STOP_ID) break;
+    latencies_us.push_back((realtime_ns() - frame.rx_time_ns) * 1e-3);
+  }
+
+  std::vector<double>& l = latencies_us;
+  std::sort(l.begin(), l.end());
+  result.frames = l.size();
+  result.lost = lost;
+  if(!l.empty()) {
+    result.p50_us = l[l.size() / 2];
+    result.p99_us = l[l.size() * 99 / 100];
+    result.max_us = l.back();
+  }
+  _exit(0);
+}
+
+static bool run(int readers) {
+  char name[64];
+  snprintf(name, sizeof(name), "/shm_fanout_bench_%d", (int) getpid());
+  SharedTelemetryWriter shm;
+  if(!shm.open(name)) return false;
+
+  void* mem = mmap(NULL, readers * sizeof(ReaderResult), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if(mem == MAP_FAILED) { perror("mmap"); return false; }
+  ReaderResult* results = (ReaderResult*) mem;
+  for(int i=0;i<readers;i++) new (&results[i]) ReaderResult();
+
+  std::vector<pid_t> pids;
+  for(int i=0;i<readers;i++) {
+    pid_t pid = fork();
+    if(pid == 0) reader(name, results[i]);
+    if(pid < 0) { perror("fork"); break; }
+    pids.push_back(pid);
+  }
+  for(int i=0;i<(int) pids.size();i++) while(results[i].ready == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  //Writer at a fixed rate, timing write() alone
+  std::vector<double> write_ns;
+  write_ns.reserve(seconds * rate + 16);
+  char payload[32];
+  memset(payload, 0, sizeof(payload));
+  uint64_t period_ns = 1e9 / rate;
+  uint64_t start = monotonic_ns(), next = start, end = start + seconds * 1e9;
+  for(uint32_t sequence = 0; next < end; sequence++, next += period_ns) {
+    while(monotonic_ns() < next) std::this_thread::sleep_for(std::chrono::microseconds(20));
+    memcpy(payload + 8, &sequence, 4);
+    uint64_t t0 = monotonic_ns();
+    shm.write(CS_THRUSTER_PORT, payload, sizeof(payload));
+    write_ns.push_back(monotonic_ns() - t0);
+  }
+  shm.write(STOP_ID, payload, 0);
+  for(pid_t pid : pids) waitpid(pid, NULL, 0);
+  shm.close();
+
+  std::vector<double>& w = write_ns;
+  std::sort(w.begin(), w.end());
+  double p50 = 0, p99 = 0, worst = 0;
+  uint64_t frames = UINT64_MAX, lost = 0;
+  for(int i=0;i<(int) pids.size();i++) {
+    p50 = std::max(p50, results[i].p50_us);
+    p99 = std::max(p99, results[i].p99_us);
+    worst = std::max(worst, results[i].max_us);
+    frames = std::min(frames, results[i].frames);
+    lost += results[i].lost;
+  }
+  printf("%7d  %8.0f %8.0f %8.0f ns  %8.1f %8.1f %8.1f us  %7lu/%zu  %lu\n", readers,
+         w[w.size() / 2], w[w.size() * 99 / 100], w.back(), p50, p99, worst,
+         (unsigned long) frames, w.size(), (unsigned long) lost);
+  munmap(mem, readers * sizeof(ReaderResult));
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  for(int i=1;i<argc;i++) {
+    if(strcmp(argv[i], "--seconds") == 0 && i+1 < argc) seconds = atof(argv[++i]);
+    else if(strcmp(argv[i], "--rate") == 0 && i+1 < argc) rate = atof(argv[++i]);
+    else if(strcmp(argv[i], "--max-readers") == 0 && i+1 < argc) max_readers = atoi(argv[++i]);
+    else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+  }
+  if(rate <= 0 || seconds <= 0 || max_readers < 1) { fprintf(stderr, "invalid arguments\n"); return 1; }
+
+  printf("%.0f Hz for %.1f s, readers poll the ring\n", rate, seconds);
+  printf("readers  write p50      p99      max      read p50      p99      max      frames  lost\n");
+  for(int readers = 1; readers <= max_readers; readers *= 2) {
+    if(!run(readers)) { fprintf(stderr, "cannot create shared memory\n"); return 1; }
+  }
+  return 0;
+}
@@ -0,0 +1,104 @@
+/*------------------------------------------------------------------------------------
+	Query tool for recordings made with ~telemetry_store. Does not need ROS.
+
+	telemetry_query DIR                       list recorded messages
+	telemetry_query DIR MESSAGE.FIELD [opts]  statistics of one column
+	  --from S     start, seconds after the first sample of MESSAGE
+	  --to S       end, seconds after the first sample of MESSAGE
+	  --bucket S   min / mean / max per S seconds
+	  --dump       print every sample
+------------------------------------------------------------------------------------*/
+
+#include <captain_interface/TelemetryStore/TelemetryStore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+#include <string>
+
+static void usage() {
+  fprintf(stderr, "usage: telemetry_query DIR [MESSAGE.FIELD [--from S] [--to S] [--bucket S] [--dump]]\n");
+}
+
+static void list(const TelemetryStoreReader& reader) {
+  int n_layouts;
+  const MessageLayout* layouts = message_layouts(n_layouts);
+  for(int s=0;s<n_layouts;s++) {
+    const TelemetryTable* t = reader.table(layouts[s].msgID);
+    if(t == NULL) continue;
+    double duration = (t->timestamp(t->rows-1) - t->timestamp(0)) * 1e-6;
+    printf("%-14s %10llu rows %9.1f s  ", t->layout->name, (unsigned long long) t->rows, duration);
+    for(int i=2;i<t->layout->n_fields;i++) printf(" %s", t->layout->fields[i].name);
+    printf("\n");
+  }
+}
+
+static void print_stats(const char* label, uint64_t count, const TelemetryFieldStats& s) {
+  if(count == 0) { printf("%s count 0\n", label); return; }
+  printf("%s count %llu min %.6g mean %.6g max %.6g\n", label, (unsigned long long) count, s.min, s.sum / count, s.max);
+}
+
+int main(int argc, char *argv[]) {
+  if(argc < 2) { usage(); return 1; }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  TelemetryStoreReader reader;
+  if(!reader.open(argv[1])) { fprintf(stderr, "No recording in %s\n", argv[1]); return 1; }
+  if(argc == 2) { list(reader); return 0; }
+
+  //MESSAGE.FIELD
+  std::string column = argv[2];
+  size_t dot = column.find('.');
+  if(dot == std::string::npos) { usage(); return 1; }
+  std::string message = column.substr(0, dot);
+  const TelemetryTable* t = reader.table(message.c_str());
+  if(t == NULL) { fprintf(stderr, "%s not recorded\n", message.c_str()); return 1; }
+  int f = t->field(column.substr(dot+1).c_str());
+  if(f < 0) { fprintf(stderr, "Unknown field %s\n", column.c_str()); return 1; }
+
+  double from = 0, to = -1, bucket = 0;
+  bool dump = false;
+  for(int i=3;i<argc;i++) {
+    if(strcmp(argv[i], "--from") == 0 && i+1 < argc) from = atof(argv[++i]);
+    else if(strcmp(argv[i], "--to") == 0 && i+1 < argc) to = atof(argv[++i]);
+    else if(strcmp(argv[i], "--bucket") == 0 && i+1 < argc) bucket = atof(argv[++i]);
+    else if(strcmp(argv[i], "--dump") == 0) dump = true;
+    else { usage(); return 1; }
+  }
+
+  //Time range to rows
+  uint64_t t0 = t->timestamp(0);
+  uint64_t begin = t->lower_bound(t0 + (uint64_t) (from * 1e6));
+  uint64_t end = to < 0 ? t->rows : t->lower_bound(t0 + (uint64_t) (to * 1e6));
+
+  if(dump) {
+    for(uint64_t row=begin;row<end;row++) printf("%.6f %.9g\n", (t->timestamp(row) - t0) * 1e-6, t->value(f, row));
+  }
+  else if(bucket > 0) {
+    uint64_t row = begin;
+    while(row < end) {
+      double b = (uint64_t) (((t->timestamp(row) - t0) * 1e-6) / bucket) * bucket;
+      uint64_t next = std::min(end, t->lower_bound(t0 + (uint64_t) ((b + bucket) * 1e6)));
+      if(next <= row) next = row + 1; //Timestamp went backwards
+      uint64_t count;
+      TelemetryFieldStats stats;
+      t->aggregate(f, row, next, count, stats);
+      char label[32];
+      snprintf(label, sizeof(label), "%10.1f", b);
+      print_stats(label, count, stats);
+      row = next;
+    }
+  }
+  else {
+    uint64_t count;
+    TelemetryFieldStats stats;
+    t->aggregate(f, begin, end, count, stats);
+    print_stats(column.c_str(), count, stats);
+  }
+
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "%.2f ms\n", ms);
+  return 0;
+}
@@ -0,0 +1,74 @@
+/*------------------------------------------------------------------------------------
+	Transmit scheduler check: an abort survives a full safety queue
+
+	tx_scheduler_check
+
+	Stalls the link with one heartbeat in flight, then queues SC_ABORT followed
+	by more safety frames than the safety queue holds, with the default
+	configuration. Releases the link and checks that the abort is sent once,
+	before any other queued frame. Exits with 1 if it is not.
+------------------------------------------------------------------------------------*/
+
+#include <captain_interface/TxScheduler/TxScheduler.h>
+#include <captain_interface/CaptainInterFace/CaptainInterFace.h>
+#include <captain_interface/scientistmsg.h>
+#include <stdio.h>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+static std::mutex mutex;
+static std::condition_variable cv;
+static bool stalled = true;
+static bool in_flight = false;
+static std::vector<uint8_t> sent;
+
+static bool send(char* frame, uint8_t) {
+  std::unique_lock<std::mutex> lock(mutex);
+  in_flight = true;
+  cv.notify_all();
+  cv.wait(lock, [] { return !stalled; });
+  sent.push_back((uint8_t) frame[1]);
+  return true;
+}
+
+static void enqueue(TxScheduler& scheduler, uint8_t msgID) {
+  char frame[8] = {'#', (char) msgID};
+  scheduler.enqueue(frame, CaptainInterFace::finish_frame(frame, 2, false));
+}
+
+int main() {
+  TxScheduler scheduler(send);
+  scheduler.start();
+
+  //One heartbeat in flight on a stalled link
+  enqueue(scheduler, SC_HEARTBEAT);
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [] { return in_flight; });
+  }
+
+  enqueue(scheduler, SC_ABORT);
+  for(int i=0;i<16;i++) {
+    enqueue(scheduler, SC_HEARTBEAT);
+    enqueue(scheduler, SC_DONE);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stalled = false;
+  }
+  cv.notify_all();
+  while(scheduler.stats(TX_SAFETY).depth > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  scheduler.stop();
+
+  int aborts = 0;
+  for(size_t i=0;i<sent.size();i++) aborts += sent[i] == SC_ABORT;
+  bool first = sent.size() >= 2 && sent[1] == SC_ABORT;
+  printf("%zu frames sent, %d aborts, abort %s\n", sent.size(), aborts, first ? "sent first" : "not sent first");
+  bool ok = aborts == 1 && first;
+  printf("%s\n", ok ? "passed" : "FAILED");
+  return ok ? 0 : 1;
+}
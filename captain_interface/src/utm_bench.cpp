@@ -0,0 +1,94 @@
+/*------------------------------------------------------------------------------------
+	UTM -> lat/lon benchmark, in-process conversion against the service path
+
+	rosrun captain_interface utm_bench [_points:=N] [_calls:=N] [_service:=NAME]
+
+	Converts N points around the middle of the zone with UTMConverter, one at a
+	time and as a batch, and reports the time per point. Then times CALLS round
+	trips of the UTMToLatLon service (default /lolo/dr/utm_to_lat_lon, started by
+	tf_lat_lon in lolo_core.launch) with the same points and reports the largest
+	difference between the two. The service part is skipped if it is not running.
+------------------------------------------------------------------------------------*/
+
+#include "ros/ros.h"
+#include <captain_interface/Geodesy/Geodesy.h>
+#include <smarc_msgs/UTMToLatLon.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsed_us(Clock::time_point t0) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+}
+
+int main(int argc, char *argv[]) {
+  ros::init(argc, argv, "utm_bench");
+  ros::NodeHandle n;
+
+  int points, calls, utm_zone;
+  std::string service, utm_band;
+  ros::param::param<int>("~points", points, 100000);
+  ros::param::param<int>("~calls", calls, 200);
+  ros::param::param<std::string>("~service", service, "/lolo/dr/utm_to_lat_lon");
+  ros::param::param<int>("utm_zone", utm_zone, 34);
+  ros::param::param<std::string>("utm_band", utm_band, "V");
+  if(points <= 0 || calls < 0 || utm_band.empty()) { ROS_ERROR("invalid arguments"); return 1; }
+
+  UTMConverter utm(utm_zone, utm_band[0]);
+  std::vector<double> easting(points), northing(points), lat(points), lon(points);
+  for(int i=0;i<points;i++) {
+    easting[i] = 400000 + (i % 1000) * 200.0;   // within +-100 km of the central meridian
+    northing[i] = 6500000 + (i / 1000) * 50.0;
+  }
+
+  //In-process, single points and batch
+  Clock::time_point t0 = Clock::now();
+  for(int i=0;i<points;i++) utm.toLatLon(easting[i], northing[i], lat[i], lon[i]);
+  double single_us = elapsed_us(t0) / points;
+
+  t0 = Clock::now();
+  utm.toLatLon(easting.data(), northing.data(), lat.data(), lon.data(), points);
+  double batch_us = elapsed_us(t0) / points;
+
+  printf("zone %d%c, %d points\n", utm_zone, utm_band[0], points);
+  printf("in-process single  %10.3f us/point\n", single_us);
+  printf("in-process batch   %10.3f us/point\n", batch_us);
+
+  //Service round trips with the same points
+  ros::ServiceClient client = n.serviceClient<smarc_msgs::UTMToLatLon>(service);
+  if(calls == 0 || !client.waitForExistence(ros::Duration(2.0))) {
+    printf("service %s not available, skipped\n", service.c_str());
+    return 0;
+  }
+  std::vector<double> round_trip_us;
+  double max_diff_m = 0;
+  for(int c=0;c<calls && ros::ok();c++) {
+    int i = (int) ((long long) c * points / calls);
+    smarc_msgs::UTMToLatLon srv;
+    srv.request.utm_point.x = easting[i];
+    srv.request.utm_point.y = northing[i];
+    t0 = Clock::now();
+    if(!client.call(srv)) { ROS_ERROR("call to %s failed", service.c_str()); return 1; }
+    round_trip_us.push_back(elapsed_us(t0));
+
+    //Difference in meters, small angle approximation is fine at this scale
+    double dlat = (srv.response.lat_lon_point.latitude - lat[i]) * 111320.0;
+    double dlon = (srv.response.lat_lon_point.longitude - lon[i]) * 111320.0 * cos(lat[i] * M_PI / 180);
+    max_diff_m = std::max(max_diff_m, sqrt(dlat*dlat + dlon*dlon));
+  }
+  size_t m = round_trip_us.size();
+  if(m == 0) {
+    printf("service %s: no calls made, skipped\n", service.c_str());
+    return 0;
+  }
+  std::sort(round_trip_us.begin(), round_trip_us.end());
+  printf("service            %10.1f us/point p50, %.1f p99, %.1f max (%zu calls)\n",
+         round_trip_us[m / 2], round_trip_us[m * 99 / 100], round_trip_us.back(), m);
+  printf("speedup            %10.0fx single, %.0fx batch, largest difference %.3f m\n",
+         round_trip_us[m / 2] / single_us, round_trip_us[m / 2] / batch_us, max_diff_m);
+  return 0;
+}